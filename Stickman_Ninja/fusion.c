@@ -0,0 +1,44 @@
+/**
+ * IMU fusion for Stickman Ninja
+ *
+ */
+
+#include "mpu6050.h"
+#include "fusion.h"
+
+// Starts level at 0 degrees with the accel filter empty. alpha close to 1
+// trusts the gyro short term. The game uses zeropt999 and zeropt001, which
+// sum to 65535/65536 rather than one; that is how it has always been tuned
+void fusion_init(struct fusion *f, char lowpass_shift, fix15 alpha, fix15 beta) {
+    f->ax = 0 ;
+    f->ay = 0 ;
+    f->accel_angle = 0 ;
+    f->angle = 0 ;
+    f->lowpass_shift = lowpass_shift ;
+    f->alpha = alpha ;
+    f->beta = beta ;
+}
+
+// One sample, dt seconds after the previous one. The sword swings about
+// the sensor's Z axis, so the tilt comes from X and Y
+void fusion_update(struct fusion *f, const struct mpu6050_sample *s, fix15 dt) {
+    f->ax += (s->accel[0] - f->ax) >> f->lowpass_shift ;
+    f->ay += (s->accel[1] - f->ay) >> f->lowpass_shift ;
+
+    f->accel_angle = atan2fix15(-f->ax, -f->ay) ;
+    f->angle = multfix15(f->angle + multfix15(s->gyro[2], dt), f->alpha)
+             + multfix15(f->accel_angle, f->beta) ;
+}
+
+// n samples in order, evenly spaced dt apart (e.g. a FIFO drain)
+void fusion_update_batch(struct fusion *f, const struct mpu6050_sample *s, int n, fix15 dt) {
+    for (int i = 0; i < n; i++) {
+        fusion_update(f, &s[i], dt) ;
+    }
+}
+
+// Microseconds to fix15 seconds; 65536^2/10^6 ~= 4295. The product takes
+// 64 bits, so any unsigned int interval converts
+fix15 fusion_dt_usec(unsigned int usec) {
+    return (fix15) (((uint64_t) usec * 4295u) >> 16) ;
+}
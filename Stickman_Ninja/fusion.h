@@ -0,0 +1,22 @@
+/**
+ * IMU fusion for Stickman Ninja
+ *
+ * Turns a stream of mpu6050 samples into a sword angle: the accelerometer
+ * is low-passed and its tilt blended with the integrated gyro rate in a
+ * complementary filter. Everything is fix15. Include mpu6050.h first.
+ */
+
+struct fusion {
+    fix15 ax, ay ;              // low-passed accel X and Y, g's
+    fix15 accel_angle ;         // tilt from the accelerometer alone, degrees
+    fix15 angle ;               // fused angle, degrees
+    char lowpass_shift ;        // accel low-pass: ax += (raw - ax) >> shift
+    fix15 alpha ;               // gyro weight
+    fix15 beta ;                // accel tilt weight
+} ;
+
+// Sensor fusion - usable in main
+void fusion_init(struct fusion *f, char lowpass_shift, fix15 alpha, fix15 beta) ;
+void fusion_update(struct fusion *f, const struct mpu6050_sample *s, fix15 dt) ;
+void fusion_update_batch(struct fusion *f, const struct mpu6050_sample *s, int n, fix15 dt) ;
+fix15 fusion_dt_usec(unsigned int usec) ;
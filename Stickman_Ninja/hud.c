@@ -0,0 +1,76 @@
+/**
+ * Heads-up display widgets for Stickman Ninja
+ *
+ */
+
+#include "vga_graphics.h"
+#include "hud.h"
+
+// Health bar geometry: the fill is 202x10 with a 1 pixel margin, and each
+// point of health is a 2x8 segment inside it
+#define BAR_W      202
+#define BAR_H      10
+#define SEGMENT_W  2
+#define MAX_HEALTH 100
+
+// Format 0..999 as 1-3 left-aligned digits without division. The
+// reciprocal multiplies are exact over this range.
+int hud_format(short value, char digits[3]) {
+    if (value < 0) value = 0 ;
+    if (value > 999) value = 999 ;
+    int hundreds = (value * 41) >> 12 ;
+    int rest = value - hundreds * 100 ;
+    int tens = (rest * 205) >> 11 ;
+    int ones = rest - tens * 10 ;
+    int n = 1 + (value >= 10) + (value >= 100) ;
+    // Shift out the leading zeros
+    char all[3] = {'0' + hundreds, '0' + tens, '0' + ones} ;
+    for (int i=0; i<n; i++) digits[i] = all[3 - n + i] ;
+    return n ;
+}
+
+// Draw (or redraw after a screen clear) the whole widget
+void hud_health_init(struct hud_health *w, short bar_x, short bar_y, short text_x, short text_y, char color, short value) {
+    w->bar_x = bar_x ;
+    w->bar_y = bar_y ;
+    w->text_x = text_x ;
+    w->text_y = text_y ;
+    w->color = color ;
+
+    // Full border, bar and number, then let update take off what is missing
+    drawRect(bar_x - 2, bar_y - 2, BAR_W + 4, BAR_H + 4, color) ;
+    fillRect(bar_x, bar_y, BAR_W, BAR_H, color) ;
+    w->value = MAX_HEALTH ;
+    w->ndigits = hud_format(MAX_HEALTH, w->digits) ;
+    for (int i=0; i<w->ndigits; i++) {
+        drawChar(text_x + 6*i, text_y, w->digits[i], color, BLACK, 1) ;
+    }
+    hud_health_update(w, value) ;
+}
+
+void hud_health_update(struct hud_health *w, short value) {
+    if (value < 0) value = 0 ;
+    if (value > MAX_HEALTH) value = MAX_HEALTH ;
+    if (value == w->value) return ;
+
+    // Bar: clear the lost segments, or fill the regained ones
+    short lo = (value < w->value) ? value : w->value ;
+    short hi = (value < w->value) ? w->value : value ;
+    fillRect(w->bar_x + 1 + SEGMENT_W*lo, w->bar_y + 1, SEGMENT_W*(hi - lo), BAR_H - 2,
+             (value < w->value) ? BLACK : w->color) ;
+    w->value = value ;
+
+    // Number: redraw the characters that differ, blank the ones that went away
+    char digits[3] ;
+    int n = hud_format(value, digits) ;
+    for (int i=0; i<n; i++) {
+        if ((i >= w->ndigits) || (digits[i] != w->digits[i])) {
+            drawChar(w->text_x + 6*i, w->text_y, digits[i], w->color, BLACK, 1) ;
+        }
+        w->digits[i] = digits[i] ;
+    }
+    if (n < w->ndigits) {
+        fillRect(w->text_x + 6*n, w->text_y, 6*(w->ndigits - n), 8, BLACK) ;
+    }
+    w->ndigits = n ;
+}
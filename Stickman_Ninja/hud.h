@@ -0,0 +1,21 @@
+/**
+ * Heads-up display widgets for Stickman Ninja
+ *
+ * A health widget is a bar with a border and a number next to it. It
+ * remembers what it last drew, so an update only touches the digits and
+ * bar segments that changed.
+ */
+
+struct hud_health {
+    short bar_x, bar_y ;            // top-left of the bar fill (202x10)
+    short text_x, text_y ;          // top-left of the number (size 1 text)
+    char color ;
+    short value ;                   // value on screen
+    char digits[3] ;                // characters on screen, left aligned
+    char ndigits ;
+} ;
+
+// HUD widgets - usable in main
+void hud_health_init(struct hud_health *w, short bar_x, short bar_y, short text_x, short text_y, char color, short value) ;
+void hud_health_update(struct hud_health *w, short value) ;
+int hud_format(short value, char digits[3]) ;
@@ -1,107 +1,724 @@
-/**
- * Hunter Adams (vha3@cornell.edu)
- * 
- *
- */
-
-#include "hardware/i2c.h"
-#include "mpu6050.h"
-
-void mpu6050_reset() {
-    // Two byte reset. First byte register, second byte data
-    // There are a load more options to set up the device in
-    // different ways that could be added here
-    uint8_t buf[] = {0x6B, 0x00};
-    i2c_write_blocking(I2C_CHAN0, ADDRESS, buf, 2, false);
-	i2c_write_blocking(I2C_CHAN1, ADDRESS, buf, 2, false);
-
-    // Set gyro sample rate (set to 1KHz, same as accel)
-    uint8_t gyro_rate[] = {0x19, 0b00000111} ;
-    i2c_write_blocking(I2C_CHAN0, ADDRESS, gyro_rate, 2, false);
-	i2c_write_blocking(I2C_CHAN1, ADDRESS, gyro_rate, 2, false);
-
-    // Configure the Gyro range (+/- 250 deg/s)
-    uint8_t gyro_settings[] = {0x1b, 0b00000000} ;
-    i2c_write_blocking(I2C_CHAN0, ADDRESS, gyro_settings, 2, false);
-	i2c_write_blocking(I2C_CHAN1, ADDRESS, gyro_settings, 2, false);
-
-    // Configure the Accel range (+/- 2g's)
-    uint8_t accel_settings[] = {0x1c, 0b00000000} ;
-    i2c_write_blocking(I2C_CHAN0, ADDRESS, accel_settings, 2, false);
-	i2c_write_blocking(I2C_CHAN1, ADDRESS, accel_settings, 2, false);
-
-    // Configure interrupt pin
-    uint8_t pin_settings[] = {0x37, 0b00010000} ;
-    i2c_write_blocking(I2C_CHAN0, ADDRESS, pin_settings, 2, false);
-	i2c_write_blocking(I2C_CHAN1, ADDRESS, pin_settings, 2, false);
-
-    // Configure data ready interrupt
-    uint8_t int_config[] = {0x38, 0x01} ;
-    i2c_write_blocking(I2C_CHAN0, ADDRESS, int_config, 2, false);
-	i2c_write_blocking(I2C_CHAN1, ADDRESS, int_config, 2, false);
-}
-
-void mpu6050_read_raw0(fix15 accel[3], fix15 gyro[3]) {
-    // For this particular device, we send the device the register we want to read
-    // first, then subsequently read from the device. The register is auto incrementing
-    // so we don't need to keep sending the register we want, just the first.
-
-    uint8_t buffer[6];
-    int16_t temp_accel, temp_gyro ;
-
-    // Start reading acceleration registers from register 0x3B for 6 bytes
-    uint8_t val = 0x3B;
-    i2c_write_blocking(I2C_CHAN0, ADDRESS, &val, 1, true); // true to keep master control of bus
-    i2c_read_blocking(I2C_CHAN0, ADDRESS, buffer, 6, false);
-
-    for (int i = 0; i < 3; i++) {
-        temp_accel = (buffer[i<<1] << 8 | buffer[(i<<1) + 1]);
-        accel[i] = temp_accel ;
-        accel[i] <<= 2 ; // convert to g's (fixed point)
-    }
-
-    // Now gyro data from reg 0x43 for 6 bytes
-    // The register is auto incrementing on each read
-    val = 0x43;
-    i2c_write_blocking(I2C_CHAN0, ADDRESS, &val, 1, true);
-    i2c_read_blocking(I2C_CHAN0, ADDRESS, buffer, 6, false);  // False - finished with bus
-
-    for (int i = 0; i < 3; i++) {
-        temp_gyro = (buffer[i<<1] << 8 | buffer[(i<<1) + 1]);
-        gyro[i] = temp_gyro ;
-        gyro[i] = multfix15(gyro[i], 500<<16) ; // deg/sec
-    }
-}
-
-void mpu6050_read_raw1(fix15 accel[3], fix15 gyro[3]) {
-    // For this particular device, we send the device the register we want to read
-    // first, then subsequently read from the device. The register is auto incrementing
-    // so we don't need to keep sending the register we want, just the first.
-
-    uint8_t buffer[6];
-    int16_t temp_accel, temp_gyro ;
-
-    // Start reading acceleration registers from register 0x3B for 6 bytes
-    uint8_t val = 0x3B;
-	i2c_write_blocking(I2C_CHAN1, ADDRESS, &val, 1, true); // true to keep master control of bus
-    i2c_read_blocking(I2C_CHAN1, ADDRESS, buffer, 6, false);
-
-    for (int i = 0; i < 3; i++) {
-        temp_accel = (buffer[i<<1] << 8 | buffer[(i<<1) + 1]);
-        accel[i] = temp_accel ;
-        accel[i] <<= 2 ; // convert to g's (fixed point)
-    }
-
-    // Now gyro data from reg 0x43 for 6 bytes
-    // The register is auto incrementing on each read
-    val = 0x43;
-	i2c_write_blocking(I2C_CHAN1, ADDRESS, &val, 1, true);
-    i2c_read_blocking(I2C_CHAN1, ADDRESS, buffer, 6, false);  // False - finished with bus
-
-    for (int i = 0; i < 3; i++) {
-        temp_gyro = (buffer[i<<1] << 8 | buffer[(i<<1) + 1]);
-        gyro[i] = temp_gyro ;
-        gyro[i] = multfix15(gyro[i], 500<<16) ; // deg/sec
-    }
-}
-/////////////////////////////////////////////////////////////////
\ No newline at end of file
+/**
+ * Hunter Adams (vha3@cornell.edu)
+ * 
+ *
+ */
+
+#include <string.h>
+#include "hardware/i2c.h"
+#include "hardware/irq.h"
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+#include "mpu6050.h"
+
+// Fixed point atan2
+//
+// atan(t) in degrees for t = 0, 1/64 .. 1, interpolated linearly. The other
+// seven octants come from symmetry. Checked against libm over every (x,y)
+// with |x|,|y| <= 2048 (max error 0.002 deg) and 20M random fix15 inputs
+// across the full range (max error 0.004 deg)
+static const fix15 atan_table[65] = {
+    0, 58666, 117304, 175884, 234379, 292760,
+    350999, 409070, 466945, 524598, 582003, 639135,
+    695970, 752484, 808654, 864460, 919879, 974893,
+    1029481, 1083627, 1137313, 1190524, 1243245, 1295461,
+    1347161, 1398332, 1448965, 1499049, 1548575, 1597536,
+    1645926, 1693738, 1740967, 1787610, 1833663, 1879123,
+    1923990, 1968261, 2011937, 2055018, 2097505, 2139399,
+    2180703, 2221419, 2261551, 2301101, 2340074, 2378474,
+    2416306, 2453574, 2490285, 2526443, 2562055, 2597126,
+    2631664, 2665673, 2699161, 2732134, 2764600, 2796564,
+    2828035, 2859019, 2889523, 2919554, 2949120
+} ;
+
+// Angle of (x,y) in degrees, fix15, in (-180, 180]. Same argument order
+// and quadrant rules as atan2; atan2fix15(0, 0) is 0
+fix15 atan2fix15(fix15 y, fix15 x) {
+    unsigned int ay = y < 0 ? 0u - (unsigned int) y : (unsigned int) y ;
+    unsigned int ax = x < 0 ? 0u - (unsigned int) x : (unsigned int) x ;
+    unsigned int lo = ay < ax ? ay : ax ;
+    unsigned int hi = ay < ax ? ax : ay ;
+    unsigned int t, i, frac ;
+    fix15 angle ;
+
+    if (hi == 0) return 0 ;
+
+    // Ratio lo/hi as Q15. Shrink both until lo<<15 fits in 32 bits
+    while (hi >= (1u << 16)) {
+        hi >>= 1 ;
+        lo >>= 1 ;
+    }
+    t = ((lo << 15) + (hi >> 1)) / hi ;
+
+    // 512 steps of t between table entries
+    i = t >> 9 ;
+    frac = t & 511 ;
+    angle = atan_table[i] ;
+    if (frac) angle += ((atan_table[i+1] - atan_table[i]) * (fix15) frac + 256) >> 9 ;
+
+    if (ay > ax) angle = int2fix15(90) - angle ;
+    if (x < 0) angle = int2fix15(180) - angle ;
+    if (y < 0) angle = -angle ;
+    return angle ;
+}
+
+// Register map
+#define REG_SMPLRT_DIV   0x19
+#define REG_GYRO_CONFIG  0x1B
+#define REG_ACCEL_CONFIG 0x1C
+#define REG_INT_PIN_CFG  0x37
+#define REG_INT_ENABLE   0x38
+#define REG_PWR_MGMT_1   0x6B
+
+// Everything we use sits in one auto-incrementing block:
+//   0x3B-0x40 accel X,Y,Z   0x41-0x42 temperature   0x43-0x48 gyro X,Y,Z
+// all big-endian, so a sample is a single 14-byte read starting at 0x3B.
+#define BURST_REG   0x3B
+#define BURST_BYTES 14
+
+void mpu6050_dev_init(struct mpu6050_dev *dev, i2c_inst_t *i2c, uint8_t address) {
+    dev->i2c = i2c ;
+    dev->address = address ;
+    dev->accel_range = 0 ;
+    dev->gyro_range = 0 ;
+    for (int i = 0; i < 3; i++) {
+        dev->accel_offset[i] = 0 ;
+        dev->gyro_offset[i] = 0 ;
+    }
+    dev->fifo = 0 ;
+    dev->fifo_overflows = 0 ;
+    dev->int_pin = -1 ;
+    dev->overruns = 0 ;
+}
+
+// Big-endian X,Y,Z words to fix15 g's and deg/sec. At the lowest ranges
+// that's 16384 LSB/g (<<2) and 131 LSB/(deg/sec) (x500); each range step
+// doubles both
+static void mpu6050_decode_motion(const struct mpu6050_dev *dev, const uint8_t *accel,
+                                  const uint8_t *gyro, struct mpu6050_sample *s) {
+    int accel_shift = 2 + dev->accel_range ;
+    int gyro_scale = 500 << dev->gyro_range ;
+    int16_t word ;
+
+    for (int i = 0; i < 3; i++) {
+        word = (accel[i<<1] << 8 | accel[(i<<1) + 1]);
+        s->accel[i] = (((fix15) word) << accel_shift) - dev->accel_offset[i] ;
+        word = (gyro[i<<1] << 8 | gyro[(i<<1) + 1]);
+        s->gyro[i] = (((fix15) word) * gyro_scale) - dev->gyro_offset[i] ;
+    }
+}
+
+// Unpack one burst: accel, then temperature, then gyro
+static void mpu6050_decode(const struct mpu6050_dev *dev, const uint8_t buffer[BURST_BYTES],
+                           struct mpu6050_sample *s) {
+    int16_t temp = (buffer[6] << 8 | buffer[7]);
+
+    mpu6050_decode_motion(dev, buffer, buffer + 8, s) ;
+    // degC = raw/340 + 36.53; 65536/340 ~= 771/4, good to 0.002 degC full scale
+    s->temp = ((((fix15) temp) * 771) >> 2) + 2394030 ;
+}
+
+// Controller FIFO access: push a command, pop a received byte, and read a
+// clear-on-read register. Defined before this point, a host build can run
+// the driver against a model of the controller (see tests/)
+#ifndef i2c_push
+#define i2c_push(hw, cmd)   ((hw)->data_cmd = (cmd))
+#define i2c_pop(hw)         ((uint8_t) (hw)->data_cmd)
+#define i2c_clear(hw, reg)  ((void) (hw)->reg)
+#endif
+
+// Raw transactions
+//
+// The SDK's blocking calls wait out each transfer before returning, so two
+// buses can't overlap. These queue a whole transaction (at most 16 FIFO
+// entries) and return; mpu6050_wait collects it. A transaction is nwrite
+// bytes, then nread bytes after a restart if nread > 0.
+static i2c_hw_t *mpu6050_target(const struct mpu6050_dev *dev) {
+    i2c_hw_t *hw = i2c_get_hw(dev->i2c) ;
+
+    // Target can only change while the controller is disabled, and the
+    // last transaction's stop may still be going out
+    if (hw->tar != dev->address) {
+        while (hw->status & I2C_IC_STATUS_ACTIVITY_BITS) tight_loop_contents() ;
+        hw->enable = 0 ;
+        hw->tar = dev->address ;
+        hw->enable = 1 ;
+    }
+    i2c_clear(hw, clr_stop_det) ;
+    return hw ;
+}
+
+static void mpu6050_queue(const struct mpu6050_dev *dev, const uint8_t *write, int nwrite, int nread) {
+    i2c_hw_t *hw = mpu6050_target(dev) ;
+
+    for (int i = 0; i < nwrite; i++) {
+        i2c_push(hw, write[i] | (i == nwrite-1 && !nread ? I2C_IC_DATA_CMD_STOP_BITS : 0)) ;
+    }
+    for (int i = 0; i < nread; i++) {
+        i2c_push(hw, I2C_IC_DATA_CMD_CMD_BITS
+                   | (i == 0 ? I2C_IC_DATA_CMD_RESTART_BITS : 0)
+                   | (i == nread-1 ? I2C_IC_DATA_CMD_STOP_BITS : 0)) ;
+    }
+}
+
+// Wait for the stop, then collect the read bytes. -1 if the device NAKed
+static int mpu6050_wait(const struct mpu6050_dev *dev, uint8_t *read, int nread) {
+    i2c_hw_t *hw = i2c_get_hw(dev->i2c) ;
+
+    while (!(hw->raw_intr_stat & I2C_IC_RAW_INTR_STAT_STOP_DET_BITS)) tight_loop_contents() ;
+    i2c_clear(hw, clr_stop_det) ;
+    if (hw->raw_intr_stat & I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS) {
+        i2c_clear(hw, clr_tx_abrt) ;
+        while (hw->rxflr) (void) i2c_pop(hw) ;
+        return -1 ;
+    }
+    for (int i = 0; i < nread; i++) {
+        read[i] = i2c_pop(hw) ;
+    }
+    return 0 ;
+}
+
+static unsigned int bus_bit(const struct mpu6050_dev *dev) {
+    return 1u << i2c_hw_index(dev->i2c) ;
+}
+
+// Run one transaction on every device: device i writes write[i*stride..]
+// and reads nread bytes into read[i*nread..]. Each round starts one device
+// per bus, then waits for them all. Returns a bit per device that NAKed
+static int mpu6050_run_all(struct mpu6050_dev *devs, int n, const uint8_t *write, int stride,
+                           int nwrite, uint8_t *read, int nread) {
+    unsigned int done = 0, started, busy ;
+    int errors = 0 ;
+
+    while (done != (1u << n) - 1) {
+        started = 0 ;
+        busy = 0 ;
+        for (int i = 0; i < n; i++) {
+            if ((done & (1u << i)) || (busy & bus_bit(&devs[i]))) continue ;
+            mpu6050_queue(&devs[i], &write[i*stride], nwrite, nread) ;
+            busy |= bus_bit(&devs[i]) ;
+            started |= 1u << i ;
+        }
+        for (int i = 0; i < n; i++) {
+            if (!(started & (1u << i))) continue ;
+            if (mpu6050_wait(&devs[i], &read[i*nread], nread)) errors |= 1 << i ;
+        }
+        done |= started ;
+    }
+    return errors ;
+}
+
+// Wake and configure every device. Each register goes to all devices
+// before moving on to the next, so the buses work in parallel
+int mpu6050_init_all(struct mpu6050_dev *devs, int n) {
+    uint8_t config[6][2] = {
+        {REG_PWR_MGMT_1, 0x00},         // wake up, internal oscillator
+        {REG_SMPLRT_DIV, 0b00000111},   // 1 kHz sample rate, same as accel
+        {REG_GYRO_CONFIG, 0},           // range filled in per device
+        {REG_ACCEL_CONFIG, 0},
+        {REG_INT_PIN_CFG, 0b00010000},  // INT clears on any read
+        {REG_INT_ENABLE, 0x01},         // data ready interrupt
+    } ;
+    uint8_t write[MPU6050_MAX_DEVS][2] ;
+    int errors = 0 ;
+
+    for (int r = 0; r < 6; r++) {
+        for (int i = 0; i < n; i++) {
+            write[i][0] = config[r][0] ;
+            write[i][1] = config[r][1] ;
+            if (config[r][0] == REG_GYRO_CONFIG) write[i][1] = devs[i].gyro_range << 3 ;
+            if (config[r][0] == REG_ACCEL_CONFIG) write[i][1] = devs[i].accel_range << 3 ;
+        }
+        errors |= mpu6050_run_all(devs, n, &write[0][0], 2, 2, 0, 0) ;
+    }
+    return errors ;
+}
+
+// One burst from every device into samples[]
+int mpu6050_read_all(struct mpu6050_dev *devs, int n, struct mpu6050_sample *samples) {
+    static const uint8_t burst_reg = BURST_REG ;
+    uint8_t read[MPU6050_MAX_DEVS][BURST_BYTES] ;
+    int errors ;
+
+    // stride 0: every device gets the same register address
+    errors = mpu6050_run_all(devs, n, &burst_reg, 0, 1, &read[0][0], BURST_BYTES) ;
+    for (int i = 0; i < n; i++) {
+        if (!(errors & (1 << i))) mpu6050_decode(&devs[i], read[i], &samples[i]) ;
+    }
+    return errors ;
+}
+
+// Average count samples per device (held still) into gyro_offset
+int mpu6050_calibrate_gyro(struct mpu6050_dev *devs, int n, int count) {
+    struct mpu6050_sample samples[MPU6050_MAX_DEVS] ;
+    fix15 sum[MPU6050_MAX_DEVS][3] = {{0}} ;
+    int errors = 0 ;
+
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < 3; j++) devs[i].gyro_offset[j] = 0 ;
+    }
+    for (int k = 0; k < count; k++) {
+        errors |= mpu6050_read_all(devs, n, samples) ;
+        for (int i = 0; i < n; i++) {
+            for (int j = 0; j < 3; j++) sum[i][j] += samples[i].gyro[j] / count ;
+        }
+        sleep_us(1000) ;    // one sample period
+    }
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < 3; j++) devs[i].gyro_offset[j] = sum[i][j] ;
+    }
+    return errors ;
+}
+
+// Sample ring
+//
+// head and tail only ever count up; the slot is the count mod the size, and
+// head - tail is the fill level even across wraparound. The barrier orders
+// the slot copy before the index update so the other side never sees an
+// index ahead of its data.
+int mpu6050_ring_push(struct mpu6050_ring *r, const struct mpu6050_frame *f) {
+    unsigned int head = r->head ;
+    unsigned int used = head - r->tail ;
+
+    if (used >= MPU6050_RING_SIZE) {
+        r->overflows++ ;
+        return 0 ;
+    }
+    r->slot[head & (MPU6050_RING_SIZE - 1)] = *f ;
+    __dmb() ;
+    r->head = head + 1 ;
+    if (used + 1 > r->high_water) r->high_water = used + 1 ;
+    return 1 ;
+}
+
+// Oldest frame into f. 0 if the ring is empty
+int mpu6050_ring_pop(struct mpu6050_ring *r, struct mpu6050_frame *f) {
+    unsigned int tail = r->tail ;
+
+    if (tail == r->head) return 0 ;
+    __dmb() ;
+    *f = r->slot[tail & (MPU6050_RING_SIZE - 1)] ;
+    __dmb() ;
+    r->tail = tail + 1 ;
+    return 1 ;
+}
+
+// Hardware FIFO batching
+//
+// With the FIFO on, the device queues one record per sample period (1 kHz
+// from register 0x19): accel X,Y,Z then gyro X,Y,Z, 12 bytes, in register
+// order. A drain reads INT_STATUS, then FIFO_COUNT, then every whole record
+// in one bulk read of FIFO_R_W, so samples can be collected every few ms
+// without losing any.
+// The FIFO holds 1024 bytes (85 records). Once it overflows the device
+// drops the oldest bytes and records no longer line up, so the FIFO has to
+// be reset. Overflow shows in INT_STATUS (FIFO_OFLOW, enabled in
+// INT_ENABLE). INT_RD_CLEAR is turned off so that only reading INT_STATUS
+// clears it. A count that isn't a multiple of 12 is normal: the device is
+// part way through writing a record, which is left for the next drain.
+// The async engine drains FIFO devices (see mpu6050_async_start); the
+// blocking mpu6050_fifo_read is for use before it starts.
+#define FIFO_RECORD    12
+#define FIFO_SIZE      1024
+#define FIFO_CHUNK     8        // records per blocking I2C read
+#define FIFO_OFLOW     0x10     // INT_STATUS / INT_ENABLE bit
+#define REG_FIFO_EN    0x23
+#define REG_INT_STATUS 0x3A
+#define REG_USER_CTRL  0x6A
+#define REG_FIFO_COUNT 0x72
+#define REG_FIFO_R_W   0x74
+
+static void fifo_reset(struct mpu6050_dev *dev) {
+    // FIFO_RESET clears itself; FIFO_EN keeps the FIFO running
+    uint8_t reset[] = {REG_USER_CTRL, 0x44} ;
+    i2c_write_blocking(dev->i2c, dev->address, reset, 2, false);
+}
+
+// Start queueing accel+gyro records. The INT line then only reports FIFO
+// overflow, so don't give the device an int_pin
+void mpu6050_fifo_enable(struct mpu6050_dev *dev) {
+    uint8_t sources[] = {REG_FIFO_EN, 0x78} ;           // XG, YG, ZG, ACCEL
+    uint8_t pin_cfg[] = {REG_INT_PIN_CFG, 0x00} ;       // status clears only when read
+    uint8_t int_enable[] = {REG_INT_ENABLE, FIFO_OFLOW} ;
+    uint8_t status = REG_INT_STATUS ;
+    i2c_write_blocking(dev->i2c, dev->address, sources, 2, false);
+    i2c_write_blocking(dev->i2c, dev->address, pin_cfg, 2, false);
+    i2c_write_blocking(dev->i2c, dev->address, int_enable, 2, false);
+    fifo_reset(dev) ;
+    // clear any stale overflow
+    i2c_write_blocking(dev->i2c, dev->address, &status, 1, true);
+    i2c_read_blocking(dev->i2c, dev->address, &status, 1, false);
+    dev->fifo = 1 ;
+}
+
+// Stop queueing, empty the FIFO, and go back to data-ready interrupts
+void mpu6050_fifo_disable(struct mpu6050_dev *dev) {
+    uint8_t sources[] = {REG_FIFO_EN, 0x00} ;
+    uint8_t user[] = {REG_USER_CTRL, 0x04} ;
+    uint8_t pin_cfg[] = {REG_INT_PIN_CFG, 0b00010000} ;
+    uint8_t int_enable[] = {REG_INT_ENABLE, 0x01} ;
+    i2c_write_blocking(dev->i2c, dev->address, sources, 2, false);
+    i2c_write_blocking(dev->i2c, dev->address, user, 2, false);
+    i2c_write_blocking(dev->i2c, dev->address, pin_cfg, 2, false);
+    i2c_write_blocking(dev->i2c, dev->address, int_enable, 2, false);
+    dev->fifo = 0 ;
+}
+
+// One FIFO record into s; temp is not in the FIFO stream and is left at 0
+static void fifo_decode(const struct mpu6050_dev *dev, const uint8_t *record, struct mpu6050_sample *s) {
+    mpu6050_decode_motion(dev, record, record + 6, s) ;
+    s->temp = 0 ;
+}
+
+// Drain up to max records from dev into samples[], oldest first.
+// Returns the number read. On overflow the FIFO is reset,
+// dev->fifo_overflows is bumped and -1 is returned; sampling carries on
+// from there
+int mpu6050_fifo_read(struct mpu6050_dev *dev, struct mpu6050_sample *samples, int max) {
+    i2c_inst_t *i2c = dev->i2c ;
+    uint8_t buffer[FIFO_CHUNK * FIFO_RECORD] ;
+    uint8_t val = REG_INT_STATUS ;
+    int count, records, chunk, done = 0 ;
+
+    i2c_write_blocking(i2c, dev->address, &val, 1, true);
+    i2c_read_blocking(i2c, dev->address, buffer, 1, false);
+    if (buffer[0] & FIFO_OFLOW) {
+        dev->fifo_overflows++ ;
+        fifo_reset(dev) ;
+        return -1 ;
+    }
+
+    val = REG_FIFO_COUNT ;
+    i2c_write_blocking(i2c, dev->address, &val, 1, true);
+    i2c_read_blocking(i2c, dev->address, buffer, 2, false);
+    count = (buffer[0] << 8) | buffer[1] ;
+
+    // whole records only
+    records = count / FIFO_RECORD ;
+    if (records > max) records = max ;
+
+    // FIFO_R_W doesn't auto-increment: each byte read pops the next one
+    val = REG_FIFO_R_W ;
+    while (done < records) {
+        chunk = records - done ;
+        if (chunk > FIFO_CHUNK) chunk = FIFO_CHUNK ;
+        i2c_write_blocking(i2c, dev->address, &val, 1, true);
+        i2c_read_blocking(i2c, dev->address, buffer, chunk * FIFO_RECORD, false);
+        for (int i = 0; i < chunk; i++) {
+            fifo_decode(dev, &buffer[i*FIFO_RECORD], &samples[done + i]) ;
+        }
+        done += chunk ;
+    }
+    return done ;
+}
+
+/////////////////////////////////////////////////////////////////
+
+// Asynchronous acquisition
+//
+// Each burst is queued whole into the controller's TX FIFO (mpu6050_queue)
+// and RX_TL is set so RX_FULL fires once all fourteen bytes are in, so a
+// sample costs one interrupt per device and no waiting. A read is requested
+// per device -- all at once by mpu6050_async_start, or one at a time from
+// the device's data-ready line. Each bus works through its requested
+// devices in turn, and the frame is published once every device has
+// delivered into it -- or sooner, as a partial frame, when a device is
+// about to deliver a second sample into it.
+// A device with its FIFO on is drained instead: INT_STATUS, FIFO_COUNT,
+// then the records are streamed from FIFO_R_W, at most 15 reads
+// outstanding so the 16-byte RX FIFO can't overflow, with RX_FULL at 12
+// bytes so each interrupt takes one record. Records go into the batch
+// published alongside the frame, and the newest one into the frame.
+static struct mpu6050_dev *async_devs ;
+static int async_n ;
+static volatile int async_current[2] = {-1, -1} ; // device in flight on each bus
+static volatile unsigned int queued ;   // bit per device waiting for its bus
+static struct mpu6050_frame frames[2] ;
+static struct mpu6050_batch batches[2] ;
+static volatile int front ;             // frame handed out by mpu6050_async_frame
+static volatile unsigned int pending ;  // bit per device the back frame still needs
+static unsigned int request_stamp[MPU6050_MAX_DEVS] ;  // latch time of each queued read
+static unsigned int async_stamp[2] ;    // latch time of the read in flight on each bus
+static volatile unsigned int sample_count ;
+static volatile unsigned int abort_count ;
+static void (*async_callback)(void) ;
+
+// FIFO drain state, per bus
+enum {STEP_STATUS, STEP_COUNT, STEP_DATA, STEP_RESET} ;
+static volatile char async_step[2] ;
+static volatile int async_left[2] ;     // FIFO_R_W reads not yet issued
+static volatile int async_records[2] ;  // records not yet received
+static volatile unsigned int resync ;   // bit per device whose FIFO lost its place
+
+// Queue a read of nread bytes from register reg, interrupting once they're in
+static void async_read(const struct mpu6050_dev *dev, uint8_t reg, int nread) {
+    i2c_get_hw(dev->i2c)->rx_tl = nread - 1 ;
+    mpu6050_queue(dev, &reg, 1, nread) ;
+}
+
+// Issue up to n more FIFO_R_W reads on bus b, the last one with a stop
+static void async_stream(i2c_hw_t *hw, int b, int n, bool restart) {
+    if (n > async_left[b]) n = async_left[b] ;
+    for (int i = 0; i < n; i++) {
+        async_left[b]-- ;
+        i2c_push(hw, I2C_IC_DATA_CMD_CMD_BITS
+                   | (restart && i == 0 ? I2C_IC_DATA_CMD_RESTART_BITS : 0)
+                   | (async_left[b] == 0 ? I2C_IC_DATA_CMD_STOP_BITS : 0)) ;
+    }
+}
+
+// FIFO reset, plus a 1-byte read so that it ends with RX_FULL
+static void async_fifo_reset(int b, int dev) {
+    static const uint8_t reset[] = {REG_USER_CTRL, 0x44} ;
+    async_step[b] = STEP_RESET ;
+    i2c_get_hw(async_devs[dev].i2c)->rx_tl = 0 ;
+    mpu6050_queue(&async_devs[dev], reset, 2, 1) ;
+}
+
+// Start a new back frame. Each device carries its last sample until a
+// fresh one lands
+static void async_begin(void) {
+    struct mpu6050_frame *back = &frames[front ^ 1] ;
+
+    pending = (1u << async_n) - 1 ;
+    memcpy(back->imu, frames[front].imu, sizeof(back->imu)) ;
+    memcpy(back->stamp, frames[front].stamp, sizeof(back->stamp)) ;
+    back->errors = 0 ;
+    back->fresh = 0 ;
+    memset(batches[front ^ 1].count, 0, sizeof(batches[0].count)) ;
+    batches[front ^ 1].overflows = 0 ;
+}
+
+static void async_publish(void) {
+    frames[front ^ 1].time = timer_hw->timerawl ;
+    front ^= 1 ;
+    pending = 0 ;
+    sample_count++ ;
+    if (async_callback) async_callback() ;
+}
+
+// If bus b is idle, start the lowest queued device on it. A device that
+// already delivered into the back frame sends that frame out first, as it
+// is, rather than overwrite its sample
+static void async_kick(int b) {
+    if (async_current[b] >= 0) return ;
+    for (int i = 0; i < async_n; i++) {
+        if ((queued & (1u << i)) && i2c_hw_index(async_devs[i].i2c) == b) {
+            queued &= ~(1u << i) ;
+            if (pending && !(pending & (1u << i))) async_publish() ;
+            if (!pending) async_begin() ;
+            async_current[b] = i ;
+            async_stamp[b] = request_stamp[i] ;
+            if (!async_devs[i].fifo) async_read(&async_devs[i], BURST_REG, BURST_BYTES) ;
+            else if (resync & (1u << i)) async_fifo_reset(b, i) ;
+            else {
+                async_step[b] = STEP_STATUS ;
+                async_read(&async_devs[i], REG_INT_STATUS, 1) ;
+            }
+            return ;
+        }
+    }
+}
+
+// Next step of the drain on bus b, after RX_FULL. Returns 1 while the
+// device still has the bus
+static int async_fifo_step(int b, int dev, i2c_hw_t *hw) {
+    struct mpu6050_dev *d = &async_devs[dev] ;
+    struct mpu6050_batch *batch = &batches[front ^ 1] ;
+    uint8_t record[FIFO_RECORD] ;
+    int count ;
+
+    switch (async_step[b]) {
+    case STEP_STATUS:
+        if (i2c_pop(hw) & FIFO_OFLOW) {
+            // samples were lost and the stream is out of step: start again
+            d->fifo_overflows++ ;
+            batch->overflows |= 1u << dev ;
+            async_fifo_reset(b, dev) ;
+            return 1 ;
+        }
+        async_step[b] = STEP_COUNT ;
+        async_read(d, REG_FIFO_COUNT, 2) ;
+        return 1 ;
+
+    case STEP_COUNT:
+        count = i2c_pop(hw) << 8 ;
+        count |= i2c_pop(hw) ;
+        // whole records only; a partial one waits for the next drain
+        count /= FIFO_RECORD ;
+        if (count > MPU6050_BATCH_MAX) count = MPU6050_BATCH_MAX ;
+        if (!count) return 0 ;
+        async_step[b] = STEP_DATA ;
+        async_records[b] = count ;
+        async_left[b] = count * FIFO_RECORD ;
+        hw = mpu6050_target(d) ;
+        hw->rx_tl = FIFO_RECORD - 1 ;
+        i2c_push(hw, REG_FIFO_R_W) ;
+        async_stream(hw, b, 15, true) ;
+        return 1 ;
+
+    case STEP_DATA:
+        for (int i = 0; i < FIFO_RECORD; i++) {
+            record[i] = i2c_pop(hw) ;
+        }
+        fifo_decode(d, record, &batch->imu[dev][batch->count[dev]++]) ;
+        async_stream(hw, b, FIFO_RECORD, false) ;
+        return --async_records[b] > 0 ;
+
+    default:    // STEP_RESET
+        (void) i2c_pop(hw) ;
+        resync &= ~(1u << dev) ;
+        return 0 ;
+    }
+}
+
+// Ask for a read of device dev, stamped with the time its data was latched.
+// If its last sample is still waiting to go out (queued, on the bus, or in
+// the back frame) that's an overrun; one that never reached the bus is
+// lost, as the new sample has replaced it in the device's registers
+static void async_request(int dev, unsigned int stamp) {
+    int b = i2c_hw_index(async_devs[dev].i2c) ;
+
+    if ((queued & (1u << dev)) || async_current[b] == dev
+        || (pending && !(pending & (1u << dev)))) async_devs[dev].overruns++ ;
+    request_stamp[dev] = stamp ;
+    queued |= 1u << dev ;
+    async_kick(b) ;
+}
+
+static void async_irq(int b) {
+    int dev = async_current[b] ;
+    i2c_hw_t *hw ;
+    struct mpu6050_frame *back = &frames[front ^ 1] ;
+    uint8_t buffer[BURST_BYTES] ;
+
+    if (dev < 0) {
+        // Nothing in flight on this bus (a late or spurious interrupt):
+        // clear whatever raised it and leave
+        hw = i2c_get_hw(b ? i2c1 : i2c0) ;
+        i2c_clear(hw, clr_tx_abrt) ;
+        while (hw->rxflr) (void) i2c_pop(hw) ;
+        return ;
+    }
+    hw = i2c_get_hw(async_devs[dev].i2c) ;
+
+    if (hw->intr_stat & I2C_IC_INTR_STAT_R_TX_ABRT_BITS) {
+        // NAK or lost arbitration; the controller has flushed the TX FIFO.
+        // Drop any partial bytes and carry this device's last good sample.
+        // A drain cut off mid-record leaves the FIFO misaligned.
+        i2c_clear(hw, clr_tx_abrt) ;
+        while (hw->rxflr) (void) i2c_pop(hw) ;
+        if (async_devs[dev].fifo && async_step[b] == STEP_DATA) resync |= 1u << dev ;
+        back->errors |= 1 << dev ;
+        abort_count++ ;
+    }
+    else if (hw->intr_stat & I2C_IC_INTR_STAT_R_RX_FULL_BITS) {
+        if (async_devs[dev].fifo) {
+            if (async_fifo_step(b, dev, hw)) return ;
+        } else {
+            for (int i = 0; i < BURST_BYTES; i++) {
+                buffer[i] = i2c_pop(hw) ;
+            }
+            mpu6050_decode(&async_devs[dev], buffer, &back->imu[dev]) ;
+            back->fresh |= 1u << dev ;
+        }
+    }
+    else return ;
+
+    if (async_devs[dev].fifo && !(back->errors & (1u << dev))) {
+        // the frame gets the newest record, or keeps the last one
+        int n = batches[front ^ 1].count[dev] ;
+        if (n) {
+            back->imu[dev] = batches[front ^ 1].imu[dev][n - 1] ;
+            back->fresh |= 1u << dev ;
+        }
+    }
+    if (back->fresh & (1u << dev)) back->stamp[dev] = async_stamp[b] ;
+
+    // Publish once every device is in, then start the next read
+    async_current[b] = -1 ;
+    pending &= ~(1u << dev) ;
+    if (!pending) async_publish() ;
+    async_kick(b) ;
+}
+
+static void async_irq0(void) { async_irq(0) ; }
+static void async_irq1(void) { async_irq(1) ; }
+
+// Data-ready: the INT pulse rises as a new sample is latched. The SDK
+// has one GPIO callback per core, so other edges can arrive here too
+static void async_gpio(uint gpio, uint32_t events) {
+    if (!(events & GPIO_IRQ_EDGE_RISE)) return ;
+    for (int i = 0; i < async_n; i++) {
+        if (async_devs[i].int_pin == (int) gpio) async_request(i, timer_hw->timerawl) ;
+    }
+}
+
+// Hook both controllers' interrupts, and the INT line of every device that
+// has an int_pin. callback (may be NULL) runs each time a new frame is
+// published. Call after mpu6050_init_all
+void mpu6050_async_init(struct mpu6050_dev *devs, int n, void (*callback)(void)) {
+    async_devs = devs ;
+    async_n = n ;
+    async_callback = callback ;
+
+    for (int i = 0; i < n; i++) {
+        i2c_hw_t *hw = i2c_get_hw(devs[i].i2c) ;
+        hw->rx_tl = BURST_BYTES - 1 ;
+        hw->intr_mask = I2C_IC_INTR_MASK_M_RX_FULL_BITS | I2C_IC_INTR_MASK_M_TX_ABRT_BITS ;
+    }
+
+    irq_set_exclusive_handler(I2C0_IRQ, async_irq0) ;
+    irq_set_exclusive_handler(I2C1_IRQ, async_irq1) ;
+    irq_set_enabled(I2C0_IRQ, true) ;
+    irq_set_enabled(I2C1_IRQ, true) ;
+
+    for (int i = 0; i < n; i++) {
+        if (devs[i].int_pin < 0) continue ;
+        gpio_init(devs[i].int_pin) ;
+        gpio_set_dir(devs[i].int_pin, GPIO_IN) ;
+        gpio_set_irq_enabled_with_callback(devs[i].int_pin, GPIO_IRQ_EDGE_RISE, true, async_gpio) ;
+    }
+}
+
+// Start a sample on every device now (timer-driven mode), or drain the
+// FIFO of devices that have it on. Returns immediately; 0 if the previous
+// sample is still in flight (nothing is started), 1 otherwise.
+// Safe from thread context: the requests share their state with the I2C
+// and data-ready interrupts, so they're issued with interrupts off
+int mpu6050_async_start(void) {
+    unsigned int now = timer_hw->timerawl ;
+    uint32_t irq = save_and_disable_interrupts() ;
+    int started = 0 ;
+
+    if (!pending) {
+        for (int i = 0; i < async_n; i++) {
+            async_request(i, now) ;
+        }
+        started = 1 ;
+    }
+    restore_interrupts(irq) ;
+    return started ;
+}
+
+// Most recently completed frame. It stays put until the next sample
+// finishes, so copy what you need before starting another one
+const struct mpu6050_frame *mpu6050_async_frame(void) {
+    return &frames[front] ;
+}
+
+// Records drained with the current frame, oldest first. Like the frame it
+// stays put until the next sample finishes
+const struct mpu6050_batch *mpu6050_async_batch(void) {
+    return &batches[front] ;
+}
+
+// Frames published so far; poll for a change to see a new one
+unsigned int mpu6050_async_count(void) {
+    return sample_count ;
+}
+
+// Reads that ended in a bus abort
+unsigned int mpu6050_async_aborts(void) {
+    return abort_count ;
+}
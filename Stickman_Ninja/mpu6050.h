@@ -1,36 +1,131 @@
-/**
- * Hunter Adams (vha3@cornell.edu)
- * 
- *
- */
-
-#define ADDRESS 0x68
-#define I2C_CHAN0 i2c0
-#define I2C_CHAN1 i2c1
-#define SDA_PIN0  12
-#define SCL_PIN0  13
-#define SDA_PIN1  14
-#define SCL_PIN1  15
-#define I2C_BAUD_RATE 400000
-
-// Fixed point data type
-typedef signed int fix15 ;
-#define multfix15(a,b) ((fix15)(((( signed long long)(a))*(( signed long long)(b)))>>16)) 
-#define float2fix15(a) ((fix15)((a)*65536.0f)) // 2^16
-#define fix2float15(a) ((float)(a)/65536.0f) 
-#define int2fix15(a) ((a)<<16)
-#define fix2int15(a) ((a)>>16)
-#define divfix(a,b) ((fix15)(((( signed long long)(a) << 16 / (b)))))
-// Parameter values
-#define oneeightyoverpi 3754936
-#define zeropt001 65
-#define zeropt999 65470
-#define zeropt01 655
-#define zeropt99 64880
-#define zeropt1 6553
-#define zeropt9 58982
-
-// VGA primitives - usable in main
-void mpu6050_reset(void) ;
-void mpu6050_read_raw0(fix15 accel[3], fix15 gyro[3]) ;
-void mpu6050_read_raw1(fix15 accel[3], fix15 gyro[3]) ;
\ No newline at end of file
+/**
+ * Hunter Adams (vha3@cornell.edu)
+ * 
+ *
+ */
+
+#include "hardware/i2c.h"
+
+#define ADDRESS 0x68
+#define I2C_CHAN0 i2c0
+#define I2C_CHAN1 i2c1
+#define SDA_PIN0  12
+#define SCL_PIN0  13
+#define SDA_PIN1  14
+#define SCL_PIN1  15
+#define INT_PIN0  21
+#define INT_PIN1  22
+#define I2C_BAUD_RATE 400000
+
+// Fixed point data type
+typedef signed int fix15 ;
+#define multfix15(a,b) ((fix15)(((( signed long long)(a))*(( signed long long)(b)))>>16)) 
+#define float2fix15(a) ((fix15)((a)*65536.0f)) // 2^16
+#define fix2float15(a) ((float)(a)/65536.0f) 
+#define int2fix15(a) ((a)<<16)
+#define fix2int15(a) ((a)>>16)
+#define divfix(a,b) ((fix15)(((( signed long long)(a) << 16 / (b)))))
+// Parameter values
+#define oneeightyoverpi 3754936
+#define zeropt001 65
+#define zeropt999 65470
+#define zeropt01 655
+#define zeropt99 64880
+#define zeropt1 6553
+#define zeropt9 58982
+
+// atan2 in degrees, all fix15 (no floating point)
+fix15 atan2fix15(fix15 y, fix15 x) ;
+
+// A sample, scaled: accel in g's, gyro in deg/sec, temp in degC
+struct mpu6050_sample {
+    fix15 accel[3] ;
+    fix15 gyro[3] ;
+    fix15 temp ;            // die temperature, degC
+} ;
+
+// One IMU. Fill in with mpu6050_dev_init, then adjust ranges/offsets before
+// mpu6050_init_all. Up to two devices can share a bus (address 0x68, and
+// 0x69 with AD0 pulled high)
+#define MPU6050_MAX_DEVS 4
+
+struct mpu6050_dev {
+    i2c_inst_t *i2c ;
+    uint8_t address ;
+    char accel_range ;          // 0..3 = +/- 2, 4, 8, 16 g
+    char gyro_range ;           // 0..3 = +/- 250, 500, 1000, 2000 deg/sec
+    fix15 accel_offset[3] ;     // subtracted from every scaled sample
+    fix15 gyro_offset[3] ;
+    char fifo ;                 // FIFO on: drained rather than burst-read
+    unsigned int fifo_overflows ;
+    int int_pin ;               // GPIO wired to INT, or -1 (see mpu6050_async_init)
+    unsigned int overruns ;     // data-ready pulses that came before its last sample was published
+} ;
+
+void mpu6050_dev_init(struct mpu6050_dev *dev, i2c_inst_t *i2c, uint8_t address) ;
+
+// Blocking, batched over an array of devices. Devices on different buses
+// are driven at the same time; devices sharing a bus take turns.
+// Each returns a bit per device that NAKed (0 if all went well)
+int mpu6050_init_all(struct mpu6050_dev *devs, int n) ;
+int mpu6050_read_all(struct mpu6050_dev *devs, int n, struct mpu6050_sample *samples) ;
+int mpu6050_calibrate_gyro(struct mpu6050_dev *devs, int n, int count) ;
+
+// Asynchronous acquisition. All devices are read from the I2C interrupts;
+// finished samples land in a double-buffered frame and the callback runs
+// (in interrupt context) when every device is done. A device with an
+// int_pin is read on its own as soon as its data-ready pulse arrives;
+// otherwise call mpu6050_async_start to read them all. A device that is
+// ready again before the others have delivered doesn't wait for them: the
+// frame goes out as it is, with fresh marking who has a new sample in it.
+// Once mpu6050_async_init has run, don't use the blocking calls.
+// Devices with the FIFO on (mpu6050_fifo_enable, before mpu6050_async_init)
+// are drained by mpu6050_async_start instead, up to MPU6050_BATCH_MAX
+// records each into the batch; the rest stay queued for the next drain.
+#define MPU6050_SAMPLE_USEC 1000    // sample period set by mpu6050_init_all
+#define MPU6050_BATCH_MAX   16
+
+struct mpu6050_frame {
+    struct mpu6050_sample imu[MPU6050_MAX_DEVS] ;
+    unsigned int stamp[MPU6050_MAX_DEVS] ;  // timerawl when each sample was latched
+    unsigned int time ;     // timerawl when the last device finished
+    unsigned int errors ;   // bit per device whose read aborted (old data kept)
+    unsigned int fresh ;    // bit per device with a new sample in this frame
+} ;
+
+void mpu6050_async_init(struct mpu6050_dev *devs, int n, void (*callback)(void)) ;
+int mpu6050_async_start(void) ;
+const struct mpu6050_frame *mpu6050_async_frame(void) ;
+unsigned int mpu6050_async_count(void) ;
+
+struct mpu6050_batch {
+    struct mpu6050_sample imu[MPU6050_MAX_DEVS][MPU6050_BATCH_MAX] ;  // oldest first
+    int count[MPU6050_MAX_DEVS] ;   // records drained from each device
+    unsigned int overflows ;        // bit per device whose FIFO overflowed (and was reset)
+} ;
+
+const struct mpu6050_batch *mpu6050_async_batch(void) ;
+unsigned int mpu6050_async_aborts(void) ;
+
+// Lock-free single-producer/single-consumer queue of frames. The producer
+// (normally the async callback) only writes head, the consumer only writes
+// tail, so neither side needs a lock, on one core or across both.
+// A full ring drops the new frame and counts it in overflows
+#define MPU6050_RING_SIZE 16        // power of two
+
+struct mpu6050_ring {
+    struct mpu6050_frame slot[MPU6050_RING_SIZE] ;
+    volatile unsigned int head ;        // frames pushed
+    volatile unsigned int tail ;        // frames popped
+    volatile unsigned int overflows ;   // frames dropped because the ring was full
+    volatile unsigned int high_water ;  // most frames ever waiting
+} ;
+
+int mpu6050_ring_push(struct mpu6050_ring *r, const struct mpu6050_frame *f) ;
+int mpu6050_ring_pop(struct mpu6050_ring *r, struct mpu6050_frame *f) ;
+
+// Hardware FIFO batching. mpu6050_fifo_read is the blocking drain, for
+// use before mpu6050_async_init
+void mpu6050_fifo_enable(struct mpu6050_dev *dev) ;
+void mpu6050_fifo_disable(struct mpu6050_dev *dev) ;
+int mpu6050_fifo_read(struct mpu6050_dev *dev, struct mpu6050_sample *samples, int max) ;
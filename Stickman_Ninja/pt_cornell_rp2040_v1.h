@@ -1,915 +1,1372 @@
-/* 
- * File:   pt_cornell_rp2040_v1.h
- * Author: brl4 Briuce Land
- * Bruce R Land, Cornell University
- * Created on Dec 10, 2018
- */
-
-/*
- * Copyright (c) 2004-2005, Swedish Institute of Computer Science.
- * All rights reserved.
- *
- * Redistribution and use in source and binary forms, with or without
- * modification, are permitted provided that the following conditions
- * are met:
- * 1. Redistributions of source code must retain the above copyright
- *    notice, this list of conditions and the following disclaimer.
- * 2. Redistributions in binary form must reproduce the above copyright
- *    notice, this list of conditions and the following disclaimer in the
- *    documentation and/or other materials provided with the distribution.
- * 3. Neither the name of the Institute nor the names of its contributors
- *    may be used to endorse or promote products derived from this software
- *    without specific prior written permission.
- *
- * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
- * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
- * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
- * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
- * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
- * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
- * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
- * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
- * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
- * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
- * SUCH DAMAGE.
- *
- * This file is part of the Contiki operating system.
- *
- * Author: Adam Dunkels <adam@sics.se>
- *
- * $Id: pt.h,v 1.7 2006/10/02 07:52:56 adam Exp $
- */
-/**
- * \addtogroup pt
- * @{
- */
-
-/**
- * \file
- * Protothreads implementation.
- * \author
- * Adam Dunkels <adam@sics.se>
- *
- */
-
-#ifndef __PT_H__
-#define __PT_H__
-
-////////////////////////
-//#include "lc.h"
-////////////////////////
-/**
- * \file lc.h
- * Local continuations
- * \author
- * Adam Dunkels <adam@sics.se>
- *
- */
-
-#ifdef DOXYGEN
-/**
- * Initialize a local continuation.
- *
- * This operation initializes the local continuation, thereby
- * unsetting any previously set continuation state.
- *
- * \hideinitializer
- */
-#define LC_INIT(lc)
-
-/**
- * Set a local continuation.
- *
- * The set operation saves the state of the function at the point
- * where the operation is executed. As far as the set operation is
- * concerned, the state of the function does <b>not</b> include the
- * call-stack or local (automatic) variables, but only the program
- * counter and such CPU registers that needs to be saved.
- *
- * \hideinitializer
- */
-#define LC_SET(lc)
-
-/**
- * Resume a local continuation.
- *
- * The resume operation resumes a previously set local continuation, thus
- * restoring the state in which the function was when the local
- * continuation was set. If the local continuation has not been
- * previously set, the resume operation does nothing.
- *
- * \hideinitializer
- */
-#define LC_RESUME(lc)
-
-/**
- * Mark the end of local continuation usage.
- *
- * The end operation signifies that local continuations should not be
- * used any more in the function. This operation is not needed for
- * most implementations of local continuation, but is required by a
- * few implementations.
- *
- * \hideinitializer 
- */
-#define LC_END(lc)
-
-/**
- * \var typedef lc_t;
- *
- * The local continuation type.
- *
- * \hideinitializer
- */
-#endif /* DOXYGEN */
-
-//#ifndef __LC_H__
-//#define __LC_H__
-
-
-//#ifdef LC_INCLUDE
-//#include LC_INCLUDE
-//#else
-
-/////////////////////////////
-//#include "lc-switch.h"
-/////////////////////////////
-
-//#ifndef __LC_SWITCH_H__
-//#define __LC_SWITCH_H__
-
-/* WARNING! lc implementation using switch() does not work if an
-   LC_SET() is done within another switch() statement! */
-
-/** \hideinitializer */
-/*
-typedef unsigned short lc_t;
-
-#define LC_INIT(s) s = 0;
-
-#define LC_RESUME(s) switch(s) { case 0:
-
-#define LC_SET(s) s = __LINE__; case __LINE__:
-
-#define LC_END(s) }
-
-#endif /* __LC_SWITCH_H__ */
-
-/** @} */
-
-//#endif /* LC_INCLUDE */
-
-//#endif /* __LC_H__ */
-
-/** @} */
-/** @} */
-
-/////////////////////////////
-//#include "lc-addrlabels.h"
-/////////////////////////////
-
-#ifndef __LC_ADDRLABELS_H__
-#define __LC_ADDRLABELS_H__
-
-/** \hideinitializer */
-typedef void * lc_t;
-
-#define LC_INIT(s) s = NULL
-
-#define LC_RESUME(s)        \
-  do {            \
-    if(s != NULL) {       \
-      goto *s;          \
-    }           \
-  } while(0)
-
-#define LC_CONCAT2(s1, s2) s1##s2
-#define LC_CONCAT(s1, s2) LC_CONCAT2(s1, s2)
-
-#define LC_SET(s)       \
-  do {            \
-    LC_CONCAT(LC_LABEL, __LINE__):            \
-    (s) = &&LC_CONCAT(LC_LABEL, __LINE__);  \
-  } while(0)
-
-#define LC_END(s)
-
-#endif /* __LC_ADDRLABELS_H__ */
-
-//////////////////////////////////////////
-struct pt {
-  lc_t lc;
-};
-
-#define PT_WAITING 0
-#define PT_YIELDED 1
-#define PT_EXITED  2
-#define PT_ENDED   3
-
-/**
- * \name Initialization
- * @{
- */
-
-/**
- * Initialize a protothread.
- *
- * Initializes a protothread. Initialization must be done prior to
- * starting to execute the protothread.
- *
- * \param pt A pointer to the protothread control structure.
- *
- * \sa PT_SPAWN()
- *
- * \hideinitializer
- */
-#define PT_INIT(pt)   LC_INIT((pt)->lc)
-
-/** @} */
-
-/**
- * \name Declaration and definition
- * @{
- */
-
-/**
- * Declaration of a protothread.
- *
- * This macro is used to declare a protothread. All protothreads must
- * be declared with this macro.
- *
- * \param name_args The name and arguments of the C function
- * implementing the protothread.
- *
- * \hideinitializer
- */
-#define PT_THREAD(name_args) char name_args
-
-/**
- * Declare the start of a protothread inside the C function
- * implementing the protothread.
- *
- * This macro is used to declare the starting point of a
- * protothread. It should be placed at the start of the function in
- * which the protothread runs. All C statements above the PT_BEGIN()
- * invokation will be executed each time the protothread is scheduled.
- *
- * \param pt A pointer to the protothread control structure.
- *
- * \hideinitializer
- */
-#define PT_BEGIN(pt) { char PT_YIELD_FLAG = 1; LC_RESUME((pt)->lc)
-
-/**
- * Declare the end of a protothread.
- *
- * This macro is used for declaring that a protothread ends. It must
- * always be used together with a matching PT_BEGIN() macro.
- *
- * \param pt A pointer to the protothread control structure.
- *
- * \hideinitializer
- */
-#define PT_END(pt) LC_END((pt)->lc); PT_YIELD_FLAG = 0; \
-                   PT_INIT(pt); return PT_ENDED; }
-
-/** @} */
-
-/**
- * \name Blocked wait
- * @{
- */
-
-/**
- * Block and wait until condition is true.
- *
- * This macro blocks the protothread until the specified condition is
- * true.
- *
- * \param pt A pointer to the protothread control structure.
- * \param condition The condition.
- *
- * \hideinitializer
- */
-#define PT_WAIT_UNTIL(pt, condition)          \
-  do {            \
-    LC_SET((pt)->lc);       \
-    if(!(condition)) {        \
-      return PT_WAITING;      \
-    }           \
-  } while(0)
-
-/**
- * Block and wait while condition is true.
- *
- * This function blocks and waits while condition is true. See
- * PT_WAIT_UNTIL().
- *
- * \param pt A pointer to the protothread control structure.
- * \param cond The condition.
- *
- * \hideinitializer
- */
-#define PT_WAIT_WHILE(pt, cond)  PT_WAIT_UNTIL((pt), !(cond))
-
-/** @} */
-
-/**
- * \name Hierarchical protothreads
- * @{
- */
-
-/**
- * Block and wait until a child protothread completes.
- *
- * This macro schedules a child protothread. The current protothread
- * will block until the child protothread completes.
- *
- * \note The child protothread must be manually initialized with the
- * PT_INIT() function before this function is used.
- *
- * \param pt A pointer to the protothread control structure.
- * \param thread The child protothread with arguments
- *
- * \sa PT_SPAWN()
- *
- * \hideinitializer
- */
-#define PT_WAIT_THREAD(pt, thread) PT_WAIT_WHILE((pt), PT_SCHEDULE(thread))
-
-/**
- * Spawn a child protothread and wait until it exits.
- *
- * This macro spawns a child protothread and waits until it exits. The
- * macro can only be used within a protothread.
- *
- * \param pt A pointer to the protothread control structure.
- * \param child A pointer to the child protothread's control structure.
- * \param thread The child protothread with arguments
- *
- * \hideinitializer
- */
-#define PT_SPAWN(pt, child, thread)   \
-  do {            \
-    PT_INIT((child));       \
-    PT_WAIT_THREAD((pt), (thread));   \
-  } while(0)
-
-/** @} */
-
-/**
- * \name Exiting and restarting
- * @{
- */
-
-/**
- * Restart the protothread.
- *
- * This macro will block and cause the running protothread to restart
- * its execution at the place of the PT_BEGIN() call.
- *
- * \param pt A pointer to the protothread control structure.
- *
- * \hideinitializer
- */
-#define PT_RESTART(pt)        \
-  do {            \
-    PT_INIT(pt);        \
-    return PT_WAITING;      \
-  } while(0)
-
-/**
- * Exit the protothread.
- *
- * This macro causes the protothread to exit. If the protothread was
- * spawned by another protothread, the parent protothread will become
- * unblocked and can continue to run.
- *
- * \param pt A pointer to the protothread control structure.
- *
- * \hideinitializer
- */
-#define PT_EXIT(pt)       \
-  do {            \
-    PT_INIT(pt);        \
-    return PT_EXITED;     \
-  } while(0)
-
-/** @} */
-
-/**
- * \name Calling a protothread
- * @{
- */
-
-/**
- * Schedule a protothread.
- *
- * This function shedules a protothread. The return value of the
- * function is non-zero if the protothread is running or zero if the
- * protothread has exited.
- *
- * \param f The call to the C function implementing the protothread to
- * be scheduled
- *
- * \hideinitializer
- */
-#define PT_SCHEDULE(f) ((f) < PT_EXITED)
-//#define PT_SCHEDULE(f) ((f))
-
-/** @} */
-
-/**
- * \name Yielding from a protothread
- * @{
- */
-
-/**
- * Yield from the current protothread.
- *
- * This function will yield the protothread, thereby allowing other
- * processing to take place in the system.
- *
- * \param pt A pointer to the protothread control structure.
- *
- * \hideinitializer
- */
-#define PT_YIELD(pt)        \
-  do {            \
-    PT_YIELD_FLAG = 0;        \
-    LC_SET((pt)->lc);       \
-    if(PT_YIELD_FLAG == 0) {      \
-      return PT_YIELDED;      \
-    }           \
-  } while(0)
-
-/**
- * \brief      Yield from the protothread until a condition occurs.
- * \param pt   A pointer to the protothread control structure.
- * \param cond The condition.
- *
- *             This function will yield the protothread, until the
- *             specified condition evaluates to true.
- *
- *
- * \hideinitializer
- */
-
-#define PT_YIELD_UNTIL(pt, cond)    \
-  do {            \
-    PT_YIELD_FLAG = 0;        \
-    LC_SET((pt)->lc);       \
-    if((PT_YIELD_FLAG == 0) || !(cond)) { \
-      return PT_YIELDED;                        \
-    }           \
-  } while(0)
-
-/** @} */
-
-#endif /* __PT_H__ */
-
-#ifndef __PT_SEM_H__
-#define __PT_SEM_H__
-
-//#include "pt.h"
-
-struct pt_sem {
-  unsigned int count;
-};
-
-/**
- * Initialize a semaphore
- *
- * This macro initializes a semaphore with a value for the
- * counter. Internally, the semaphores use an "unsigned int" to
- * represent the counter, and therefore the "count" argument should be
- * within range of an unsigned int.
- *
- * \param s (struct pt_sem *) A pointer to the pt_sem struct
- * representing the semaphore
- *
- * \param c (unsigned int) The initial count of the semaphore.
- * \hide initializer
- */
-// NOTE that the default semaphore is not
-// multi-core safe, but is OK one one core
-
-#define PT_SEM_INIT(s, c) (s)->count = c
-
-/**
- * Wait for a semaphore
- *
- * This macro carries out the "wait" operation on the semaphore. The
- * wait operation causes the protothread to block while the counter is
- * zero. When the counter reaches a value larger than zero, the
- * protothread will continue.
- *
- * \param pt (struct pt *) A pointer to the protothread (struct pt) in
- * which the operation is executed.
- *
- * \param s (struct pt_sem *) A pointer to the pt_sem struct
- * representing the semaphore
- *
- * \hideinitializer
- */
-#define PT_SEM_WAIT(pt, s)  \
-  do {            \
-    PT_YIELD_UNTIL(pt, (s)->count > 0);   \
-    --(s)->count;       \
-  } while(0)
-
-/**
- * Signal a semaphore
- *
- * This macro carries out the "signal" operation on the semaphore. The
- * signal operation increments the counter inside the semaphore, which
- * eventually will cause waiting protothreads to continue executing.
- *
- * \param pt (struct pt *) A pointer to the protothread (struct pt) in
- * which the operation is executed.
- *
- * \param s (struct pt_sem *) A pointer to the pt_sem struct
- * representing the semaphore
- *
- * \hideinitializer
- */
-#define PT_SEM_SIGNAL(pt, s) ++(s)->count
-
-#endif /* __PT_SEM_H__ */
-
-//=====================================================================
-//=== BRL4 additions for rp2040 =======================================
-//=====================================================================
-
-// macro to make a thread execution pause in usec
-// max time of about one hour
-#define PT_YIELD_usec(delay_time)  \
-    do { static unsigned int time_thread ;\
-    time_thread = timer_hw->timerawl + (unsigned int)delay_time ; \
-    PT_YIELD_UNTIL(pt, (timer_hw->timerawl >= time_thread)); \
-    } while(0);
-
-// macro to return system time
-#define PT_GET_TIME_usec() (timer_hw->timerawl)
-
-// macros for interval yield
-// attempts to make interval equal to specified value
-#define PT_INTERVAL_INIT() static unsigned int pt_interval_marker
-//
-#define PT_YIELD_INTERVAL(interval_time)  \
-    do { \
-    PT_YIELD_UNTIL(pt, (timer_hw->timerawl >= pt_interval_marker)); \
-    pt_interval_marker = timer_hw->timerawl + (unsigned int)interval_time; \
-    } while(0);
-//
-// =================================================================
-// core-safe semaphore based on hardware/sync library
-// a hardware spinlock to force core-safe alternation
-// NOTE that the default semaphore is not
-// multi-core safe, but is OK one one core
-// The SAFE versions work across cores, but have more overhead
-
-spin_lock_t * sem_lock ;
-
-#define PT_SEM_SAFE_INIT(s,c) do{ \
-  sem_lock = spin_lock_init(25); \
-  spin_lock_unsafe_blocking (sem_lock); \
-  (s)->count = c ; \
-  spin_unlock_unsafe (sem_lock); \
-} while(0)
-
-#define PT_SEM_SAFE_WAIT(pt,s)  do {  \
-    spin_lock_unsafe_blocking (sem_lock);   \
-    PT_YIELD_FLAG = 0;      \
-    LC_SET((pt)->lc);       \
-    if((PT_YIELD_FLAG == 0) || !((s)->count > 0)) { \
-      spin_unlock_unsafe (sem_lock);  \
-      return PT_YIELDED;      \
-    }   \
-    --(s)->count; \
-    spin_unlock_unsafe (sem_lock);  \
-  } while(0)
-
-#define PT_SEM_SAFE_SIGNAL(pt,s) do{ \
-    spin_lock_unsafe_blocking (sem_lock); \
-    ++(s)->count ; \
-    spin_unlock_unsafe (sem_lock) ; \
-} while(0)
-
-// ==================================================================
-// lock based directly on spin-lock hardware
-// core-safe lock based on hardware/sync library
-// a non-counting hardware spinlock to force core-safe signalling
-#define UNLOCKED 0
-#define LOCKED 1
-spin_lock_t * lock_lock ;
-// general pattern will be to lock lock_lock
-// do specific lock operation (on another spin_lock)
-// unlock lock_lock
-// NOTE vaild lock_num are from 26-31 total of SIX hardware locks!
-
-#define PT_LOCK_INIT(s,lock_num,lock_state) do{ \
-  lock_lock = spin_lock_init(24); \
-  spin_lock_unsafe_blocking (lock_lock); \
-  s = spin_lock_init((uint)lock_num); \
-  if(lock_state) spin_lock_unsafe_blocking (s); \
-  spin_unlock_unsafe (lock_lock) ; \
-} while(0)
-
-#define PT_LOCK_WAIT(pt,s)  do {  \
-  spin_lock_unsafe_blocking (lock_lock); \
-  PT_YIELD_FLAG = 0;        \
-  LC_SET((pt)->lc);       \
-  if((PT_YIELD_FLAG == 0) || !(is_spin_locked(s)==false)) { \
-      spin_unlock_unsafe (lock_lock) ; \
-      return PT_YIELDED;                        \
-  }           \
-  spin_lock_unsafe_blocking (s); \
-  spin_unlock_unsafe (lock_lock) ; \
-} while(0)
-
-#define PT_LOCK_RELEASE(s) do{ \
-    spin_unlock_unsafe (s) ; \
-} while(0)
-
-//====================================================================
-// Multicore communication via FIFO
-#define PT_FIFO_WRITE(data) do{ \
-    PT_YIELD_UNTIL(pt, multicore_fifo_wready()==true); \
-    multicore_fifo_push_blocking(data) ; \
-} while(0)
-
-#define PT_FIFO_READ(fifo_out)  \
-do{ \
-    PT_YIELD_UNTIL(pt, multicore_fifo_rvalid()==true); \
-    fifo_out = multicore_fifo_pop_blocking() ; \
-} while(0) 
-
-
-// clears OUTGOING FIFO for urrent core
-#define PT_FIFO_FLUSH do{ \
-    multicore_fifo_drain() ; \
-} while(0)
-
-//====================================================================
-// IMPROVED SCHEDULER 
-// === thread structures ===
-// thread control structs
-
-// A modified scheduler
-static struct pt pt_sched ;
-// second core
-static struct pt pt_sched1 ;
-
-// count of defined tasks
-int pt_task_count = 0 ;
-int pt_task_count1 = 0 ;
-
-// The task structure
-struct ptx {
-  struct pt pt;              // thread context
-  int num;                    // thread number
-  char (*pf)(struct pt *pt); // pointer to thread function
-};
-
-// === extended structure for scheduler ===============
-// an array of task structures
-#define MAX_THREADS 10
-static struct ptx pt_thread_list[MAX_THREADS];
-// core 1
-static struct ptx pt_thread_list1[MAX_THREADS];
-
-// see https://github.com/edartuz/c-ptx/tree/master/src
-// and the license above
-// add an entry to the thread list
-//struct ptx *pt_add( char (*pf)(struct pt *pt), int rate) {
-int pt_add( char (*pf)(struct pt *pt)) {
-  if (pt_task_count < (MAX_THREADS)) {
-        // get the current thread table entry 
-    struct ptx *ptx = &pt_thread_list[pt_task_count];
-        // enter the tak data into the thread table
-    ptx->num   = pt_task_count;
-        // function pointer
-    ptx->pf    = pf;
-    //
-    PT_INIT( &ptx->pt );
-        // count of number of defined threads
-    pt_task_count++;
-        // return current entry
-        return pt_task_count-1;
-  }
-  return 0;
-}
-
-// core 1 -- add an entry to the thread list
-//struct ptx *pt_add( char (*pf)(struct pt *pt), int rate) {
-int pt_add1( char (*pf)(struct pt *pt)) {
-  if (pt_task_count1 < (MAX_THREADS)) {
-        // get the current thread table entry 
-    struct ptx *ptx = &pt_thread_list1[pt_task_count1];
-        // enter the tak data into the thread table
-    ptx->num   = pt_task_count1;
-        // function pointer
-    ptx->pf    = pf;
-    //
-    PT_INIT( &ptx->pt );
-        // count of number of defined threads
-    pt_task_count1++;
-        // return current entry
-        return pt_task_count1-1;
-  }
-  return 0;
-}
-
-/* Scheduler
-Copyright (c) 2014 edartuz
-
-Permission is hereby granted, free of charge, to any person obtaining a copy
-of this software and associated documentation files (the "Software"), to deal
-in the Software without restriction, including without limitation the rights
-to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
-copies of the Software, and to permit persons to whom the Software is
-furnished to do so, subject to the following conditions:
-
-The above copyright notice and this permission notice shall be included in all
-copies or substantial portions of the Software.
-
-THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
-IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
-FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
-AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
-LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
-OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
-SOFTWARE.
-*/
-// === Scheduler Thread =================================================
-// update a 1 second tick counter
-// schedulser code was almost copied from
-// https://github.com/edartuz/c-ptx
-// see license above
-
-// choose schedule method
-#define SCHED_ROUND_ROBIN 0
-#define SCHED_RATE 1
-int pt_sched_method = SCHED_ROUND_ROBIN ;
-
-static PT_THREAD (protothread_sched(struct pt *pt))
-{   
-    PT_BEGIN(pt);
-    static int i, rate;
-    
-    if (pt_sched_method==SCHED_ROUND_ROBIN){
-        while(1) {
-          // test stupid round-robin 
-          // on all defined threads
-          struct ptx *ptx = &pt_thread_list[0];
-          // step thru all defined threads
-          // -- loop can have more than one initialization or increment/decrement, 
-          // -- separated using comma operator. But it can have only one condition.
-          for (i=0; i<pt_task_count; i++, ptx++ ){
-              // call thread function
-              (pt_thread_list[i].pf)(&ptx->pt); 
-          }
-          // Never yields! 
-          // NEVER exit while!
-        } // END WHILE(1)
-    } //end if (pt_sched_method==RR)       
-     
-    PT_END(pt);
-} // scheduler thread
-
-// ================================================
-// === second core scheduler
-static PT_THREAD (protothread_sched1(struct pt *pt))
-{   
-    PT_BEGIN(pt);
-    
-    static int i, rate;
-    
-    if (pt_sched_method==SCHED_ROUND_ROBIN){
-        while(1) {
-          // test stupid round-robin 
-          // on all defined threads
-          struct ptx *ptx = &pt_thread_list1[0];
-          // step thru all defined threads
-          // -- loop can have more than one initialization or increment/decrement, 
-          // -- separated using comma operator. But it can have only one condition.
-          for (i=0; i<pt_task_count1; i++, ptx++ ){
-              // call thread function
-              (pt_thread_list1[i].pf)(&ptx->pt); 
-          }
-          // Never yields! 
-          // NEVER exit while!
-        } // END WHILE(1)
-    } // end if(pt_sched_method==SCHED_ROUND_ROBIN)      
-     
-    PT_END(pt);
-} // scheduler1 thread
-
-// ========================================================
-// === package the schedulers =============================
-#define pt_schedule_start do{\
-  if(get_core_num()==1){ \
-    PT_INIT(&pt_sched1) ; \
-    PT_SCHEDULE(protothread_sched1(&pt_sched1));\
-  }  else {\
-    PT_INIT(&pt_sched) ;\
-    PT_SCHEDULE(protothread_sched(&pt_sched));\
-  }\
-} while(0) 
-
-// === package the add thread ==========================
-#define pt_add_thread(thread_name) do{\
-  if(get_core_num()==1){ \
-    pt_add1(thread_name);\
-  }  else {\
-    pt_add(thread_name);\
-  }\
-} while(0) 
-
-// === serial input thread ================================
-// serial buffers
-#define pt_buffer_size 100
-char pt_serial_in_buffer[pt_buffer_size];
-char pt_serial_out_buffer[pt_buffer_size];
-// thread pointers
-static struct pt pt_serialin, pt_serialout ;
-// uart
-#define UART_ID uart0
-//
-#define pt_backspace 0x7f // make sure your backspace matches this!
-//
-static PT_THREAD (pt_serialin_polled(struct pt *pt)){
-    PT_BEGIN(pt);
-      static uint8_t ch ;
-      static int pt_current_char_count ;
-      // clear the string
-      memset(pt_serial_in_buffer, 0, pt_buffer_size);
-      pt_current_char_count = 0 ;
-      // clear uart fifo
-      while(uart_is_readable(UART_ID)){uart_getc(UART_ID);}
-      // build the output string
-      while(pt_current_char_count < pt_buffer_size) {   
-        PT_YIELD_UNTIL(pt, (int)uart_is_readable(UART_ID)) ;
-        //get the character and echo it back to terminal
-        // NOTE this assumes a human is typing!!
-        ch = uart_getc(UART_ID);
-        PT_YIELD_UNTIL(pt, (int)uart_is_writable(UART_ID)) ;
-        uart_putc(UART_ID, ch);
-        // check for <enter> or <backspace>
-        if (ch == '\r' ){
-          // <enter>> character terminates string,
-          // advances the cursor to the next line, then exits
-          pt_serial_in_buffer[pt_current_char_count] = 0 ;
-          PT_YIELD_UNTIL(pt, (int)uart_is_writable(UART_ID)) ;
-          uart_putc(UART_ID, '\n') ;
-          break ; 
-        }
-        // check fo ,backspace>
-        else if (ch == pt_backspace){
-          PT_YIELD_UNTIL(pt, (int)uart_is_writable(UART_ID)) ;
-          uart_putc(UART_ID, ' ') ;
-          PT_YIELD_UNTIL(pt, (int)uart_is_writable(UART_ID)) ;
-          uart_putc(UART_ID, pt_backspace) ;
-          //uart_putc(UART_ID, ' ') ;
-          // wipe a character from the output
-          pt_current_char_count-- ;
-          if (pt_current_char_count<0) {pt_current_char_count = 0 ;}
-        }
-        // must be a real character
-        else {
-          // build the output string
-          pt_serial_in_buffer[pt_current_char_count++] = ch ;
-        }
-      } // END WHILe
-      // kill this input thread, to allow spawning thread to execute
-    PT_EXIT(pt);
-  PT_END(pt);
-} // serial input thread
-
-// ================================================================
-// === serial output thread
-//
-int pt_serialout_polled(struct pt *pt)
-{
-    static int num_send_chars ;
-    PT_BEGIN(pt);
-    num_send_chars = 0;
-    while (pt_serial_out_buffer[num_send_chars] != 0){
-        PT_YIELD_UNTIL(pt, (int)uart_is_writable(UART_ID)) ;
-        uart_putc(UART_ID, pt_serial_out_buffer[num_send_chars]) ;
-        num_send_chars++;
-    }
-    // kill this output thread, to allow spawning thread to execute
-    PT_EXIT(pt);
-    // and indicate the end of the thread
-    PT_END(pt);
-}
-// ================================================================
-// package the spawn read/write macros to make them look better
-#define serial_write do{PT_SPAWN(pt,&pt_serialout,pt_serialout_polled(&pt_serialout));}while(0)
-#define serial_read  do{PT_SPAWN(pt,&pt_serialin,pt_serialin_polled(&pt_serialin));}while(0)
-//
-// ======
-// END
+/* 
+ * File:   pt_cornell_rp2040_v1.h
+ * Author: brl4 Briuce Land
+ * Bruce R Land, Cornell University
+ * Created on Dec 10, 2018
+ */
+
+/*
+ * Copyright (c) 2004-2005, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ * Author: Adam Dunkels <adam@sics.se>
+ *
+ * $Id: pt.h,v 1.7 2006/10/02 07:52:56 adam Exp $
+ */
+/**
+ * \addtogroup pt
+ * @{
+ */
+
+/**
+ * \file
+ * Protothreads implementation.
+ * \author
+ * Adam Dunkels <adam@sics.se>
+ *
+ */
+
+#ifndef __PT_H__
+#define __PT_H__
+
+////////////////////////
+//#include "lc.h"
+////////////////////////
+/**
+ * \file lc.h
+ * Local continuations
+ * \author
+ * Adam Dunkels <adam@sics.se>
+ *
+ */
+
+#ifdef DOXYGEN
+/**
+ * Initialize a local continuation.
+ *
+ * This operation initializes the local continuation, thereby
+ * unsetting any previously set continuation state.
+ *
+ * \hideinitializer
+ */
+#define LC_INIT(lc)
+
+/**
+ * Set a local continuation.
+ *
+ * The set operation saves the state of the function at the point
+ * where the operation is executed. As far as the set operation is
+ * concerned, the state of the function does <b>not</b> include the
+ * call-stack or local (automatic) variables, but only the program
+ * counter and such CPU registers that needs to be saved.
+ *
+ * \hideinitializer
+ */
+#define LC_SET(lc)
+
+/**
+ * Resume a local continuation.
+ *
+ * The resume operation resumes a previously set local continuation, thus
+ * restoring the state in which the function was when the local
+ * continuation was set. If the local continuation has not been
+ * previously set, the resume operation does nothing.
+ *
+ * \hideinitializer
+ */
+#define LC_RESUME(lc)
+
+/**
+ * Mark the end of local continuation usage.
+ *
+ * The end operation signifies that local continuations should not be
+ * used any more in the function. This operation is not needed for
+ * most implementations of local continuation, but is required by a
+ * few implementations.
+ *
+ * \hideinitializer 
+ */
+#define LC_END(lc)
+
+/**
+ * \var typedef lc_t;
+ *
+ * The local continuation type.
+ *
+ * \hideinitializer
+ */
+#endif /* DOXYGEN */
+
+//#ifndef __LC_H__
+//#define __LC_H__
+
+
+//#ifdef LC_INCLUDE
+//#include LC_INCLUDE
+//#else
+
+/////////////////////////////
+//#include "lc-switch.h"
+/////////////////////////////
+
+//#ifndef __LC_SWITCH_H__
+//#define __LC_SWITCH_H__
+
+/* WARNING! lc implementation using switch() does not work if an
+   LC_SET() is done within another switch() statement! */
+
+/** \hideinitializer */
+/*
+typedef unsigned short lc_t;
+
+#define LC_INIT(s) s = 0;
+
+#define LC_RESUME(s) switch(s) { case 0:
+
+#define LC_SET(s) s = __LINE__; case __LINE__:
+
+#define LC_END(s) }
+
+#endif /* __LC_SWITCH_H__ */
+
+/** @} */
+
+//#endif /* LC_INCLUDE */
+
+//#endif /* __LC_H__ */
+
+/** @} */
+/** @} */
+
+/////////////////////////////
+//#include "lc-addrlabels.h"
+/////////////////////////////
+
+#ifndef __LC_ADDRLABELS_H__
+#define __LC_ADDRLABELS_H__
+
+/** \hideinitializer */
+typedef void * lc_t;
+
+#define LC_INIT(s) s = NULL
+
+#define LC_RESUME(s)        \
+  do {            \
+    if(s != NULL) {       \
+      goto *s;          \
+    }           \
+  } while(0)
+
+#define LC_CONCAT2(s1, s2) s1##s2
+#define LC_CONCAT(s1, s2) LC_CONCAT2(s1, s2)
+
+#define LC_SET(s)       \
+  do {            \
+    LC_CONCAT(LC_LABEL, __LINE__):            \
+    (s) = &&LC_CONCAT(LC_LABEL, __LINE__);  \
+  } while(0)
+
+#define LC_END(s)
+
+#endif /* __LC_ADDRLABELS_H__ */
+
+//////////////////////////////////////////
+struct pt {
+  lc_t lc;
+};
+
+#define PT_WAITING 0
+#define PT_YIELDED 1
+#define PT_EXITED  2
+#define PT_ENDED   3
+
+/**
+ * \name Initialization
+ * @{
+ */
+
+/**
+ * Initialize a protothread.
+ *
+ * Initializes a protothread. Initialization must be done prior to
+ * starting to execute the protothread.
+ *
+ * \param pt A pointer to the protothread control structure.
+ *
+ * \sa PT_SPAWN()
+ *
+ * \hideinitializer
+ */
+#define PT_INIT(pt)   LC_INIT((pt)->lc)
+
+/** @} */
+
+/**
+ * \name Declaration and definition
+ * @{
+ */
+
+/**
+ * Declaration of a protothread.
+ *
+ * This macro is used to declare a protothread. All protothreads must
+ * be declared with this macro.
+ *
+ * \param name_args The name and arguments of the C function
+ * implementing the protothread.
+ *
+ * \hideinitializer
+ */
+#define PT_THREAD(name_args) char name_args
+
+/**
+ * Declare the start of a protothread inside the C function
+ * implementing the protothread.
+ *
+ * This macro is used to declare the starting point of a
+ * protothread. It should be placed at the start of the function in
+ * which the protothread runs. All C statements above the PT_BEGIN()
+ * invokation will be executed each time the protothread is scheduled.
+ *
+ * \param pt A pointer to the protothread control structure.
+ *
+ * \hideinitializer
+ */
+#define PT_BEGIN(pt) { char PT_YIELD_FLAG = 1; LC_RESUME((pt)->lc)
+
+/**
+ * Declare the end of a protothread.
+ *
+ * This macro is used for declaring that a protothread ends. It must
+ * always be used together with a matching PT_BEGIN() macro.
+ *
+ * \param pt A pointer to the protothread control structure.
+ *
+ * \hideinitializer
+ */
+#define PT_END(pt) LC_END((pt)->lc); PT_YIELD_FLAG = 0; \
+                   PT_INIT(pt); return PT_ENDED; }
+
+/** @} */
+
+/**
+ * \name Blocked wait
+ * @{
+ */
+
+/**
+ * Block and wait until condition is true.
+ *
+ * This macro blocks the protothread until the specified condition is
+ * true.
+ *
+ * \param pt A pointer to the protothread control structure.
+ * \param condition The condition.
+ *
+ * \hideinitializer
+ */
+#define PT_WAIT_UNTIL(pt, condition)          \
+  do {            \
+    LC_SET((pt)->lc);       \
+    if(!(condition)) {        \
+      return PT_WAITING;      \
+    }           \
+  } while(0)
+
+/**
+ * Block and wait while condition is true.
+ *
+ * This function blocks and waits while condition is true. See
+ * PT_WAIT_UNTIL().
+ *
+ * \param pt A pointer to the protothread control structure.
+ * \param cond The condition.
+ *
+ * \hideinitializer
+ */
+#define PT_WAIT_WHILE(pt, cond)  PT_WAIT_UNTIL((pt), !(cond))
+
+/** @} */
+
+/**
+ * \name Hierarchical protothreads
+ * @{
+ */
+
+/**
+ * Block and wait until a child protothread completes.
+ *
+ * This macro schedules a child protothread. The current protothread
+ * will block until the child protothread completes.
+ *
+ * \note The child protothread must be manually initialized with the
+ * PT_INIT() function before this function is used.
+ *
+ * \param pt A pointer to the protothread control structure.
+ * \param thread The child protothread with arguments
+ *
+ * \sa PT_SPAWN()
+ *
+ * \hideinitializer
+ */
+#define PT_WAIT_THREAD(pt, thread) PT_WAIT_WHILE((pt), PT_SCHEDULE(thread))
+
+/**
+ * Spawn a child protothread and wait until it exits.
+ *
+ * This macro spawns a child protothread and waits until it exits. The
+ * macro can only be used within a protothread.
+ *
+ * \param pt A pointer to the protothread control structure.
+ * \param child A pointer to the child protothread's control structure.
+ * \param thread The child protothread with arguments
+ *
+ * \hideinitializer
+ */
+#define PT_SPAWN(pt, child, thread)   \
+  do {            \
+    PT_INIT((child));       \
+    PT_WAIT_THREAD((pt), (thread));   \
+  } while(0)
+
+/** @} */
+
+/**
+ * \name Exiting and restarting
+ * @{
+ */
+
+/**
+ * Restart the protothread.
+ *
+ * This macro will block and cause the running protothread to restart
+ * its execution at the place of the PT_BEGIN() call.
+ *
+ * \param pt A pointer to the protothread control structure.
+ *
+ * \hideinitializer
+ */
+#define PT_RESTART(pt)        \
+  do {            \
+    PT_INIT(pt);        \
+    return PT_WAITING;      \
+  } while(0)
+
+/**
+ * Exit the protothread.
+ *
+ * This macro causes the protothread to exit. If the protothread was
+ * spawned by another protothread, the parent protothread will become
+ * unblocked and can continue to run.
+ *
+ * \param pt A pointer to the protothread control structure.
+ *
+ * \hideinitializer
+ */
+#define PT_EXIT(pt)       \
+  do {            \
+    PT_INIT(pt);        \
+    return PT_EXITED;     \
+  } while(0)
+
+/** @} */
+
+/**
+ * \name Calling a protothread
+ * @{
+ */
+
+/**
+ * Schedule a protothread.
+ *
+ * This function shedules a protothread. The return value of the
+ * function is non-zero if the protothread is running or zero if the
+ * protothread has exited.
+ *
+ * \param f The call to the C function implementing the protothread to
+ * be scheduled
+ *
+ * \hideinitializer
+ */
+#define PT_SCHEDULE(f) ((f) < PT_EXITED)
+//#define PT_SCHEDULE(f) ((f))
+
+/** @} */
+
+/**
+ * \name Yielding from a protothread
+ * @{
+ */
+
+/**
+ * Yield from the current protothread.
+ *
+ * This function will yield the protothread, thereby allowing other
+ * processing to take place in the system.
+ *
+ * \param pt A pointer to the protothread control structure.
+ *
+ * \hideinitializer
+ */
+#define PT_YIELD(pt)        \
+  do {            \
+    PT_YIELD_FLAG = 0;        \
+    LC_SET((pt)->lc);       \
+    if(PT_YIELD_FLAG == 0) {      \
+      return PT_YIELDED;      \
+    }           \
+  } while(0)
+
+/**
+ * \brief      Yield from the protothread until a condition occurs.
+ * \param pt   A pointer to the protothread control structure.
+ * \param cond The condition.
+ *
+ *             This function will yield the protothread, until the
+ *             specified condition evaluates to true.
+ *
+ *
+ * \hideinitializer
+ */
+
+#define PT_YIELD_UNTIL(pt, cond)    \
+  do {            \
+    PT_YIELD_FLAG = 0;        \
+    LC_SET((pt)->lc);       \
+    if((PT_YIELD_FLAG == 0) || !(cond)) { \
+      return PT_YIELDED;                        \
+    }           \
+  } while(0)
+
+/** @} */
+
+#endif /* __PT_H__ */
+
+#ifndef __PT_SEM_H__
+#define __PT_SEM_H__
+
+//#include "pt.h"
+
+struct pt_sem {
+  unsigned int count;
+};
+
+/**
+ * Initialize a semaphore
+ *
+ * This macro initializes a semaphore with a value for the
+ * counter. Internally, the semaphores use an "unsigned int" to
+ * represent the counter, and therefore the "count" argument should be
+ * within range of an unsigned int.
+ *
+ * \param s (struct pt_sem *) A pointer to the pt_sem struct
+ * representing the semaphore
+ *
+ * \param c (unsigned int) The initial count of the semaphore.
+ * \hide initializer
+ */
+// NOTE that the default semaphore is not
+// multi-core safe, but is OK one one core
+
+#define PT_SEM_INIT(s, c) (s)->count = c
+
+/**
+ * Wait for a semaphore
+ *
+ * This macro carries out the "wait" operation on the semaphore. The
+ * wait operation causes the protothread to block while the counter is
+ * zero. When the counter reaches a value larger than zero, the
+ * protothread will continue.
+ *
+ * \param pt (struct pt *) A pointer to the protothread (struct pt) in
+ * which the operation is executed.
+ *
+ * \param s (struct pt_sem *) A pointer to the pt_sem struct
+ * representing the semaphore
+ *
+ * \hideinitializer
+ */
+#define PT_SEM_WAIT(pt, s)  \
+  do {            \
+    PT_YIELD_UNTIL(pt, (s)->count > 0);   \
+    --(s)->count;       \
+  } while(0)
+
+/**
+ * Signal a semaphore
+ *
+ * This macro carries out the "signal" operation on the semaphore. The
+ * signal operation increments the counter inside the semaphore, which
+ * eventually will cause waiting protothreads to continue executing.
+ *
+ * \param pt (struct pt *) A pointer to the protothread (struct pt) in
+ * which the operation is executed.
+ *
+ * \param s (struct pt_sem *) A pointer to the pt_sem struct
+ * representing the semaphore
+ *
+ * \hideinitializer
+ */
+#define PT_SEM_SIGNAL(pt, s) ++(s)->count
+
+#endif /* __PT_SEM_H__ */
+
+//=====================================================================
+//=== BRL4 additions for rp2040 =======================================
+//=====================================================================
+
+// macro to make a thread execution pause in usec
+// max time of about half an hour
+// the scheduler doesn't run the thread again until the time is up, and
+// can sleep the core if nothing else is ready
+#define PT_YIELD_usec(delay_time)  \
+    do { static unsigned int time_thread ;\
+    time_thread = timer_hw->timerawl + (unsigned int)delay_time ; \
+    PT_YIELD_FLAG = 0; \
+    LC_SET((pt)->lc); \
+    if((PT_YIELD_FLAG == 0) || ((int)(timer_hw->timerawl - time_thread) < 0)) { \
+      pt_sleep_until(time_thread); \
+      return PT_YIELDED; \
+    } \
+    } while(0);
+
+// yield until cond, which only changes along with an event: an interrupt
+// or the other core doing __sev(). The thread is still polled, but lets
+// the scheduler sleep the core until the next event
+#define PT_YIELD_UNTIL_EVENT(pt, cond) \
+  do { \
+    PT_YIELD_FLAG = 0; \
+    LC_SET((pt)->lc); \
+    if((PT_YIELD_FLAG == 0) || !(cond)) { \
+      pt_wait_event(); \
+      return PT_YIELDED; \
+    } \
+  } while(0)
+
+// macro to return system time
+#define PT_GET_TIME_usec() (timer_hw->timerawl)
+
+// macros for interval yield
+// attempts to make interval equal to specified value
+#define PT_INTERVAL_INIT() static unsigned int pt_interval_marker
+//
+// usec until the marker; 0 once it has passed. A marker is never set more
+// than one interval ahead, so one further off is stale (never set, or
+// left behind over a clock wrap) and has passed too
+static inline unsigned int pt_interval_left(unsigned int marker, unsigned int interval) {
+  unsigned int left = marker - timer_hw->timerawl;
+  return (left <= interval) ? left : 0;
+}
+//
+#define PT_YIELD_INTERVAL(interval_time)  \
+    do { \
+    PT_YIELD_FLAG = 0; \
+    LC_SET((pt)->lc); \
+    if((PT_YIELD_FLAG == 0) || pt_interval_left(pt_interval_marker, (interval_time))) { \
+      pt_sleep_until(timer_hw->timerawl + pt_interval_left(pt_interval_marker, (interval_time))); \
+      return PT_YIELDED; \
+    } \
+    pt_interval_marker = timer_hw->timerawl + (unsigned int)interval_time; \
+    } while(0);
+//
+// =================================================================
+// core-safe semaphore based on hardware/sync library
+// a hardware spinlock to force core-safe alternation
+// NOTE that the default semaphore is not
+// multi-core safe, but is OK one one core
+// The SAFE versions work across cores, but have more overhead
+
+spin_lock_t * sem_lock ;
+
+#define PT_SEM_SAFE_INIT(s,c) do{ \
+  sem_lock = spin_lock_init(25); \
+  spin_lock_unsafe_blocking (sem_lock); \
+  (s)->count = c ; \
+  spin_unlock_unsafe (sem_lock); \
+} while(0)
+
+#define PT_SEM_SAFE_WAIT(pt,s)  do {  \
+    spin_lock_unsafe_blocking (sem_lock);   \
+    PT_YIELD_FLAG = 0;      \
+    LC_SET((pt)->lc);       \
+    if((PT_YIELD_FLAG == 0) || !((s)->count > 0)) { \
+      spin_unlock_unsafe (sem_lock);  \
+      return PT_YIELDED;      \
+    }   \
+    --(s)->count; \
+    spin_unlock_unsafe (sem_lock);  \
+  } while(0)
+
+#define PT_SEM_SAFE_SIGNAL(pt,s) do{ \
+    spin_lock_unsafe_blocking (sem_lock); \
+    ++(s)->count ; \
+    spin_unlock_unsafe (sem_lock) ; \
+} while(0)
+
+// ==================================================================
+// lock based directly on spin-lock hardware
+// core-safe lock based on hardware/sync library
+// a non-counting hardware spinlock to force core-safe signalling
+#define UNLOCKED 0
+#define LOCKED 1
+spin_lock_t * lock_lock ;
+// general pattern will be to lock lock_lock
+// do specific lock operation (on another spin_lock)
+// unlock lock_lock
+// NOTE vaild lock_num are from 26-31 total of SIX hardware locks!
+
+#define PT_LOCK_INIT(s,lock_num,lock_state) do{ \
+  lock_lock = spin_lock_init(24); \
+  spin_lock_unsafe_blocking (lock_lock); \
+  s = spin_lock_init((uint)lock_num); \
+  if(lock_state) spin_lock_unsafe_blocking (s); \
+  spin_unlock_unsafe (lock_lock) ; \
+} while(0)
+
+#define PT_LOCK_WAIT(pt,s)  do {  \
+  spin_lock_unsafe_blocking (lock_lock); \
+  PT_YIELD_FLAG = 0;        \
+  LC_SET((pt)->lc);       \
+  if((PT_YIELD_FLAG == 0) || !(is_spin_locked(s)==false)) { \
+      spin_unlock_unsafe (lock_lock) ; \
+      return PT_YIELDED;                        \
+  }           \
+  spin_lock_unsafe_blocking (s); \
+  spin_unlock_unsafe (lock_lock) ; \
+} while(0)
+
+#define PT_LOCK_RELEASE(s) do{ \
+    spin_unlock_unsafe (s) ; \
+} while(0)
+
+// ==================================================================
+// cross-core event flags
+// A word of event bits that any thread or ISR, on either core, can raise
+// and a thread can wait for. Raising a bit that is already up only counts
+// as coalesced, so a fast producer can't run the count up. The bits are
+// guarded by a hardware spinlock taken with interrupts off, so an ISR
+// can't deadlock against a thread on its own core. Signalling does
+// __sev(), which wakes a scheduler sleeping on either core.
+// pt_event_init claims a free spinlock for the event, so it can't collide
+// with the ones the SDK or PT_LOCK users pick by number.
+struct pt_event {
+  volatile unsigned int bits;  // raised and not yet taken
+  unsigned int signals;        // signals so far
+  unsigned int coalesced;      // signals whose bits were already up
+  spin_lock_t *lock;
+};
+
+void pt_event_init(struct pt_event *e) {
+  e->lock = spin_lock_init(spin_lock_claim_unused(true));
+  e->bits = 0;
+  e->signals = 0;
+  e->coalesced = 0;
+}
+
+// raise bits -- safe from any thread or ISR on either core
+void pt_event_signal(struct pt_event *e, unsigned int bits) {
+  uint32_t save = spin_lock_blocking(e->lock);
+  if ((e->bits & bits) == bits) e->coalesced++;
+  e->bits |= bits;
+  e->signals++;
+  spin_unlock(e->lock, save);
+  __sev();
+}
+
+// clear and return whichever of the mask bits are up
+unsigned int pt_event_take(struct pt_event *e, unsigned int mask) {
+  uint32_t save;
+  unsigned int got;
+  // unlocked peek first: a word read can't tear, and a bit raised just
+  // after it is seen on the next poll
+  if ((e->bits & mask) == 0) return 0;
+  save = spin_lock_blocking(e->lock);
+  got = e->bits & mask;
+  e->bits &= ~mask;
+  spin_unlock(e->lock, save);
+  return got;
+}
+
+// park until one of the mask bits is up, then take them into got
+#define PT_EVENT_WAIT(pt, e, mask, got) \
+  PT_YIELD_UNTIL_EVENT(pt, ((got) = pt_event_take((e), (mask))) != 0)
+
+//====================================================================
+// Multicore communication via FIFO
+#define PT_FIFO_WRITE(data) do{ \
+    PT_YIELD_UNTIL(pt, multicore_fifo_wready()==true); \
+    multicore_fifo_push_blocking(data) ; \
+} while(0)
+
+#define PT_FIFO_READ(fifo_out)  \
+do{ \
+    PT_YIELD_UNTIL(pt, multicore_fifo_rvalid()==true); \
+    fifo_out = multicore_fifo_pop_blocking() ; \
+} while(0) 
+
+
+// clears OUTGOING FIFO for urrent core
+#define PT_FIFO_FLUSH do{ \
+    multicore_fifo_drain() ; \
+} while(0)
+
+//====================================================================
+// IMPROVED SCHEDULER 
+// === thread structures ===
+// thread control structs
+
+// A modified scheduler
+static struct pt pt_sched ;
+// second core
+static struct pt pt_sched1 ;
+
+// count of defined tasks
+int pt_task_count = 0 ;
+int pt_task_count1 = 0 ;
+
+// === per-thread accounting ==============================
+// Define PT_STATS before including this file to have the schedulers time
+// every call into a thread. Run time is in cycles, from each core's
+// SysTick: a 24-bit down-counter, so a single run longer than 2^24
+// cycles (134 msec at 125 MHz) wraps. Interrupts that land during a run
+// are charged to the thread that was running.
+// Wake latency is usec from when a thread became due -- its wake time,
+// or its release under SCHED_RATE -- to when it was called.
+// Both keep a log2 histogram, good enough for a p99 to within 2x.
+#ifdef PT_STATS
+#include "hardware/structs/systick.h"
+
+#ifndef pt_stats_cycles
+#define pt_stats_cycles() (systick_hw->cvr)
+#endif
+
+#define PT_STATS_BUCKETS 25
+struct pt_stats {
+  unsigned long long cycles;  // total cycles inside the thread
+  unsigned int calls;         // invocations
+  unsigned int run_max;       // longest run between yields, cycles
+  unsigned int run_hist[PT_STATS_BUCKETS];
+  unsigned int wakes;         // calls with a known due time
+  unsigned int wake_max;      // usec
+  unsigned int wake_hist[PT_STATS_BUCKETS];
+};
+#endif
+
+// The task structure
+struct ptx {
+  struct pt pt;              // thread context
+  int num;                    // thread number
+  char (*pf)(struct pt *pt); // pointer to thread function
+  // SCHED_RATE only
+  unsigned int period;        // usec between releases; 0 = always ready
+  unsigned char priority;     // 0 runs first
+  unsigned int release;       // time of the next release
+  unsigned int misses;        // releases that ran late or were skipped
+  // sleeping
+  char waiting;               // PT_RUNNING, PT_SLEEPING or PT_EVENT
+  unsigned int wake;          // PT_SLEEPING: don't run before this time
+#ifdef PT_STATS
+  struct pt_stats stats;
+#endif
+};
+
+// === extended structure for scheduler ===============
+// an array of task structures
+#define MAX_THREADS 10
+static struct ptx pt_thread_list[MAX_THREADS];
+// core 1
+static struct ptx pt_thread_list1[MAX_THREADS];
+
+// SCHED_RATE ready queue: thread numbers in priority order; equal
+// priorities take turns
+static unsigned char pt_order[MAX_THREADS];
+static unsigned char pt_order1[MAX_THREADS];
+
+// priority for threads added without one -- behind every rate thread
+#define PT_PRIORITY_BACKGROUND 255
+
+// SCHED_RATE clock, usec. Override before including for a host build
+#ifndef pt_sched_time
+#define pt_sched_time() (timer_hw->timerawl)
+#endif
+
+// see https://github.com/edartuz/c-ptx/tree/master/src
+// and the license above
+// add an entry to a thread list, keeping the ready queue sorted
+static int pt_add_to(struct ptx *list, unsigned char *order, int *count,
+                     char (*pf)(struct pt *pt), unsigned int period, unsigned char priority) {
+  int k;
+  if (*count < (MAX_THREADS)) {
+        // get the current thread table entry 
+    struct ptx *ptx = &list[*count];
+        // enter the tak data into the thread table
+    ptx->num   = *count;
+        // function pointer
+    ptx->pf    = pf;
+    ptx->period = period;
+    ptx->priority = priority;
+    ptx->release = pt_sched_time();
+    ptx->misses = 0;
+    ptx->waiting = 0;
+#ifdef PT_STATS
+    memset(&ptx->stats, 0, sizeof(ptx->stats));
+#endif
+    //
+    PT_INIT( &ptx->pt );
+        // insert behind every thread of the same or higher priority
+    for (k = *count; k > 0 && list[order[k-1]].priority > priority; k--) {
+      order[k] = order[k-1];
+    }
+    order[k] = *count;
+        // count of number of defined threads
+    (*count)++;
+        // return current entry
+        return *count-1;
+  }
+  return 0;
+}
+
+// add a thread released every period usec at the given priority
+// (SCHED_RATE); plain pt_add threads run whenever nothing else is due
+int pt_add_rate( char (*pf)(struct pt *pt), unsigned int period, unsigned char priority) {
+  return pt_add_to(pt_thread_list, pt_order, &pt_task_count, pf, period, priority);
+}
+
+int pt_add( char (*pf)(struct pt *pt)) {
+  return pt_add_rate(pf, 0, PT_PRIORITY_BACKGROUND);
+}
+
+// core 1 -- add an entry to the thread list
+int pt_add_rate1( char (*pf)(struct pt *pt), unsigned int period, unsigned char priority) {
+  return pt_add_to(pt_thread_list1, pt_order1, &pt_task_count1, pf, period, priority);
+}
+
+int pt_add1( char (*pf)(struct pt *pt)) {
+  return pt_add_rate1(pf, 0, PT_PRIORITY_BACKGROUND);
+}
+
+// deadline misses for thread id on a core (0 for an unused id). Safe to
+// call from either core: the count is one word, written only by that
+// core's scheduler
+unsigned int pt_deadline_misses(int core, int id) {
+  int count = (core==1) ? pt_task_count1 : pt_task_count;
+  if (id < 0 || id >= count) return 0;
+  return (core==1) ? pt_thread_list1[id].misses : pt_thread_list[id].misses;
+}
+
+/* Scheduler
+Copyright (c) 2014 edartuz
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+// === Scheduler Thread =================================================
+// update a 1 second tick counter
+// schedulser code was almost copied from
+// https://github.com/edartuz/c-ptx
+// see license above
+
+// choose schedule method
+#define SCHED_ROUND_ROBIN 0
+#define SCHED_RATE 1
+int pt_sched_method = SCHED_ROUND_ROBIN ;
+
+// === sleeping ===========================================
+// A thread parked in PT_YIELD_usec/PT_YIELD_INTERVAL isn't called again
+// until its wake time. One parked in PT_YIELD_UNTIL_EVENT is still
+// polled, but doesn't keep the core awake. When nothing on a core is
+// ready, the scheduler sleeps (WFE) until the earliest wake time or the
+// next event, and counts that time as idle.
+#define PT_RUNNING  0
+#define PT_SLEEPING 1
+#define PT_EVENT    2
+
+// thread each core's scheduler is running, for the parking macros
+static struct ptx *pt_current[2];
+
+void pt_sleep_until(unsigned int wake) {
+  struct ptx *ptx = pt_current[get_core_num()];
+  if (ptx) {
+    ptx->wake = wake;
+    ptx->waiting = PT_SLEEPING;
+  }
+}
+
+void pt_wait_event(void) {
+  struct ptx *ptx = pt_current[get_core_num()];
+  if (ptx) ptx->waiting = PT_EVENT;
+}
+
+// idle time per core, and the share of the last full second spent idle
+static unsigned int pt_idle_usec[2];
+static unsigned int pt_idle_mark[2], pt_idle_window[2];
+static unsigned char pt_idle_pct[2];
+
+int pt_idle_percent(int core) {
+  return pt_idle_pct[core];
+}
+
+static void pt_idle_update(int core, unsigned int now) {
+  unsigned int span = now - pt_idle_window[core];
+  if (span < 1000000) return;
+  pt_idle_pct[core] = (pt_idle_usec[core] - pt_idle_mark[core]) / (span / 100);
+  pt_idle_mark[core] = pt_idle_usec[core];
+  pt_idle_window[core] = now;
+}
+
+#ifdef PT_STATS
+static int pt_stats_bucket(unsigned int v) {
+  int b = 0;
+  while (v && b < PT_STATS_BUCKETS-1) { v >>= 1; b++; }
+  return b;
+}
+
+// upper edge of the bucket holding the 99th percentile, capped at the max
+static unsigned int pt_stats_p99(const unsigned int *hist, unsigned int max) {
+  unsigned int n = 0, sum = 0, edge;
+  int b;
+  for (b=0; b<PT_STATS_BUCKETS; b++) n += hist[b];
+  if (n == 0) return 0;
+  for (b=0; b<PT_STATS_BUCKETS; b++) {
+    sum += hist[b];
+    if (sum >= n - n/100) break;
+  }
+  // the last bucket has no upper edge
+  if (b >= PT_STATS_BUCKETS-1) return max;
+  edge = (1u << b) - 1;
+  return (edge < max) ? edge : max;
+}
+
+// stats for thread id on a core; 0 for an unused id
+const struct pt_stats *pt_get_stats(int core, int id) {
+  int count = (core==1) ? pt_task_count1 : pt_task_count;
+  if (id < 0 || id >= count) return 0;
+  return (core==1) ? &pt_thread_list1[id].stats : &pt_thread_list[id].stats;
+}
+
+unsigned int pt_stats_run_p99(const struct pt_stats *s) {
+  return pt_stats_p99(s->run_hist, s->run_max);
+}
+
+unsigned int pt_stats_wake_p99(const struct pt_stats *s) {
+  return pt_stats_p99(s->wake_hist, s->wake_max);
+}
+
+// clear the stats of every thread on a core
+void pt_stats_reset(int core) {
+  int count = (core==1) ? pt_task_count1 : pt_task_count;
+  struct ptx *list = (core==1) ? pt_thread_list1 : pt_thread_list;
+  int i;
+  for (i=0; i<count; i++) memset(&list[i].stats, 0, sizeof(list[i].stats));
+}
+
+// SysTick is per core; each scheduler starts its own
+static void pt_stats_start(void) {
+  systick_hw->rvr = 0x00ffffff;
+  systick_hw->cvr = 0;
+  systick_hw->csr = 0x5;  // enabled, processor clock, no interrupt
+}
+#endif
+
+// call a thread until its next yield. due is the time it became runnable,
+// for the wake latency; has_due is 0 if there isn't one
+static inline void pt_call(struct ptx *ptx, int core, int has_due, unsigned int due) {
+#ifdef PT_STATS
+  unsigned int t0, run;
+  if (has_due) {
+    unsigned int late = pt_sched_time() - due;
+    if ((int)late < 0) late = 0;
+    ptx->stats.wakes++;
+    if (late > ptx->stats.wake_max) ptx->stats.wake_max = late;
+    ptx->stats.wake_hist[pt_stats_bucket(late)]++;
+  }
+  t0 = pt_stats_cycles();
+#endif
+  ptx->waiting = PT_RUNNING;
+  pt_current[core] = ptx;
+  (ptx->pf)(&ptx->pt);
+#ifdef PT_STATS
+  run = (t0 - pt_stats_cycles()) & 0x00ffffff;
+  ptx->stats.cycles += run;
+  ptx->stats.calls++;
+  if (run > ptx->stats.run_max) ptx->stats.run_max = run;
+  ptx->stats.run_hist[pt_stats_bucket(run)]++;
+#else
+  (void)has_due; (void)due;
+#endif
+}
+
+// call every thread parked in PT_YIELD_UNTIL_EVENT
+static void pt_sched_poll_events(struct ptx *list, int count, int core) {
+  int i;
+  for (i=0; i<count; i++) {
+    struct ptx *ptx = &list[i];
+    if (ptx->waiting != PT_EVENT) continue;
+    pt_call(ptx, core, 0, 0);
+  }
+  pt_current[core] = 0;
+}
+
+// Sleep until the earliest time anything on this core could run: a wake
+// time, or (SCHED_RATE) a release. Returns at once if a thread is always
+// ready, and early on any event
+static void pt_sched_idle(struct ptx *list, int count, int core) {
+  unsigned int now = pt_sched_time();
+  unsigned int wake = 0, t;
+  int has_wake = 0;
+  int rate = (pt_sched_method == SCHED_RATE);
+  int i;
+
+  for (i=0; i<count; i++) {
+    struct ptx *ptx = &list[i];
+    if (ptx->waiting == PT_EVENT) continue;
+    if (ptx->waiting == PT_RUNNING) {
+      if (!rate || ptx->period == 0) return;
+      t = ptx->release;
+    } else {
+      t = ptx->wake;
+      if (rate && ptx->period && (int)(ptx->release - t) > 0) t = ptx->release;
+    }
+    if (!has_wake || (int)(t - wake) < 0) {
+      wake = t;
+      has_wake = 1;
+    }
+  }
+
+  if (!has_wake) {
+    __wfe();
+  } else if ((int)(wake - now) > 0) {
+    best_effort_wfe_or_timeout(delayed_by_us(get_absolute_time(), wake - now));
+  }
+  pt_idle_usec[core] += pt_sched_time() - now;
+}
+
+// SCHED_RATE: one step. Runs the first thread in the ready queue that is
+// due -- always-ready threads are always due -- until its next yield, then
+// moves it behind its equals. Threads that aren't due cost nothing.
+// Sleeping threads aren't due until their wake time; event waiters only
+// get polled when nothing else is due.
+// A release that starts a whole period late, or one that finishes after
+// the next release is due, counts as a deadline miss
+static void pt_sched_rate_step(struct ptx *list, unsigned char *order, int count, int core) {
+  unsigned int now = pt_sched_time();
+  unsigned char run;
+  struct ptx *ptx = 0;
+  unsigned int due;
+  int has_due;
+  int k;
+
+  for (k=0; k<count; k++) {
+    ptx = &list[order[k]];
+    if (ptx->waiting == PT_EVENT) continue;
+    if (ptx->waiting == PT_SLEEPING && (int)(now - ptx->wake) < 0) continue;
+    if (ptx->period == 0 || (int)(now - ptx->release) >= 0) break;
+  }
+  if (k == count) {
+    // nothing due: give the event waiters a look, then sleep
+    pt_sched_poll_events(list, count, core);
+    pt_sched_idle(list, count, core);
+    return;
+  }
+
+  // due at its wake time if it was sleeping, else at its release
+  due = (ptx->waiting == PT_SLEEPING) ? ptx->wake : ptx->release;
+  has_due = (ptx->waiting == PT_SLEEPING || ptx->period);
+  if (ptx->waiting == PT_SLEEPING && ptx->period && (int)(ptx->release - due) > 0) due = ptx->release;
+
+  if (ptx->period) {
+    // releases slept through entirely
+    while ((int)(now - ptx->release) >= (int)ptx->period) {
+      ptx->release += ptx->period;
+      ptx->misses++;
+    }
+    ptx->release += ptx->period;
+  }
+
+  pt_call(ptx, core, has_due, due);
+  pt_current[core] = 0;
+
+  if (ptx->period && (int)(pt_sched_time() - ptx->release) > 0) ptx->misses++;
+
+  // back of its priority level
+  run = order[k];
+  for (; k+1<count && list[order[k+1]].priority == ptx->priority; k++) {
+    order[k] = order[k+1];
+  }
+  order[k] = run;
+}
+
+
+static PT_THREAD (protothread_sched(struct pt *pt))
+{   
+    PT_BEGIN(pt);
+    static int i;
+    
+#ifdef PT_STATS
+    pt_stats_start();
+#endif
+
+    if (pt_sched_method==SCHED_RATE){
+        while(1) {
+          pt_sched_rate_step(pt_thread_list, pt_order, pt_task_count, 0);
+          pt_idle_update(0, pt_sched_time());
+        }
+    }
+
+    if (pt_sched_method==SCHED_ROUND_ROBIN){
+        while(1) {
+          // test stupid round-robin 
+          // on all defined threads
+          struct ptx *ptx = &pt_thread_list[0];
+          unsigned int now = pt_sched_time();
+          // step thru all defined threads
+          // -- loop can have more than one initialization or increment/decrement, 
+          // -- separated using comma operator. But it can have only one condition.
+          // -- sleeping threads are skipped until their wake time
+          for (i=0; i<pt_task_count; i++, ptx++ ){
+              if (ptx->waiting == PT_SLEEPING && (int)(now - ptx->wake) < 0) continue;
+              // call thread function
+              pt_call(ptx, 0, ptx->waiting == PT_SLEEPING, ptx->wake);
+          }
+          pt_current[0] = 0;
+          // sleep if every thread is parked
+          pt_sched_idle(pt_thread_list, pt_task_count, 0);
+          pt_idle_update(0, now);
+          // Never yields! 
+          // NEVER exit while!
+        } // END WHILE(1)
+    } //end if (pt_sched_method==RR)       
+     
+    PT_END(pt);
+} // scheduler thread
+
+// ================================================
+// === second core scheduler
+static PT_THREAD (protothread_sched1(struct pt *pt))
+{   
+    PT_BEGIN(pt);
+    
+    static int i;
+    
+#ifdef PT_STATS
+    pt_stats_start();
+#endif
+
+    if (pt_sched_method==SCHED_RATE){
+        while(1) {
+          pt_sched_rate_step(pt_thread_list1, pt_order1, pt_task_count1, 1);
+          pt_idle_update(1, pt_sched_time());
+        }
+    }
+
+    if (pt_sched_method==SCHED_ROUND_ROBIN){
+        while(1) {
+          // test stupid round-robin 
+          // on all defined threads
+          struct ptx *ptx = &pt_thread_list1[0];
+          unsigned int now = pt_sched_time();
+          // step thru all defined threads
+          // -- loop can have more than one initialization or increment/decrement, 
+          // -- separated using comma operator. But it can have only one condition.
+          // -- sleeping threads are skipped until their wake time
+          for (i=0; i<pt_task_count1; i++, ptx++ ){
+              if (ptx->waiting == PT_SLEEPING && (int)(now - ptx->wake) < 0) continue;
+              // call thread function
+              pt_call(ptx, 1, ptx->waiting == PT_SLEEPING, ptx->wake);
+          }
+          pt_current[1] = 0;
+          // sleep if every thread is parked
+          pt_sched_idle(pt_thread_list1, pt_task_count1, 1);
+          pt_idle_update(1, now);
+          // Never yields! 
+          // NEVER exit while!
+        } // END WHILE(1)
+    } // end if(pt_sched_method==SCHED_ROUND_ROBIN)      
+     
+    PT_END(pt);
+} // scheduler1 thread
+
+// ========================================================
+// === package the schedulers =============================
+#define pt_schedule_start do{\
+  if(get_core_num()==1){ \
+    PT_INIT(&pt_sched1) ; \
+    PT_SCHEDULE(protothread_sched1(&pt_sched1));\
+  }  else {\
+    PT_INIT(&pt_sched) ;\
+    PT_SCHEDULE(protothread_sched(&pt_sched));\
+  }\
+} while(0) 
+
+// === package the add thread ==========================
+#define pt_add_thread(thread_name) do{\
+  if(get_core_num()==1){ \
+    pt_add1(thread_name);\
+  }  else {\
+    pt_add(thread_name);\
+  }\
+} while(0) 
+
+// with a period (usec) and priority, for SCHED_RATE
+#define pt_add_thread_rate(thread_name, period, priority) do{\
+  if(get_core_num()==1){ \
+    pt_add_rate1(thread_name, period, priority);\
+  }  else {\
+    pt_add_rate(thread_name, period, priority);\
+  }\
+} while(0) 
+
+// === serial input thread ================================
+// serial buffers
+#define pt_buffer_size 100
+char pt_serial_in_buffer[pt_buffer_size];
+char pt_serial_out_buffer[pt_buffer_size];
+// thread pointers
+static struct pt pt_serialin, pt_serialout ;
+// uart
+#define UART_ID uart0
+//
+#define pt_backspace 0x7f // make sure your backspace matches this!
+//
+static PT_THREAD (pt_serialin_polled(struct pt *pt)){
+    PT_BEGIN(pt);
+      static uint8_t ch ;
+      static int pt_current_char_count ;
+      // clear the string
+      memset(pt_serial_in_buffer, 0, pt_buffer_size);
+      pt_current_char_count = 0 ;
+      // clear uart fifo
+      while(uart_is_readable(UART_ID)){uart_getc(UART_ID);}
+      // build the output string
+      while(pt_current_char_count < pt_buffer_size) {   
+        PT_YIELD_UNTIL(pt, (int)uart_is_readable(UART_ID)) ;
+        //get the character and echo it back to terminal
+        // NOTE this assumes a human is typing!!
+        ch = uart_getc(UART_ID);
+        PT_YIELD_UNTIL(pt, (int)uart_is_writable(UART_ID)) ;
+        uart_putc(UART_ID, ch);
+        // check for <enter> or <backspace>
+        if (ch == '\r' ){
+          // <enter>> character terminates string,
+          // advances the cursor to the next line, then exits
+          pt_serial_in_buffer[pt_current_char_count] = 0 ;
+          PT_YIELD_UNTIL(pt, (int)uart_is_writable(UART_ID)) ;
+          uart_putc(UART_ID, '\n') ;
+          break ; 
+        }
+        // check fo ,backspace>
+        else if (ch == pt_backspace){
+          PT_YIELD_UNTIL(pt, (int)uart_is_writable(UART_ID)) ;
+          uart_putc(UART_ID, ' ') ;
+          PT_YIELD_UNTIL(pt, (int)uart_is_writable(UART_ID)) ;
+          uart_putc(UART_ID, pt_backspace) ;
+          //uart_putc(UART_ID, ' ') ;
+          // wipe a character from the output
+          pt_current_char_count-- ;
+          if (pt_current_char_count<0) {pt_current_char_count = 0 ;}
+        }
+        // must be a real character
+        else {
+          // build the output string
+          pt_serial_in_buffer[pt_current_char_count++] = ch ;
+        }
+      } // END WHILe
+      // kill this input thread, to allow spawning thread to execute
+    PT_EXIT(pt);
+  PT_END(pt);
+} // serial input thread
+
+// ================================================================
+// === serial output thread
+//
+int pt_serialout_polled(struct pt *pt)
+{
+    static int num_send_chars ;
+    PT_BEGIN(pt);
+    num_send_chars = 0;
+    while (pt_serial_out_buffer[num_send_chars] != 0){
+        PT_YIELD_UNTIL(pt, (int)uart_is_writable(UART_ID)) ;
+        uart_putc(UART_ID, pt_serial_out_buffer[num_send_chars]) ;
+        num_send_chars++;
+    }
+    // kill this output thread, to allow spawning thread to execute
+    PT_EXIT(pt);
+    // and indicate the end of the thread
+    PT_END(pt);
+}
+// ================================================================
+// package the spawn read/write macros to make them look better
+#define serial_write do{PT_SPAWN(pt,&pt_serialout,pt_serialout_polled(&pt_serialout));}while(0)
+#define serial_read  do{PT_SPAWN(pt,&pt_serialin,pt_serialin_polled(&pt_serialin));}while(0)
+
+// idle share of each core over the last second, into the serial output
+// buffer, and a macro to send it from a thread
+void pt_idle_sprint(void) {
+  snprintf(pt_serial_out_buffer, pt_buffer_size, "idle c0=%d%% c1=%d%%\r\n",
+           pt_idle_percent(0), pt_idle_percent(1));
+}
+#define serial_write_idle do{pt_idle_sprint(); serial_write;}while(0)
+
+#ifdef PT_STATS
+// one line of thread stats into the serial output buffer:
+// core, thread, calls, total cycles, run max/p99 cycles, wake max/p99 usec,
+// deadline misses.
+// Returns 0 for an unused id
+int pt_stats_sprint(int core, int id) {
+  const struct pt_stats *s = pt_get_stats(core, id);
+  if (!s) return 0;
+  snprintf(pt_serial_out_buffer, pt_buffer_size,
+           "c%d t%d n=%u cyc=%llu run=%u/%u wake=%u/%u miss=%u\r\n",
+           core, id, s->calls, s->cycles,
+           s->run_max, pt_stats_run_p99(s), s->wake_max, pt_stats_wake_p99(s),
+           pt_deadline_misses(core, id));
+  return 1;
+}
+// dump one thread's stats from a thread, via the serial output thread
+#define serial_write_stats(core, id) do{if(pt_stats_sprint(core, id)) serial_write;}while(0)
+#endif
+//
+// ======
+// END
 // ======
\ No newline at end of file
@@ -1,762 +1,993 @@
-/**
- * Akshati Vaishnav, Grace Lo, Daniela Tran
- * 
- * HARDWARE CONNECTIONS
- *
- * IMU0
- *  - 3V3 (OUT) (#36) → Vin
- *  - GND → GND
- *  - GPIO 12 (#16) → SDA (prev 8)
- *  - GPIO 13 (#17) → SCL (prev 9)
- * Button0
- *  - GPIO 2 (#4) → Left
- *  - GPIO 4 (#6) → Right
- * IMU1
- *  - 3V3 (OUT) (#36) → Vin
- *  - GND → GND
- *  - GPIO 14 (#19) → SDA
- *  - GPIO 15 (#20) → SCL
- * Button1
- *  - GPIO 9 (#12) → Left
- *  - GPIO 11 (#15) → Right
- * VGA
- *  - GND → GND
- *  - GPIO 16 (#21) → Hsync
- *  - GPIO 17 (#22) → Vsync
- *  - GPIO 18 (#24) → 330 ohm resistor → Red
- *  - GPIO 19 (#25) → 330 ohm resistor → Green
- *  - GPIO 20 (#26) → 330 ohm resistor → Blue
- */
-
-
-// Include standard libraries
-#include <stdio.h>
-#include <stdlib.h>
-#include <math.h>
-#include <string.h>
-// Include PICO libraries
-#include "pico/stdlib.h"
-#include "pico/multicore.h"
-// Include hardware libraries
-#include "hardware/pwm.h"
-#include "hardware/dma.h"
-#include "hardware/irq.h"
-#include "hardware/adc.h"
-#include "hardware/pio.h"
-#include "hardware/i2c.h"
-// Include custom libraries
-#include "vga_graphics.h"
-#include "mpu6050.h"
-#include "pt_cornell_rp2040_v1.h"
-
-// Arrays in which raw measurements will be stored
-fix15 accel0[3], gyro0[3];
-fix15 accel1[3], gyro1[3];
-
-// character array
-char screentext[40];
-
-// draw speed
-int threshold = 1 ;
-
-float filtered_ax0 = 0.0;
-float filtered_ay0 = 0.0;
-fix15 accel_angle0 = int2fix15(0);
-fix15 gyro_angle_delta0 = int2fix15(0);
-fix15 comp_angle0 = int2fix15(0);
-float filtered_ax1 = 0.0;
-float filtered_ay1 = 0.0;
-fix15 accel_angle1 = int2fix15(0);
-fix15 gyro_angle_delta1 = int2fix15(0);
-fix15 comp_angle1 = int2fix15(0);
-
-// Some macros for max/min/abs
-#define min(a,b) ((a<b) ? a:b)
-#define max(a,b) ((a<b) ? b:a)
-#define abs(a) ((a>0) ? a:-a)
-
-// semaphore
-static struct pt_sem vga_semaphore ;
-
-struct player_struct {
-	bool player_id; //0 or 1
-	short pos_x;
-	short pos_y;
-	bool stab;
-	bool block;
-	bool block_prev;
-	bool stab_prev;
-	int health;
-	bool prev_movement; //0 if previous movement was to left, 1 if prev movement was to right
-}player0, player1;
-
-// Some paramters for PWM
-#define WRAPVAL 5000
-#define CLKDIV  25.0
-uint slice_num ;
-
-bool move_left0 = 0;
-bool move_left1 = 0;
-bool move_right0 = 0;
-bool move_right1 = 0;
-
-int stab_counter0 = 0;
-int stab_counter1 = 0;
-
-char color0 = YELLOW;
-char color1 = CYAN;
-short game_state = 4; 
-
-/* GAME STATES
-0 = player 0 wins
-1 = player 1 wins
-2 = regular gameplay
-3 = wait to restart game and then restart game
-4 = start screen
-5 = instruction screen
-*/
-// Interrupt service routine
-void sensor_irq() {
-
-    // Clear the interrupt flag that brought us here
-    pwm_clear_irq(pwm_gpio_to_slice_num(5));
-
-    // Read the IMU
-	mpu6050_read_raw0(accel0, gyro0);
-    mpu6050_read_raw1(accel1, gyro1);
-	
-	//getting the filtered values for acceleration
-	filtered_ax0 += fix2float15((accel0[0]-float2fix15(filtered_ax0))>>6);
-	filtered_ay0 += fix2float15((accel0[1]-float2fix15(filtered_ay0))>>6);
-	filtered_ax1 += fix2float15((accel1[0]-float2fix15(filtered_ax1))>>6);
-	filtered_ay1 += fix2float15((accel1[1]-float2fix15(filtered_ay1))>>6);
-	
-	//calculating acceleration angle, gyro angle, and complementary angle
-	accel_angle0 = multfix15(float2fix15(atan2(-filtered_ax0, -filtered_ay0)), oneeightyoverpi);
-	gyro_angle_delta0 = multfix15(gyro0[2], zeropt001);
-	comp_angle0 = multfix15(comp_angle0 + gyro_angle_delta0, zeropt999) + multfix15(accel_angle0, zeropt001);
-	
-	accel_angle1 = multfix15(float2fix15(atan2(-filtered_ax1, -filtered_ay1)), oneeightyoverpi);
-	gyro_angle_delta1 = multfix15(gyro1[2], zeropt001);
-	comp_angle1 = multfix15(comp_angle1 + gyro_angle_delta1, zeropt999) + multfix15(accel_angle1, zeropt001);
-	
-	if(gpio_get(2) == 0 && gpio_get(4) == 0) { //if both l+r buttons are pressed, NO MOVEMENT
-		move_left0 = 0;
-		move_right0 = 0;
-	} else if (gpio_get(2) == 0 && gpio_get(4) == 1) { //if l button is pressed, move left
-		move_left0 = 1;
-		move_right0 = 0;
-	} else if (gpio_get(2) == 1 && gpio_get(4) == 0) { //if r button is pressed, move right
-		move_left0 = 0;
-		move_right0 = 1;
-	} else if (gpio_get(2) == 1 && gpio_get(4) == 1) { //if l+r buttons are NOT pressed, NO MOVEMENT
-		move_left0 = 0;
-		move_right0 = 0;
-	}
-	
-	if(gpio_get(9) == 0 && gpio_get(11) == 0) { //if both l+r buttons are pressed, NO MOVEMENT
-		move_left1 = 0;
-		move_right1 = 0;
-	} else if (gpio_get(9) == 0 && gpio_get(11) == 1) { //if l button is pressed, move left
-		move_left1 = 1;
-		move_right1 = 0;
-	} else if (gpio_get(9) == 1 && gpio_get(11) == 0) { //if r button is pressed, move right
-		move_left1 = 0;
-		move_right1 = 1;
-	} else if (gpio_get(9) == 1 && gpio_get(11) == 1) { //if l+r buttons are NOT pressed, NO MOVEMENT
-		move_left1 = 0;
-		move_right1 = 0;
-	}
-	
-	if(player0.stab == 1) {
-		stab_counter0 += 1;
-	} 
-	
-	if(player1.stab == 1) {
-		stab_counter1 += 1;
-	} 
-
-    // Signal VGA to draw
-    PT_SEM_SIGNAL(pt, &vga_semaphore);
-}
-
-//animation thread
-static PT_THREAD (protothread_anim1(struct pt *pt)) {
-    // Mark beginning of thread
-    PT_BEGIN(pt);
-    // Variables for maintaining frame rate
-	
-	player0.player_id = 0;
-	player0.pos_x = (140);
-	player0.pos_y = (345);
-	player0.stab = 0;
-	player0.block = 0;
-	player0.block_prev = 0;
-	player0.stab_prev = 0;
-	player0.health = 100;
-	player0.prev_movement = 1; //player0 initially faces player1 -- so player0 faces right
-	
-	player1.player_id = 1;
-	player1.pos_x = (500);
-	player1.pos_y = (345);
-	player1.stab = 0;
-	player1.block = 0;
-	player1.block_prev = 0;
-	player1.stab_prev = 0;
-	player1.health = 100;
-	player1.prev_movement = 0; //player1 initially faces player0 -- so player1 faces left
-	
-	int prev_health0 = player0.health;
-	int prev_health1 = player1.health;
-	static char health0_print[40];
-	static char health1_print[40];
-	static char winner_print[40];
-	static char restart_print[40];
-	static char start_print0[40];
-	static char start_print1[40];
-	static char start_print2[40];
-	static char instruction_print[100];
-	
-	PT_YIELD_usec(100000);
-	
-    while(1) {
-		if(game_state == 0) {
-			setTextColor2(WHITE, BLACK); 
-			setCursor(200, 200); 
-			setTextSize(3);
-			sprintf(winner_print, "Player 0 Wins!");
-			writeString(winner_print);
-			PT_YIELD_usec(1000000);
-			game_state = 3;
-		} else if(game_state == 1) {
-			setTextColor2(WHITE, BLACK); 
-			setCursor(200, 200); 
-			setTextSize(3);
-			sprintf(winner_print, "Player 1 Wins!");
-			writeString(winner_print);
-			PT_YIELD_usec(1000000);
-			game_state = 3;
-		} else if(game_state == 2) {
-			
-			//horizontal line (ground)
-			drawHLine(0, 420, 640, WHITE);
-			
-			//health bar text
-			setTextSize(1);
-			setTextColor2(color0, BLACK); 
-			setCursor(247, 43); 
-			sprintf(health0_print, "%d", player0.health);
-			writeString(health0_print);
-			
-			setTextColor2(color1, BLACK); 
-			setCursor(557, 43); 
-			sprintf(health1_print, "%d", player1.health);
-			writeString(health1_print);
-			
-			if((prev_health0 == 100 && player0.health < 100)){
-				fillRect(259, 43, 6, 8, BLACK);
-			} 
-			if (prev_health0 == 10 && player0.health < 10) {
-				fillRect(253, 43, 6, 8, BLACK);
-			}
-			if(prev_health1 == 100 && player1.health < 100){
-				fillRect(569, 43, 6, 8, BLACK);
-			} 
-			if (prev_health1 == 10 && player1.health < 10) {
-				fillRect(563, 43, 6, 8, BLACK);
-			}
-			
-			
-			/* PLAYER 0 */		
-			//stabbing logic -- player0
-			if((fix2int15(comp_angle0) >= 75) && (fix2int15(comp_angle0) <= 105) && (fix2float15(accel0[1]) > 0.01)) {
-				if (stab_counter0 < 500) {
-					player0.stab = 1;
-				} else {
-					player0.stab = 0;
-					stab_counter0 = 0;
-				}
-				player0.block = 0;
-			} else if ((fix2int15(comp_angle0) >= -15) && (fix2int15(comp_angle0) <= 15)) {
-				player0.block = 1;
-				player0.stab = 0;
-			} else {
-				player0.block = 0;
-				player0.stab = 0;
-			}
-			
-			//moving logic -- player0
-			if(move_left0 == 1 && move_right0 == 0 && player0.pos_x-84-5 >= 0) { //last check is for VGA walls
-				fillRect(player0.pos_x-84, player0.pos_y-60, 168, 135, BLACK);
-				player0.pos_x -= 5;
-				if(player0.prev_movement == 1) { //player0 was moving right, but now its moving left...
-					player0.prev_movement = 0;
-				}
-			} else if(move_left0 == 0 && move_right0 == 1 && player0.pos_x+84+5 <= 639) { //last check is for VGA walls
-				fillRect(player0.pos_x-84, player0.pos_y-60, 168, 135, BLACK);
-				player0.pos_x += 5;
-				if(player0.prev_movement == 0) { //player0 was moving right, but now its moving left...
-					player0.prev_movement = 1;
-				}
-			}
-			
-			//constant body features -- player0
-			drawCircle(player0.pos_x, player0.pos_y-30, 15, color0); //head circle
-			drawVLine(player0.pos_x, player0.pos_y-15, 45, color0); //body line
-			
-			if(player0.prev_movement == 0) { //move left
-				//legs
-				drawLine(player0.pos_x, player0.pos_y+30, player0.pos_x-15, player0.pos_y+53, color0); //left leg1
-				drawVLine(player0.pos_x-15, player0.pos_y+53, 22, color0); //left leg2
-				drawLine(player0.pos_x, player0.pos_y+30, player0.pos_x+6, player0.pos_y+53, color0);//right leg1
-				drawLine(player0.pos_x+6, player0.pos_y+53, player0.pos_x+15, player0.pos_y+75, color0);//right leg2
-				
-				//arms
-				drawLine(player0.pos_x, player0.pos_y, player0.pos_x+15, player0.pos_y+30, color0); //right arm
-				if(player0.block == 0 && player0.stab == 1){ //player0 stab!
-					drawLine(player0.pos_x, player0.pos_y, player0.pos_x-30, player0.pos_y+3, color0); //left arm
-					drawHLine(player0.pos_x-84, player0.pos_y+3, 60, color0); //sword1 --long part
-					drawVLine(player0.pos_x-30, player0.pos_y, 6, color0); //sword2 --short part
-				} else if(player0.block == 1 && player0.stab == 0){ //player0 block!
-					drawLine(player0.pos_x, player0.pos_y, player0.pos_x-11, player0.pos_y+23, color0); //left arm1
-					drawLine(player0.pos_x-11, player0.pos_y+23, player0.pos_x-24, player0.pos_y+15, color0); //left arm2
-					drawVLine(player0.pos_x-24, player0.pos_y-37, 60, color0); //sword1
-					drawHLine(player0.pos_x-29, player0.pos_y+12, 10, color0); //sword2
-				} else { //player0 wait state!
-					drawLine(player0.pos_x, player0.pos_y, player0.pos_x-9, player0.pos_y+12, color0); //left arm1
-					drawLine(player0.pos_x-9, player0.pos_y+12, player0.pos_x-30, player0.pos_y, color0); //left arm2
-					drawLine(player0.pos_x-24, player0.pos_y+6, player0.pos_x-69, player0.pos_y-39, color0); //sword1
-					drawLine(player0.pos_x-29, player0.pos_y-5, player0.pos_x-35, player0.pos_y+2, color0); //sword2
-				}
-				
-			} else if(player0.prev_movement == 1) { //move right
-				
-				//legs
-				drawLine(player0.pos_x, player0.pos_y+30, player0.pos_x-6, player0.pos_y+53, color0);//left leg1
-				drawLine(player0.pos_x-6, player0.pos_y+53, player0.pos_x-15, player0.pos_y+75, color0);//left leg2
-				drawLine(player0.pos_x, player0.pos_y+30, player0.pos_x+15, player0.pos_y+53, color0); //right leg1
-				drawVLine(player0.pos_x+15, player0.pos_y+53, 22, color0); //right leg2
-				
-				//arms
-				drawLine(player0.pos_x, player0.pos_y, player0.pos_x-15, player0.pos_y+30, color0); //left arm
-				if(player0.block == 0 && player0.stab == 1){ //player0 stab!
-					drawLine(player0.pos_x, player0.pos_y, player0.pos_x+30, player0.pos_y+3, color0); //right arm
-					drawHLine(player0.pos_x+24, player0.pos_y+3, 60, color0); //sword1 --long part
-					drawVLine(player0.pos_x+30, player0.pos_y, 6, color0); //sword2 --short part
-				} else if(player0.block == 1 && player0.stab == 0){ //player0 block!
-					drawLine(player0.pos_x, player0.pos_y, player0.pos_x+11, player0.pos_y+23, color0); //right arm1
-					drawLine(player0.pos_x+11, player0.pos_y+23, player0.pos_x+24, player0.pos_y+15, color0); //right arm2
-					drawVLine(player0.pos_x+24, player0.pos_y-37, 60, color0); //sword1
-					drawHLine(player0.pos_x+19, player0.pos_y+12, 10, color0); //sword2
-				} else { //player0 wait state!
-					drawLine(player0.pos_x, player0.pos_y, player0.pos_x+9, player0.pos_y+12, color0); //right arm1
-					drawLine(player0.pos_x+9, player0.pos_y+12, player0.pos_x+30, player0.pos_y, color0); //right arm2
-					drawLine(player0.pos_x+24, player0.pos_y+6, player0.pos_x+69, player0.pos_y-39, color0); //sword1
-					drawLine(player0.pos_x+29, player0.pos_y-5, player0.pos_x+35, player0.pos_y+2, color0); //sword2
-				}
-			}
-			
-			/* PLAYER 1 */
-			//stabbing logic -- player1
-			if((fix2int15(comp_angle1) >= 75) && (fix2int15(comp_angle1) <= 105) && (fix2float15(accel1[1]) > 0.01)) {
-				if (stab_counter1 < 500) {
-					player1.stab = 1;
-				} else {
-					player1.stab = 0;
-					stab_counter1 = 0;
-				}
-				player1.block = 0;
-			} else if ((fix2int15(comp_angle1) >= -15) && (fix2int15(comp_angle1) <= 15)) {
-				player1.block = 1;
-				player1.stab = 0;
-			} else {
-				player1.block = 0;
-				player1.stab = 0;
-			}
-			
-			//moving logic -- player1
-			if(move_left1 == 1 && move_right1 == 0 && player1.pos_x-84-5 >= 0) { //VGA box
-				fillRect(player1.pos_x-84, player1.pos_y-60, 168, 135, BLACK);
-				player1.pos_x -= 5;
-				if(player1.prev_movement == 1) { //player1 was moving right, but now its moving left...
-					player1.prev_movement = 0;
-				}
-			} else if(move_left1 == 0 && move_right1 == 1 && player1.pos_x+84+5 <= 639) { //VGA box
-				fillRect(player1.pos_x-84, player1.pos_y-60, 168, 135, BLACK);
-				player1.pos_x += 5;
-				if(player1.prev_movement == 0) { //player1 was moving left, but now its moving right...
-					player1.prev_movement = 1;
-				}
-			}
-			
-			//constant body features -- player1
-			drawCircle(player1.pos_x, player1.pos_y-30, 15, color1); //head circle
-			drawVLine(player1.pos_x, player1.pos_y-15, 45, color1); //body line
-			
-			if(player1.prev_movement == 0) {//move left
-			
-				//legs
-				drawLine(player1.pos_x, player1.pos_y+30, player1.pos_x-15, player1.pos_y+53, color1); //left leg1
-				drawVLine(player1.pos_x-15, player1.pos_y+53, 22, color1); //left leg2
-				drawLine(player1.pos_x, player1.pos_y+30, player1.pos_x+6, player1.pos_y+53, color1);//right leg1
-				drawLine(player1.pos_x+6, player1.pos_y+53, player1.pos_x+15, player1.pos_y+75, color1);//right leg2
-				
-				//arms
-				drawLine(player1.pos_x, player1.pos_y, player1.pos_x+15, player1.pos_y+30, color1); //right arm
-				if(player1.block == 0 && player1.stab == 1){ //player1 stab!
-					drawLine(player1.pos_x, player1.pos_y, player1.pos_x-30, player1.pos_y+3, color1); //left arm
-					drawHLine(player1.pos_x-84, player1.pos_y+3, 60, color1); //sword1 --long part
-					drawVLine(player1.pos_x-30, player1.pos_y, 6, color1); //sword2 --short part
-				} else if(player1.block == 1 && player1.stab == 0){ //player1 block!
-					drawLine(player1.pos_x, player1.pos_y, player1.pos_x-11, player1.pos_y+23, color1); //left arm1
-					drawLine(player1.pos_x-11, player1.pos_y+23, player1.pos_x-24, player1.pos_y+15, color1); //left arm2
-					drawVLine(player1.pos_x-24, player1.pos_y-37, 60, color1); //sword1
-					drawHLine(player1.pos_x-29, player1.pos_y+12, 10, color1); //sword2
-				} else { //player1 wait state!
-					drawLine(player1.pos_x, player1.pos_y, player1.pos_x-9, player1.pos_y+12, color1); //left arm1
-					drawLine(player1.pos_x-9, player1.pos_y+12, player1.pos_x-30, player1.pos_y, color1); //left arm2
-					drawLine(player1.pos_x-24, player1.pos_y+6, player1.pos_x-69, player1.pos_y-39, color1); //sword1
-					drawLine(player1.pos_x-29, player1.pos_y-5, player1.pos_x-35, player1.pos_y+2, color1); //sword2
-				}
-				
-			} else if(player1.prev_movement == 1) {//move right
-			
-				//legs
-				drawLine(player1.pos_x, player1.pos_y+30, player1.pos_x-6, player1.pos_y+53, color1);//left leg1
-				drawLine(player1.pos_x-6, player1.pos_y+53, player1.pos_x-15, player1.pos_y+75, color1);//left leg2
-				drawLine(player1.pos_x, player1.pos_y+30, player1.pos_x+15, player1.pos_y+53, color1); //right leg1
-				drawVLine(player1.pos_x+15, player1.pos_y+53, 22, color1); //right leg2
-				
-				//arms
-				drawLine(player1.pos_x, player1.pos_y, player1.pos_x-15, player1.pos_y+30, color1); //left arm
-				if(player1.block == 0 && player1.stab == 1){ //player1 stab!
-					drawLine(player1.pos_x, player1.pos_y, player1.pos_x+30, player1.pos_y+3, color1); //right arm
-					drawHLine(player1.pos_x+24, player1.pos_y+3, 60, color1); //sword1 --long part
-					drawVLine(player1.pos_x+30, player1.pos_y, 6, color1); //sword2 --short part
-				} else if(player1.block == 1 && player1.stab == 0){ //player1 block!
-					drawLine(player1.pos_x, player1.pos_y, player1.pos_x+11, player1.pos_y+23, color1); //right arm1
-					drawLine(player1.pos_x+11, player1.pos_y+23, player1.pos_x+24, player1.pos_y+15, color1); //right arm2
-					drawVLine(player1.pos_x+24, player1.pos_y-37, 60, color1); //sword1
-					drawHLine(player1.pos_x+19, player1.pos_y+12, 10, color1); //sword2
-				} else { //player1 wait state!
-					drawLine(player1.pos_x, player1.pos_y, player1.pos_x+9, player1.pos_y+12, color1); //right arm1
-					drawLine(player1.pos_x+9, player1.pos_y+12, player1.pos_x+30, player1.pos_y, color1); //right arm2
-					drawLine(player1.pos_x+24, player1.pos_y+6, player1.pos_x+69, player1.pos_y-39, color1); //sword1
-					drawLine(player1.pos_x+29, player1.pos_y-5, player1.pos_x+35, player1.pos_y+2, color1); //sword2
-				}
-				
-			}
-			
-			//prev movement is: 0 if move left, 1 if move right
-			if(player0.block != player0.block_prev || player0.stab != player0.stab_prev || player1.block != player1.block_prev || player1.stab != player1.stab_prev) {
-				fillRect(player0.pos_x-84, player0.pos_y-60, 168, 135, BLACK); //black box for stabbing changes
-				fillRect(player1.pos_x-84, player1.pos_y-60, 168, 135, BLACK); //black box for stabbing changes
-				if(player0.pos_x < player1.pos_x) { //player0 is to the left of player1
-					if(player0.prev_movement == 1 && player1.prev_movement == 0) { //face each other
-						//player0 faces right, player1 faces left
-						if(player0.stab == 1 && player1.block == 0 && ((player1.pos_x - player0.pos_x)>=30) && ((player1.pos_x - player0.pos_x)<=114)) { // player0 stabbing player1
-							prev_health1 = player1.health;
-							player1.health -= 1;
-							
-							//health bar logic
-							fillRect(351+(player1.health*2), 43, 2, 8, BLACK);
-						}
-						if(player1.stab == 1 && player0.block == 0 && ((player1.pos_x - player0.pos_x)>=30) && ((player1.pos_x - player0.pos_x)<=114)) { // player1 stabbing player0
-							prev_health0 = player0.health;
-							player0.health -= 1;
-							
-							//health bar logic
-							fillRect(41+(player0.health*2), 43, 2, 8, BLACK);
-						}
-						
-					} else if(player0.prev_movement == 0 && player1.prev_movement == 1) { //face away from each other
-						//player0 faces left, player1 faces right
-						//do nothing because they aren't facing each other and player0 is to the left of player1
-						continue;
-					} else if(player0.prev_movement == 1 && player1.prev_movement == 1) { //p0 faces p1, p1 looks away from p0
-						//player0 faces right, player1 faces right => player1's blocks do not matter! also player1 cannot stab player0
-						if(player0.stab == 1 && ((player1.pos_x - player0.pos_x)>=30) && ((player1.pos_x - player0.pos_x)<=84)) { // player0 stabbing player1
-							prev_health1 = player1.health;
-							player1.health -= 1;
-							
-							//health bar logic
-							fillRect(351+(player1.health*2), 43, 2, 8, BLACK);
-						}
-					} else if(player0.prev_movement == 0 && player1.prev_movement == 0) { //p1 faces p0, p0 looks away from p1
-						//player0 faces left, player1 faces left => player0's blocks do not matter! also player0 cannot stab player1
-						if(player1.stab == 1 && ((player1.pos_x - player0.pos_x)>=30) && ((player1.pos_x - player0.pos_x)<=84)) { // player1 stabbing player0
-							prev_health0 = player0.health;
-							player0.health -= 1;
-							
-							//health bar logic
-							fillRect(41+(player0.health*2), 43, 2, 8, BLACK);
-						}
-					}
-				} else if(player0.pos_x > player1.pos_x) { //player0 is to the right of player1
-					if(player0.prev_movement == 1 && player1.prev_movement == 0) { //face away from each other
-						//player0 faces right, player1 faces left
-						//do nothing because they aren't facing each other and player1 is to the left of player0
-					} else if(player0.prev_movement == 0 && player1.prev_movement == 1) { //face each other
-						//player0 faces left, player1 faces right
-						if(player0.stab == 1 && player1.block == 0 && ((player0.pos_x - player1.pos_x)>=30) && ((player0.pos_x - player1.pos_x)<=114)) { // player0 stabbing player1
-							prev_health1 = player1.health;
-							player1.health -= 1;
-							
-							//health bar logic
-							fillRect(351+(player1.health*2), 43, 2, 8, BLACK);
-						}
-						if(player1.stab == 1 && player0.block == 0 && ((player0.pos_x - player1.pos_x)>=30) && ((player0.pos_x - player1.pos_x)<=114)) { // player1 stabbing player0
-							prev_health0 = player0.health;
-							player0.health -= 1;
-							
-							//health bar logic
-							fillRect(41+(player0.health*2), 43, 2, 8, BLACK);
-						}
-					} else if(player0.prev_movement == 1 && player1.prev_movement == 1) { //p1 faces p0, p0 looks away from p1
-						//player0 faces right, player1 faces right => player0's blocks do not matter! also player0 cannot stab player1
-						if(player1.stab == 1 && player1.block == 0 && ((player0.pos_x - player1.pos_x)>=30) && ((player0.pos_x - player1.pos_x)<=84)) { // player1 stabbing player0
-							prev_health0 = player0.health;
-							player0.health -= 1;
-							
-							//health bar logic
-							fillRect(41+(player0.health*2), 43, 2, 8, BLACK);
-						}
-					} else if(player0.prev_movement == 0 && player1.prev_movement == 0) { //p0 faces p1, p1 looks away from p0
-						//player0 faces left, player1 faces left => player1's blocks do not matter! also player1 cannot stab player0
-						if(player0.stab == 1 && player0.block == 0 && ((player0.pos_x - player1.pos_x)>=30) && ((player0.pos_x - player1.pos_x)<=84)) { // player0 stabbing player1
-							prev_health1 = player1.health;
-							player1.health -= 1;
-							
-							//health bar logic
-							fillRect(351+(player1.health*2), 43, 2, 8, BLACK);
-						}
-					}
-				}
-			}
-			player0.block_prev = player0.block;
-			player0.stab_prev = player0.stab;
-			player1.block_prev = player1.block;
-			player1.stab_prev = player1.stab;
-			
-			
-			//game state changes
-			if(player0.health < 0) {
-				game_state = 1; //player1 wins
-				drawRect(40, 42, 202, 10, color0);
-			} else if (player1.health < 0) {
-				game_state = 0; //player0 wins
-				drawRect(350, 42, 202, 10, color1);
-			}
-			
-		} else if (game_state == 3) {
-			setTextSize(2);
-			setTextColor2(WHITE, BLACK); 
-			setCursor(180, 350); 
-			sprintf(restart_print, "Press button to restart!");
-			writeString(restart_print);
-			if(gpio_get(8) == 0) {
-				PT_YIELD_usec(100000);
-				player0.player_id = 0;
-				player0.pos_x = (140);
-				player0.pos_y = (345);
-				player0.stab = 0;
-				player0.block = 0;
-				player0.block_prev = 0;
-				player0.stab_prev = 0;
-				player0.health = 100;
-				
-				player1.player_id = 1;
-				player1.pos_x = (500);
-				player1.pos_y = (345);
-				player1.stab = 0;
-				player1.block = 0;
-				player1.block_prev = 0;
-				player1.stab_prev = 0;
-				player1.health = 100;
-				
-				int prev_health0 = player0.health;
-				int prev_health1 = player1.health;
-				
-				fillRect(0, 0, 640, 480, BLACK);
-				
-				//health bar
-				fillRect(40, 42, 202, 10, color0);
-				drawRect(38, 40, 206, 14, color0);
-				fillRect(350, 42, 202, 10, color1);
-				drawRect(348, 40, 206, 14, color1);
-				
-				game_state = 2;
-			}
-		} else if (game_state == 4) { //start screen			
-			//title print
-			setTextSize(5);
-			setTextColor2(RED, BLACK); 
-			setCursor(190, 150); 
-			sprintf(start_print0, "STICKMAN");
-			writeString(start_print0);
-			setCursor(235, 200); 
-			sprintf(start_print1, "NINJA");
-			writeString(start_print1);
-			setTextSize(2);
-			setCursor(150, 350); 
-			sprintf(start_print2, "Press button to continue...");
-			writeString(start_print2);
-			
-			if(gpio_get(8) == 0) {
-				PT_YIELD_usec(1000000);
-				game_state = 5;
-				fillRect(0, 0, 640, 480, BLACK);
-			}
-		} else if (game_state == 5) { //instruction screen
-			//print instructions!!!
-			setTextSize(4);
-			setTextColor2(GREEN, BLACK); 
-			setCursor(175, 50); 
-			sprintf(instruction_print, "INSTRUCTIONS");
-			writeString(instruction_print);
-			/* Instruction Text:
-			To move:
-				Move left: press left button
-				Move right: press right button 
-				
-			To use the sword:
-				Make sure the IMU faces right!
-				To stab: hold the board horizontally and move in a stabbing motion 
-				To block: hold the board vertically
-			*/
-			setTextColor2(WHITE, BLACK); 
-			setTextSize(3);
-			setCursor(50, 110); 
-			sprintf(instruction_print, "To move...");
-			writeString(instruction_print);
-			setTextSize(2);
-			setCursor(70, 140); 
-			sprintf(instruction_print, "Move left: press left button");
-			writeString(instruction_print);
-			setCursor(70, 160); 
-			sprintf(instruction_print, "Move right: press right button");
-			writeString(instruction_print);
-			
-			setTextSize(3);
-			setCursor(50, 210); 
-			sprintf(instruction_print, "To use the sword...");
-			writeString(instruction_print);
-			setTextSize(2);
-			setCursor(70, 240); 
-			sprintf(instruction_print, "Make sure the IMU faces right!");
-			writeString(instruction_print);
-			setCursor(70, 260); 
-			sprintf(instruction_print, "To stab: hold the board horizontally and ");
-			writeString(instruction_print);
-			setCursor(70, 280); 
-			sprintf(instruction_print, "move in a stabbing motion");
-			writeString(instruction_print);
-			setCursor(70, 300); 
-			sprintf(instruction_print, "To block: hold the board vertically");
-			writeString(instruction_print);
-			
-			if(gpio_get(8) == 0) {
-				PT_YIELD_usec(100000);
-				game_state = 2;
-				fillRect(0, 0, 640, 480, BLACK);
-				//health bar
-				fillRect(40, 42, 202, 10, color0);
-				drawRect(38, 40, 206, 14, color0);
-				fillRect(350, 42, 202, 10, color1);
-				drawRect(348, 40, 206, 14, color1);
-			}
-		}
-		// NEVER exit while
-    } // END WHILE(1)
-  PT_END(pt);
-} // animation thread
-
-
-// Entry point for core 1
-void core1_entry() {
-	pt_add_thread(protothread_anim1);
-    pt_schedule_start ;
-}
-
-int main() {
-
-    // Initialize stdio
-    stdio_init_all();
-
-    // Initialize VGA
-    initVGA() ;
-	
-	//button config
-	//left
-	gpio_init(2) ;
-	gpio_set_dir(2, GPIO_IN);
-	gpio_pull_up(2);
-
-	//right
-	gpio_init(4) ;
-	gpio_set_dir(4, GPIO_IN);
-	gpio_pull_up(4);
-	
-	//left
-	gpio_init(9) ;
-	gpio_set_dir(9, GPIO_IN);
-	gpio_pull_up(9);
-	
-	//right
-	gpio_init(11) ;
-	gpio_set_dir(11, GPIO_IN);
-	gpio_pull_up(11);
-	
-	//restart button
-	gpio_init(8) ;
-	gpio_set_dir(8, GPIO_IN);
-	gpio_pull_up(8);
-
-    ////////////////////////////////////////////////////////////////////////
-    ///////////////////////// I2C CONFIGURATION ////////////////////////////
-    i2c_init(I2C_CHAN0, 200000) ;
-    gpio_set_function(SDA_PIN0, GPIO_FUNC_I2C) ;
-    gpio_set_function(SCL_PIN0, GPIO_FUNC_I2C) ;
-    gpio_pull_up(SDA_PIN0) ;
-    gpio_pull_up(SCL_PIN0) ;
-	
-	i2c_init(I2C_CHAN1, 200000) ;
-	gpio_set_function(SDA_PIN1, GPIO_FUNC_I2C) ;
-    gpio_set_function(SCL_PIN1, GPIO_FUNC_I2C) ;
-    gpio_pull_up(SDA_PIN1) ;
-    gpio_pull_up(SCL_PIN1) ;
-
-    // MPU6050 initialization
-    mpu6050_reset();
-	mpu6050_read_raw0(accel0, gyro0);
-    mpu6050_read_raw1(accel1, gyro1);
-
-    // Mask our slice's IRQ output into the PWM block's single interrupt line,
-    // and register our interrupt handler
-    pwm_clear_irq(slice_num);
-    pwm_set_irq_enabled(slice_num, true);
-    irq_set_exclusive_handler(PWM_IRQ_WRAP, sensor_irq);
-    irq_set_enabled(PWM_IRQ_WRAP, true);
-	
-	// This section configures the period of the PWM signals
-    pwm_set_wrap(slice_num, WRAPVAL) ;
-    pwm_set_clkdiv(slice_num, CLKDIV) ;
-
-    // This sets duty cycle
-    pwm_set_chan_level(slice_num, PWM_CHAN_B, 0);
-
-    // Start the channel
-    pwm_set_mask_enabled((1u << slice_num));
-
-
-    ////////////////////////////////////////////////////////////////////////
-    ///////////////////////////// ROCK AND ROLL ////////////////////////////
-    ////////////////////////////////////////////////////////////////////////
-    // start core 1 
-    multicore_reset_core1();
-    multicore_launch_core1(core1_entry);
-
-    // start core 0
-    pt_schedule_start ;
-
-}
+/**
+ * Akshati Vaishnav, Grace Lo, Daniela Tran
+ * 
+ * HARDWARE CONNECTIONS
+ *
+ * IMU0
+ *  - 3V3 (OUT) (#36) → Vin
+ *  - GND → GND
+ *  - GPIO 12 (#16) → SDA (prev 8)
+ *  - GPIO 13 (#17) → SCL (prev 9)
+ * Button0
+ *  - GPIO 2 (#4) → Left
+ *  - GPIO 4 (#6) → Right
+ * IMU1
+ *  - 3V3 (OUT) (#36) → Vin
+ *  - GND → GND
+ *  - GPIO 14 (#19) → SDA
+ *  - GPIO 15 (#20) → SCL
+ * IMU data ready
+ *  - GPIO 21 (#27) → IMU0 INT
+ *  - GPIO 22 (#29) → IMU1 INT
+ * Button1
+ *  - GPIO 9 (#12) → Left
+ *  - GPIO 11 (#15) → Right
+ * VGA
+ *  - GND → GND
+ *  - GPIO 16 (#21) → Hsync
+ *  - GPIO 17 (#22) → Vsync
+ *  - GPIO 18 (#24) → 330 ohm resistor → Red
+ *  - GPIO 19 (#25) → 330 ohm resistor → Green
+ *  - GPIO 20 (#26) → 330 ohm resistor → Blue
+ */
+
+
+// Include standard libraries
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+// Include PICO libraries
+#include "pico/stdlib.h"
+#include "pico/multicore.h"
+// Include hardware libraries
+#include "hardware/pwm.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/adc.h"
+#include "hardware/pio.h"
+#include "hardware/i2c.h"
+// Include custom libraries
+#include "vga_graphics.h"
+#include "mpu6050.h"
+#include "fusion.h"
+#include "hud.h"
+// Uncomment to have the schedulers time every thread, and add the numbers
+// to the idle report protothread_stats sends over the UART
+//#define PT_STATS
+#include "pt_cornell_rp2040_v1.h"
+
+// The two IMUs, one per bus
+struct mpu6050_dev imu[2];
+
+// Arrays in which raw measurements will be stored
+fix15 accel0[3], gyro0[3];
+fix15 accel1[3], gyro1[3];
+
+// character array
+char screentext[40];
+
+// draw speed
+int threshold = 1 ;
+
+// Sword angle for each player, fused from their IMU
+struct fusion fuse0, fuse1;
+unsigned int last_stamp0, last_stamp1;
+
+// IMU frames waiting for protothread_sensor
+static struct mpu6050_ring imu_ring;
+
+// Some macros for max/min/abs
+#define min(a,b) ((a<b) ? a:b)
+#define max(a,b) ((a<b) ? b:a)
+#define abs(a) ((a>0) ? a:-a)
+
+// Wakes the animation thread on core 1: a vertical blank, or new fused
+// angles from core 0
+static struct pt_event frame_event ;
+#define FRAME_VBLANK 1
+#define FRAME_SENSOR 2
+// true for a frame that has fused angles newer than the last frame's
+static bool imu_fresh = 0 ;
+
+struct player_struct {
+	bool player_id; //0 or 1
+	short pos_x;
+	short pos_y;
+	bool stab;
+	bool block;
+	bool block_prev;
+	bool stab_prev;
+	int health;
+	bool prev_movement; //0 if previous movement was to left, 1 if prev movement was to right
+}player0, player1;
+
+// How the IMUs are read. IMU_FIFO: each queues its 1 kHz samples in its
+// own FIFO, and protothread_sensor drains both every 8 ms and fuses the
+// batch. IMU_DATA_READY: read each one when its data-ready line
+// (INT_PIN0/1) pulses, and fuse from the sample ring. IMU_PWM: poll both
+// from a 1 kHz PWM wrap interrupt, also through the ring.
+// IMU_FIFO is the default: it needs no wiring beyond the two I2C buses
+// (IMU_DATA_READY needs both INT lines), it takes the least bus time per
+// sample (tests/test_i2c_timing.c), and the thread wakes 125 times a
+// second instead of 1000. Pick another with -D; the host tests build all three
+#if !defined(IMU_FIFO) && !defined(IMU_DATA_READY) && !defined(IMU_PWM)
+#define IMU_FIFO
+#endif
+
+#ifdef IMU_FIFO
+#define SENSOR_USEC 8000
+#else
+#define SENSOR_USEC 1000
+#endif
+
+// Some paramters for PWM
+#define WRAPVAL 5000
+#define CLKDIV  25.0
+uint slice_num ;
+
+bool move_left0 = 0;
+bool move_left1 = 0;
+bool move_right0 = 0;
+bool move_right1 = 0;
+
+//IMU samples fused so far, counted on core 0. The stab counters belong to
+//core 1, which adds on the samples that came in while a stab was held
+volatile unsigned int imu_samples0 = 0;
+volatile unsigned int imu_samples1 = 0;
+unsigned int stab_seen0 = 0;
+unsigned int stab_seen1 = 0;
+int stab_counter0 = 0;
+int stab_counter1 = 0;
+
+char color0 = YELLOW;
+char color1 = CYAN;
+short game_state = 4; 
+
+// Stickman poses, picked from the stab/block flags
+#define POSE_WAIT  0
+#define POSE_STAB  1
+#define POSE_BLOCK 2
+
+// Box around a stickman relative to (pos_x, pos_y) -- covers the sword
+// tips on either side and the feet down to the ground line
+#define STICKMAN_DX 84
+#define STICKMAN_DY 60
+#define STICKMAN_W  168
+#define STICKMAN_H  136
+
+// Pre-rendered poses, indexed by [pose][facing]. A pose that didn't fit
+// in the sprite pool is drawn with the primitives every time instead
+sprite pose_cache[3][2];
+bool pose_cached[3][2];
+
+int player_pose(struct player_struct *player) {
+	if(player->block == 0 && player->stab == 1) {
+		return POSE_STAB;
+	} else if(player->block == 1 && player->stab == 0) {
+		return POSE_BLOCK;
+	}
+	return POSE_WAIT;
+}
+
+// Rasterize one pose with the line/circle primitives. Fills pose_cache at
+// boot; the game loop blits the cached runs instead, unless the capture failed.
+void draw_stickman(short x, short y, bool facing, char pose, char color) {
+	//constant body features
+	drawCircle(x, y-30, 15, color); //head circle
+	drawVLine_fast(x, y-15, 45, color); //body line
+	
+	if(facing == 0) { //facing left
+		//legs
+		drawLine(x, y+30, x-15, y+53, color); //left leg1
+		drawVLine_fast(x-15, y+53, 22, color); //left leg2
+		drawLine(x, y+30, x+6, y+53, color);//right leg1
+		drawLine(x+6, y+53, x+15, y+75, color);//right leg2
+		
+		//arms
+		drawLine(x, y, x+15, y+30, color); //right arm
+		if(pose == POSE_STAB){ //stab!
+			drawLine(x, y, x-30, y+3, color); //left arm
+			drawHLine_fast(x-84, y+3, 60, color); //sword1 --long part
+			drawVLine_fast(x-30, y, 6, color); //sword2 --short part
+		} else if(pose == POSE_BLOCK){ //block!
+			drawLine(x, y, x-11, y+23, color); //left arm1
+			drawLine(x-11, y+23, x-24, y+15, color); //left arm2
+			drawVLine_fast(x-24, y-37, 60, color); //sword1
+			drawHLine_fast(x-29, y+12, 10, color); //sword2
+		} else { //wait state!
+			drawLine(x, y, x-9, y+12, color); //left arm1
+			drawLine(x-9, y+12, x-30, y, color); //left arm2
+			drawLine(x-24, y+6, x-69, y-39, color); //sword1
+			drawLine(x-29, y-5, x-35, y+2, color); //sword2
+		}
+		
+	} else { //facing right
+		
+		//legs
+		drawLine(x, y+30, x-6, y+53, color);//left leg1
+		drawLine(x-6, y+53, x-15, y+75, color);//left leg2
+		drawLine(x, y+30, x+15, y+53, color); //right leg1
+		drawVLine_fast(x+15, y+53, 22, color); //right leg2
+		
+		//arms
+		drawLine(x, y, x-15, y+30, color); //left arm
+		if(pose == POSE_STAB){ //stab!
+			drawLine(x, y, x+30, y+3, color); //right arm
+			drawHLine_fast(x+24, y+3, 60, color); //sword1 --long part
+			drawVLine_fast(x+30, y, 6, color); //sword2 --short part
+		} else if(pose == POSE_BLOCK){ //block!
+			drawLine(x, y, x+11, y+23, color); //right arm1
+			drawLine(x+11, y+23, x+24, y+15, color); //right arm2
+			drawVLine_fast(x+24, y-37, 60, color); //sword1
+			drawHLine_fast(x+19, y+12, 10, color); //sword2
+		} else { //wait state!
+			drawLine(x, y, x+9, y+12, color); //right arm1
+			drawLine(x+9, y+12, x+30, y, color); //right arm2
+			drawLine(x+24, y+6, x+69, y-39, color); //sword1
+			drawLine(x+29, y-5, x+35, y+2, color); //sword2
+		}
+	}
+}
+
+// Draw every pose/facing once in the corner of the (still black) screen,
+// capture it as a sprite, then wipe it again. Colors are applied when the
+// sprite is blitted, so one capture serves both players.
+// If the sprite pool runs out, that pose's bounds are the whole box, so
+// it is still erased cleanly when it is drawn the slow way.
+void build_pose_cache() {
+	for(int pose = 0; pose < 3; pose++) {
+		for(int facing = 0; facing < 2; facing++) {
+			sprite *s = &pose_cache[pose][facing];
+			draw_stickman(STICKMAN_DX, STICKMAN_DY, facing, pose, WHITE);
+			pose_cached[pose][facing] = captureSprite(s, 0, 0, STICKMAN_W, STICKMAN_H);
+			if(!pose_cached[pose][facing]) {
+				s->bx = 0;
+				s->by = 0;
+				s->bw = STICKMAN_W;
+				s->bh = STICKMAN_H;
+			}
+			fillRect(0, 0, STICKMAN_W, STICKMAN_H, BLACK);
+		}
+	}
+}
+
+// What is currently on screen for each player, so a frame only erases
+// and redraws the players that changed
+struct drawn_struct {
+	bool valid; //0 if the player needs drawing from scratch
+	short pos_x;
+	short pos_y;
+	int pose;
+	bool facing;
+}drawn0, drawn1;
+
+// Queue the player's old image for clearing if it moved or changed pose
+void erase_player(struct player_struct *player, struct drawn_struct *drawn) {
+	if(drawn->valid == 0) {
+		return;
+	}
+	if(drawn->pos_x != player->pos_x || drawn->pos_y != player->pos_y || drawn->pose != player_pose(player) || drawn->facing != player->prev_movement) {
+		sprite *s = &pose_cache[drawn->pose][drawn->facing];
+		markDirty(drawn->pos_x-STICKMAN_DX+s->bx, drawn->pos_y-STICKMAN_DY+s->by, s->bw, s->bh);
+		drawn->valid = 0;
+	}
+}
+
+// Blit the player if its image is gone (moved, new pose, or cleared under it)
+void draw_player(struct player_struct *player, struct drawn_struct *drawn, char color) {
+	int pose = player_pose(player);
+	sprite *s = &pose_cache[pose][player->prev_movement];
+	short x = player->pos_x-STICKMAN_DX;
+	short y = player->pos_y-STICKMAN_DY;
+	if(drawn->valid == 0 || isDirty(x+s->bx, y+s->by, s->bw, s->bh)) {
+		if(pose_cached[pose][player->prev_movement]) {
+			blitSprite(s, x, y, color);
+		} else {
+			draw_stickman(player->pos_x, player->pos_y, player->prev_movement, pose, color);
+		}
+		drawn->valid = 1;
+		drawn->pos_x = player->pos_x;
+		drawn->pos_y = player->pos_y;
+		drawn->pose = pose;
+		drawn->facing = player->prev_movement;
+	}
+}
+
+// Put back the ground line wherever the last clear cut through it
+void repair_ground() {
+	const struct vga_rect *rects;
+	int n = getDirtyRects(&rects);
+	for(int i = 0; i < n; i++) {
+		if(rects[i].y <= 420 && rects[i].y+rects[i].h > 420) {
+			drawHLine_fast(rects[i].x, 420, rects[i].w, WHITE);
+		}
+	}
+}
+
+/* GAME STATES
+0 = player 0 wins
+1 = player 1 wins
+2 = regular gameplay
+3 = wait to restart game and then restart game
+4 = start screen
+5 = instruction screen
+*/
+// Interrupt service routine
+void sensor_irq() {
+
+    // Clear the interrupt flag that brought us here
+    pwm_clear_irq(slice_num);
+
+    // Start reading both IMUs; sensor_update runs once both have landed.
+    // If the last pair is somehow still on the bus, this tick is skipped
+    mpu6050_async_start();
+}
+
+// Runs from the I2C interrupt when a frame of IMU samples is published.
+// Only queues it; protothread_sensor does the rest
+void sensor_update() {
+	mpu6050_ring_push(&imu_ring, mpu6050_async_frame());
+}
+
+// Runs from the vblank interrupt on core 0; the frame is stepped on core 1
+void frame_vblank() {
+	pt_event_signal(&frame_event, FRAME_VBLANK);
+}
+
+// Fuses every new IMU sample in order, then polls the buttons
+static PT_THREAD (protothread_sensor(struct pt *pt)) {
+    PT_BEGIN(pt);
+	static struct mpu6050_frame frame;
+	static bool fused;
+#ifdef IMU_FIFO
+	static unsigned int batch_seen;
+	static const struct mpu6050_batch *batch;
+#endif
+	
+	while(1) {
+		fused = 0;
+#ifdef IMU_FIFO
+		//fuse what the last drain brought in, then start the next one
+		if(mpu6050_async_count() != batch_seen) {
+			batch_seen = mpu6050_async_count();
+			batch = mpu6050_async_batch();
+			frame = *mpu6050_async_frame();
+			fused = 1;
+			for (int i = 0; i < 3; i++) {
+				accel0[i] = frame.imu[0].accel[i];
+				gyro0[i] = frame.imu[0].gyro[i];
+				accel1[i] = frame.imu[1].accel[i];
+				gyro1[i] = frame.imu[1].gyro[i];
+			}
+			
+			//the FIFO records are evenly spaced at the sample rate
+			fusion_update_batch(&fuse0, batch->imu[0], batch->count[0], fusion_dt_usec(MPU6050_SAMPLE_USEC));
+			fusion_update_batch(&fuse1, batch->imu[1], batch->count[1], fusion_dt_usec(MPU6050_SAMPLE_USEC));
+			
+			//stab length is counted in samples (see fight_update)
+			imu_samples0 += batch->count[0];
+			imu_samples1 += batch->count[1];
+		}
+		mpu6050_async_start();
+#else
+		while(mpu6050_ring_pop(&imu_ring, &frame)) {
+			fused = 1;
+			for (int i = 0; i < 3; i++) {
+				accel0[i] = frame.imu[0].accel[i];
+				gyro0[i] = frame.imu[0].gyro[i];
+				accel1[i] = frame.imu[1].accel[i];
+				gyro1[i] = frame.imu[1].gyro[i];
+			}
+			
+			//low-pass the accel and blend its tilt with the gyro, timed by the samples themselves;
+			//a frame sent early for one IMU's next sample only has that one fresh
+			if (frame.fresh & 1) {
+				fusion_update(&fuse0, &frame.imu[0], fusion_dt_usec(last_stamp0 ? frame.stamp[0] - last_stamp0 : 1000));
+				last_stamp0 = frame.stamp[0];
+				//stab length is counted in samples (see fight_update)
+				imu_samples0 += 1;
+			}
+			if (frame.fresh & 2) {
+				fusion_update(&fuse1, &frame.imu[1], fusion_dt_usec(last_stamp1 ? frame.stamp[1] - last_stamp1 : 1000));
+				last_stamp1 = frame.stamp[1];
+				imu_samples1 += 1;
+			}
+		}
+#endif
+		
+		//let the next frame know the angles moved on
+		if(fused) {
+			pt_event_signal(&frame_event, FRAME_SENSOR);
+		}
+		
+		//buttons
+		if(gpio_get(2) == 0 && gpio_get(4) == 0) { //if both l+r buttons are pressed, NO MOVEMENT
+			move_left0 = 0;
+			move_right0 = 0;
+		} else if (gpio_get(2) == 0 && gpio_get(4) == 1) { //if l button is pressed, move left
+			move_left0 = 1;
+			move_right0 = 0;
+		} else if (gpio_get(2) == 1 && gpio_get(4) == 0) { //if r button is pressed, move right
+			move_left0 = 0;
+			move_right0 = 1;
+		} else if (gpio_get(2) == 1 && gpio_get(4) == 1) { //if l+r buttons are NOT pressed, NO MOVEMENT
+			move_left0 = 0;
+			move_right0 = 0;
+		}
+	
+		if(gpio_get(9) == 0 && gpio_get(11) == 0) { //if both l+r buttons are pressed, NO MOVEMENT
+			move_left1 = 0;
+			move_right1 = 0;
+		} else if (gpio_get(9) == 0 && gpio_get(11) == 1) { //if l button is pressed, move left
+			move_left1 = 1;
+			move_right1 = 0;
+		} else if (gpio_get(9) == 1 && gpio_get(11) == 0) { //if r button is pressed, move right
+			move_left1 = 0;
+			move_right1 = 1;
+		} else if (gpio_get(9) == 1 && gpio_get(11) == 1) { //if l+r buttons are NOT pressed, NO MOVEMENT
+			move_left1 = 0;
+			move_right1 = 0;
+		}
+	
+		PT_YIELD(pt);
+	}
+	PT_END(pt);
+}
+
+// Text buffers
+static char winner_print[40];
+static char restart_print[40];
+static char start_print0[40];
+static char start_print1[40];
+static char start_print2[40];
+static char instruction_print[100];
+
+// Health bars and numbers
+struct hud_health hud0, hud1;
+
+// Each game state is a set of hooks run by protothread_anim1:
+//  on_enter  -- draws everything that doesn't change while in the state
+//  on_update -- runs once per frame, returns the next state
+//  on_exit   -- runs when leaving, after leave_usec has passed
+// Static screens draw once on entry and then only poll the button.
+struct game_state_handler {
+	void (*on_enter)(void);
+	short (*on_update)(void);
+	void (*on_exit)(void);
+	int leave_usec; //pause before leaving (win message hold, button debounce)
+};
+
+// Primitive calls per second in each state, from vga_draw_calls(); the last
+// full second spent in the state, reported by protothread_stats
+unsigned int state_draw_rate[6];
+
+//health bars, ground, and a clean slate for the players
+void fight_enter() {
+	fillRect(0, 0, 640, 480, BLACK);
+	
+	//health bars
+	hud_health_init(&hud0, 40, 42, 247, 43, color0, player0.health);
+	hud_health_init(&hud1, 350, 42, 557, 43, color1, player1.health);
+	
+	//horizontal line (ground); players get drawn from scratch
+	drawHLine_fast(0, 420, 640, WHITE);
+	drawn0.valid = 0;
+	drawn1.valid = 0;
+}
+
+//one frame of gameplay
+short fight_update() {
+	unsigned int samples0, samples1;
+	
+	//stab length is counted in IMU samples: add on the ones core 0 has
+	//fused since the last frame, while the stab was held
+	samples0 = imu_samples0;
+	samples1 = imu_samples1;
+	if(player0.stab == 1) {
+		stab_counter0 += samples0 - stab_seen0;
+	}
+	if(player1.stab == 1) {
+		stab_counter1 += samples1 - stab_seen1;
+	}
+	stab_seen0 = samples0;
+	stab_seen1 = samples1;
+	
+	/* PLAYER 0 */		
+	//stabbing logic -- player0
+	//the sword only moves with new fused angles
+	if(imu_fresh) {
+		if((fix2int15(fuse0.angle) >= 75) && (fix2int15(fuse0.angle) <= 105) && (fix2float15(accel0[1]) > 0.01)) {
+			if (stab_counter0 < 500) {
+				player0.stab = 1;
+			} else {
+				player0.stab = 0;
+				stab_counter0 = 0;
+			}
+			player0.block = 0;
+		} else if ((fix2int15(fuse0.angle) >= -15) && (fix2int15(fuse0.angle) <= 15)) {
+			player0.block = 1;
+			player0.stab = 0;
+		} else {
+			player0.block = 0;
+			player0.stab = 0;
+		}
+	}
+	
+	//moving logic -- player0
+	if(move_left0 == 1 && move_right0 == 0 && player0.pos_x-84-5 >= 0) { //last check is for VGA walls
+		player0.pos_x -= 5;
+		if(player0.prev_movement == 1) { //player0 was moving right, but now its moving left...
+			player0.prev_movement = 0;
+		}
+	} else if(move_left0 == 0 && move_right0 == 1 && player0.pos_x+84+5 <= 639) { //last check is for VGA walls
+		player0.pos_x += 5;
+		if(player0.prev_movement == 0) { //player0 was moving right, but now its moving left...
+			player0.prev_movement = 1;
+		}
+	}
+	
+	/* PLAYER 1 */
+	//stabbing logic -- player1
+	//the sword only moves with new fused angles
+	if(imu_fresh) {
+		if((fix2int15(fuse1.angle) >= 75) && (fix2int15(fuse1.angle) <= 105) && (fix2float15(accel1[1]) > 0.01)) {
+			if (stab_counter1 < 500) {
+				player1.stab = 1;
+			} else {
+				player1.stab = 0;
+				stab_counter1 = 0;
+			}
+			player1.block = 0;
+		} else if ((fix2int15(fuse1.angle) >= -15) && (fix2int15(fuse1.angle) <= 15)) {
+			player1.block = 1;
+			player1.stab = 0;
+		} else {
+			player1.block = 0;
+			player1.stab = 0;
+		}
+	}
+	
+	//moving logic -- player1
+	if(move_left1 == 1 && move_right1 == 0 && player1.pos_x-84-5 >= 0) { //VGA box
+		player1.pos_x -= 5;
+		if(player1.prev_movement == 1) { //player1 was moving right, but now its moving left...
+			player1.prev_movement = 0;
+		}
+	} else if(move_left1 == 0 && move_right1 == 1 && player1.pos_x+84+5 <= 639) { //VGA box
+		player1.pos_x += 5;
+		if(player1.prev_movement == 0) { //player1 was moving left, but now its moving right...
+			player1.prev_movement = 1;
+		}
+	}
+	
+	//erase what moved or changed pose, then redraw whatever the clear touched,
+	//all inside the blanking window so the players never tear
+	vga_wait_vblank();
+	erase_player(&player0, &drawn0);
+	erase_player(&player1, &drawn1);
+	clearDirty(BLACK);
+	repair_ground();
+	draw_player(&player0, &drawn0, color0);
+	draw_player(&player1, &drawn1, color1);
+	
+	//health bars and numbers, in the same window; only what changed since
+	//the last frame is redrawn
+	hud_health_update(&hud0, player0.health);
+	hud_health_update(&hud1, player1.health);
+	
+	//prev movement is: 0 if move left, 1 if move right
+	if(player0.block != player0.block_prev || player0.stab != player0.stab_prev || player1.block != player1.block_prev || player1.stab != player1.stab_prev) {
+		if(player0.pos_x < player1.pos_x) { //player0 is to the left of player1
+			if(player0.prev_movement == 1 && player1.prev_movement == 0) { //face each other
+				//player0 faces right, player1 faces left
+				if(player0.stab == 1 && player1.block == 0 && ((player1.pos_x - player0.pos_x)>=30) && ((player1.pos_x - player0.pos_x)<=114)) { // player0 stabbing player1
+					player1.health -= 1;
+				}
+				if(player1.stab == 1 && player0.block == 0 && ((player1.pos_x - player0.pos_x)>=30) && ((player1.pos_x - player0.pos_x)<=114)) { // player1 stabbing player0
+					player0.health -= 1;
+				}
+				
+			} else if(player0.prev_movement == 0 && player1.prev_movement == 1) { //face away from each other
+				//player0 faces left, player1 faces right
+				//do nothing because they aren't facing each other and player0 is to the left of player1
+				return 2;
+			} else if(player0.prev_movement == 1 && player1.prev_movement == 1) { //p0 faces p1, p1 looks away from p0
+				//player0 faces right, player1 faces right => player1's blocks do not matter! also player1 cannot stab player0
+				if(player0.stab == 1 && ((player1.pos_x - player0.pos_x)>=30) && ((player1.pos_x - player0.pos_x)<=84)) { // player0 stabbing player1
+					player1.health -= 1;
+				}
+			} else if(player0.prev_movement == 0 && player1.prev_movement == 0) { //p1 faces p0, p0 looks away from p1
+				//player0 faces left, player1 faces left => player0's blocks do not matter! also player0 cannot stab player1
+				if(player1.stab == 1 && ((player1.pos_x - player0.pos_x)>=30) && ((player1.pos_x - player0.pos_x)<=84)) { // player1 stabbing player0
+					player0.health -= 1;
+				}
+			}
+		} else if(player0.pos_x > player1.pos_x) { //player0 is to the right of player1
+			if(player0.prev_movement == 1 && player1.prev_movement == 0) { //face away from each other
+				//player0 faces right, player1 faces left
+				//do nothing because they aren't facing each other and player1 is to the left of player0
+			} else if(player0.prev_movement == 0 && player1.prev_movement == 1) { //face each other
+				//player0 faces left, player1 faces right
+				if(player0.stab == 1 && player1.block == 0 && ((player0.pos_x - player1.pos_x)>=30) && ((player0.pos_x - player1.pos_x)<=114)) { // player0 stabbing player1
+					player1.health -= 1;
+				}
+				if(player1.stab == 1 && player0.block == 0 && ((player0.pos_x - player1.pos_x)>=30) && ((player0.pos_x - player1.pos_x)<=114)) { // player1 stabbing player0
+					player0.health -= 1;
+				}
+			} else if(player0.prev_movement == 1 && player1.prev_movement == 1) { //p1 faces p0, p0 looks away from p1
+				//player0 faces right, player1 faces right => player0's blocks do not matter! also player0 cannot stab player1
+				if(player1.stab == 1 && player1.block == 0 && ((player0.pos_x - player1.pos_x)>=30) && ((player0.pos_x - player1.pos_x)<=84)) { // player1 stabbing player0
+					player0.health -= 1;
+				}
+			} else if(player0.prev_movement == 0 && player1.prev_movement == 0) { //p0 faces p1, p1 looks away from p0
+				//player0 faces left, player1 faces left => player1's blocks do not matter! also player1 cannot stab player0
+				if(player0.stab == 1 && player0.block == 0 && ((player0.pos_x - player1.pos_x)>=30) && ((player0.pos_x - player1.pos_x)<=84)) { // player0 stabbing player1
+					player1.health -= 1;
+				}
+			}
+		}
+	}
+	player0.block_prev = player0.block;
+	player0.stab_prev = player0.stab;
+	player1.block_prev = player1.block;
+	player1.stab_prev = player1.stab;
+	
+	
+	//game state changes
+	if(player0.health < 0) {
+		drawRect(40, 42, 202, 10, color0);
+		return 1; //player1 wins
+	} else if (player1.health < 0) {
+		drawRect(350, 42, 202, 10, color1);
+		return 0; //player0 wins
+	}
+	return 2;
+}
+
+//state 0 or 1 -- game_state says who won
+void winner_enter() {
+	setTextColor2(WHITE, BLACK); 
+	setCursor(200, 200); 
+	setTextSize(3);
+	sprintf(winner_print, "Player %d Wins!", game_state);
+	writeString(winner_print);
+}
+
+short winner_update() {
+	return 3;
+}
+
+void restart_enter() {
+	setTextSize(2);
+	setTextColor2(WHITE, BLACK); 
+	setCursor(180, 350); 
+	sprintf(restart_print, "Press button to restart!");
+	writeString(restart_print);
+}
+
+short restart_update() {
+	return (gpio_get(8) == 0) ? 2 : 3;
+}
+
+//put both players back at their starting spots
+void restart_exit() {
+	player0.player_id = 0;
+	player0.pos_x = (140);
+	player0.pos_y = (345);
+	player0.stab = 0;
+	player0.block = 0;
+	player0.block_prev = 0;
+	player0.stab_prev = 0;
+	player0.health = 100;
+	
+	player1.player_id = 1;
+	player1.pos_x = (500);
+	player1.pos_y = (345);
+	player1.stab = 0;
+	player1.block = 0;
+	player1.block_prev = 0;
+	player1.stab_prev = 0;
+	player1.health = 100;
+}
+
+//start screen
+void start_enter() {
+	//title print
+	setTextSize(5);
+	setTextColor2(RED, BLACK); 
+	setCursor(190, 150); 
+	sprintf(start_print0, "STICKMAN");
+	writeString(start_print0);
+	setCursor(235, 200); 
+	sprintf(start_print1, "NINJA");
+	writeString(start_print1);
+	setTextSize(2);
+	setCursor(150, 350); 
+	sprintf(start_print2, "Press button to continue...");
+	writeString(start_print2);
+}
+
+short start_update() {
+	return (gpio_get(8) == 0) ? 5 : 4;
+}
+
+void start_exit() {
+	fillRect(0, 0, 640, 480, BLACK);
+}
+
+//instruction screen
+void instructions_enter() {
+	//print instructions!!!
+	setTextSize(4);
+	setTextColor2(GREEN, BLACK); 
+	setCursor(175, 50); 
+	sprintf(instruction_print, "INSTRUCTIONS");
+	writeString(instruction_print);
+	/* Instruction Text:
+	To move:
+		Move left: press left button
+		Move right: press right button 
+		
+	To use the sword:
+		Make sure the IMU faces right!
+		To stab: hold the board horizontally and move in a stabbing motion 
+		To block: hold the board vertically
+	*/
+	setTextColor2(WHITE, BLACK); 
+	setTextSize(3);
+	setCursor(50, 110); 
+	sprintf(instruction_print, "To move...");
+	writeString(instruction_print);
+	setTextSize(2);
+	setCursor(70, 140); 
+	sprintf(instruction_print, "Move left: press left button");
+	writeString(instruction_print);
+	setCursor(70, 160); 
+	sprintf(instruction_print, "Move right: press right button");
+	writeString(instruction_print);
+	
+	setTextSize(3);
+	setCursor(50, 210); 
+	sprintf(instruction_print, "To use the sword...");
+	writeString(instruction_print);
+	setTextSize(2);
+	setCursor(70, 240); 
+	sprintf(instruction_print, "Make sure the IMU faces right!");
+	writeString(instruction_print);
+	setCursor(70, 260); 
+	sprintf(instruction_print, "To stab: hold the board horizontally and ");
+	writeString(instruction_print);
+	setCursor(70, 280); 
+	sprintf(instruction_print, "move in a stabbing motion");
+	writeString(instruction_print);
+	setCursor(70, 300); 
+	sprintf(instruction_print, "To block: hold the board vertically");
+	writeString(instruction_print);
+}
+
+short instructions_update() {
+	return (gpio_get(8) == 0) ? 2 : 5;
+}
+
+struct game_state_handler game_states[6] = {
+	{winner_enter, winner_update, NULL, 1000000},               //0 = player 0 wins
+	{winner_enter, winner_update, NULL, 1000000},               //1 = player 1 wins
+	{fight_enter, fight_update, NULL, 0},                       //2 = regular gameplay
+	{restart_enter, restart_update, restart_exit, 100000},      //3 = wait to restart game
+	{start_enter, start_update, start_exit, 1000000},           //4 = start screen
+	{instructions_enter, instructions_update, NULL, 100000},    //5 = instruction screen
+};
+
+//animation thread
+static PT_THREAD (protothread_anim1(struct pt *pt)) {
+    // Mark beginning of thread
+    PT_BEGIN(pt);
+    // Which frame events woke us
+	static unsigned int frame_bits;
+	static short next_state;
+	// Variables for the draw-call rate
+	static unsigned int rate_start;
+	static unsigned int rate_draws;
+	
+	player0.player_id = 0;
+	player0.pos_x = (140);
+	player0.pos_y = (345);
+	player0.stab = 0;
+	player0.block = 0;
+	player0.block_prev = 0;
+	player0.stab_prev = 0;
+	player0.health = 100;
+	player0.prev_movement = 1; //player0 initially faces player1 -- so player0 faces right
+	
+	player1.player_id = 1;
+	player1.pos_x = (500);
+	player1.pos_y = (345);
+	player1.stab = 0;
+	player1.block = 0;
+	player1.block_prev = 0;
+	player1.stab_prev = 0;
+	player1.health = 100;
+	player1.prev_movement = 0; //player1 initially faces player0 -- so player1 faces left
+	
+	PT_YIELD_usec(100000);
+	
+	game_states[game_state].on_enter();
+	rate_start = time_us_32();
+	rate_draws = vga_draw_calls();
+	
+    while(1) {
+		//one step per frame; the step starts at the vblank interrupt, and the
+		//erase/redraw in gameplay waits the last active line out (vga_wait_vblank).
+		//core 1 sleeps until the vblank interrupt raises FRAME_VBLANK
+		PT_EVENT_WAIT(pt, &frame_event, FRAME_VBLANK, frame_bits);
+		imu_fresh = pt_event_take(&frame_event, FRAME_SENSOR) != 0;
+		
+		next_state = game_states[game_state].on_update();
+		
+		if(next_state != game_state) {
+			if(game_states[game_state].leave_usec > 0) {
+				PT_YIELD_usec(game_states[game_state].leave_usec);
+			}
+			if(game_states[game_state].on_exit != NULL) {
+				game_states[game_state].on_exit();
+			}
+			game_state = next_state;
+			game_states[game_state].on_enter();
+			rate_start = time_us_32();
+			rate_draws = vga_draw_calls();
+		} else if(time_us_32() - rate_start >= 1000000) {
+			state_draw_rate[game_state] = vga_draw_calls() - rate_draws;
+			rate_start = time_us_32();
+			rate_draws = vga_draw_calls();
+		}
+		// NEVER exit while
+    } // END WHILE(1)
+  PT_END(pt);
+} // animation thread
+
+// Reports how idle each core is and how much each game state draws over
+// the UART every few seconds, with the thread stats of both cores under
+// PT_STATS
+static PT_THREAD (protothread_stats(struct pt *pt)) {
+    PT_BEGIN(pt);
+#ifdef PT_STATS
+	static int core, id;
+#endif
+	
+	while(1) {
+		PT_YIELD_usec(5000000);
+		serial_write_idle;
+		snprintf(pt_serial_out_buffer, pt_buffer_size,
+			"draws/s win0=%u win1=%u fight=%u restart=%u start=%u help=%u\r\n",
+			state_draw_rate[0], state_draw_rate[1], state_draw_rate[2],
+			state_draw_rate[3], state_draw_rate[4], state_draw_rate[5]);
+		serial_write;
+#ifdef PT_STATS
+		for (core = 0; core < 2; core++) {
+			for (id = 0; id < MAX_THREADS; id++) {
+				serial_write_stats(core, id);
+			}
+		}
+#endif
+	}
+  PT_END(pt);
+}
+
+// Entry point for core 1
+void core1_entry() {
+	pt_add_thread(protothread_anim1);
+    pt_schedule_start ;
+}
+
+int main() {
+
+    // Initialize stdio
+    stdio_init_all();
+
+    // Initialize VGA
+    initVGA() ;
+
+    // Frames are stepped at each vertical blank
+    pt_event_init(&frame_event) ;
+    vga_set_vblank_callback(frame_vblank) ;
+
+    // Pre-render the stickman poses
+    build_pose_cache() ;
+	
+	//button config
+	//left
+	gpio_init(2) ;
+	gpio_set_dir(2, GPIO_IN);
+	gpio_pull_up(2);
+
+	//right
+	gpio_init(4) ;
+	gpio_set_dir(4, GPIO_IN);
+	gpio_pull_up(4);
+	
+	//left
+	gpio_init(9) ;
+	gpio_set_dir(9, GPIO_IN);
+	gpio_pull_up(9);
+	
+	//right
+	gpio_init(11) ;
+	gpio_set_dir(11, GPIO_IN);
+	gpio_pull_up(11);
+	
+	//restart button
+	gpio_init(8) ;
+	gpio_set_dir(8, GPIO_IN);
+	gpio_pull_up(8);
+
+    ////////////////////////////////////////////////////////////////////////
+    ///////////////////////// I2C CONFIGURATION ////////////////////////////
+    i2c_init(I2C_CHAN0, 200000) ;
+    gpio_set_function(SDA_PIN0, GPIO_FUNC_I2C) ;
+    gpio_set_function(SCL_PIN0, GPIO_FUNC_I2C) ;
+    gpio_pull_up(SDA_PIN0) ;
+    gpio_pull_up(SCL_PIN0) ;
+	
+	i2c_init(I2C_CHAN1, 200000) ;
+	gpio_set_function(SDA_PIN1, GPIO_FUNC_I2C) ;
+    gpio_set_function(SCL_PIN1, GPIO_FUNC_I2C) ;
+    gpio_pull_up(SDA_PIN1) ;
+    gpio_pull_up(SCL_PIN1) ;
+
+    // MPU6050 initialization
+    mpu6050_dev_init(&imu[0], I2C_CHAN0, ADDRESS);
+    mpu6050_dev_init(&imu[1], I2C_CHAN1, ADDRESS);
+    mpu6050_init_all(imu, 2);
+    fusion_init(&fuse0, 6, zeropt999, zeropt001);
+    fusion_init(&fuse1, 6, zeropt999, zeropt001);
+
+    // From here on the IMUs are read from the I2C interrupts
+#if defined(IMU_FIFO)
+    mpu6050_fifo_enable(&imu[0]);
+    mpu6050_fifo_enable(&imu[1]);
+    mpu6050_async_init(imu, 2, NULL);
+#elif defined(IMU_DATA_READY)
+    imu[0].int_pin = INT_PIN0;
+    imu[1].int_pin = INT_PIN1;
+    mpu6050_async_init(imu, 2, sensor_update);
+#else
+    mpu6050_async_init(imu, 2, sensor_update);
+
+    // Mask our slice's IRQ output into the PWM block's single interrupt line,
+    // and register our interrupt handler
+    slice_num = pwm_gpio_to_slice_num(5);
+    pwm_clear_irq(slice_num);
+    pwm_set_irq_enabled(slice_num, true);
+    irq_set_exclusive_handler(PWM_IRQ_WRAP, sensor_irq);
+    irq_set_enabled(PWM_IRQ_WRAP, true);
+	
+	// This section configures the period of the PWM signals
+    pwm_set_wrap(slice_num, WRAPVAL) ;
+    pwm_set_clkdiv(slice_num, CLKDIV) ;
+
+    // This sets duty cycle
+    pwm_set_chan_level(slice_num, PWM_CHAN_B, 0);
+
+    // Start the channel
+    pwm_set_mask_enabled((1u << slice_num));
+#endif
+
+
+    ////////////////////////////////////////////////////////////////////////
+    ///////////////////////////// ROCK AND ROLL ////////////////////////////
+    ////////////////////////////////////////////////////////////////////////
+    // threads run by period and priority on both cores
+    pt_sched_method = SCHED_RATE ;
+
+    // start core 1 
+    multicore_reset_core1();
+    multicore_launch_core1(core1_entry);
+
+    // start core 0; the sensor thread takes in new IMU samples every
+    // SENSOR_USEC
+    pt_add_thread_rate(protothread_sensor, SENSOR_USEC, 0);
+    pt_add_thread(protothread_stats);
+    pt_schedule_start ;
+
+}
@@ -0,0 +1,151 @@
+/**
+ * Host-side harness: SDK globals and the pieces of pico/stdlib.h that need
+ * state
+ */
+
+#include <pthread.h>
+#include <time.h>
+#include "host.h"
+#include "hardware/sync.h"
+#include "hardware/pio.h"
+#include "hardware/dma.h"
+#include "hardware/structs/systick.h"
+
+timer_hw_t host_timer ;
+timer_hw_t *timer_hw = &host_timer ;
+uart_inst_t *uart0 ;
+static pio_hw_t host_pio0 ;
+PIO pio0 = &host_pio0 ;
+static dma_hw_t host_dma ;
+dma_hw_t *dma_hw = &host_dma ;
+static systick_hw_t host_systick ;
+systick_hw_t *systick_hw = &host_systick ;
+struct host_pio_sm host_pio_sm[4] ;
+enum dma_channel_transfer_size host_dma_size[12] ;
+
+irq_handler_t host_irq_handler[32] ;
+gpio_irq_callback_t host_gpio_callback ;
+bool host_gpio_level[30] ;
+_Thread_local uint host_core ;
+
+int check_failures ;
+volatile int host_sink ;
+
+double host_nsec(void) {
+    struct timespec t ;
+    clock_gettime(CLOCK_MONOTONIC, &t) ;
+    return t.tv_sec * 1e9 + t.tv_nsec ;
+}
+
+void irq_set_exclusive_handler(uint num, irq_handler_t handler) {
+    host_irq_handler[num] = handler ;
+}
+
+bool host_in_irq ;
+_Thread_local bool host_irqs_off ;
+void (*host_irq_pending)(void) ;
+
+void host_irq(uint num) {
+    bool nested = host_in_irq ;
+
+    host_in_irq = true ;
+    if (host_irq_handler[num]) host_irq_handler[num]() ;
+    host_in_irq = nested ;
+}
+
+void host_irqs_enabled(void) {
+    if (host_irq_pending && !host_in_irq) host_irq_pending() ;
+}
+
+void gpio_set_irq_enabled_with_callback(uint gpio, uint32_t events, bool enabled, gpio_irq_callback_t callback) {
+    (void) gpio ; (void) events ; (void) enabled ;
+    host_gpio_callback = callback ;
+}
+
+void host_gpio_edge(uint gpio, uint32_t events) {
+    if (host_gpio_callback) host_gpio_callback(gpio, events) ;
+}
+
+bool gpio_get(uint gpio) {
+    return host_gpio_level[gpio] ;
+}
+
+void uart_putc(uart_inst_t *uart, char c) {
+    (void) uart ;
+    putchar(c) ;
+}
+
+// Cores and events. Each test thread says which core it plays through
+// host_core. SEV/WFE work across threads as they do across cores: the
+// event is latched, so a WFE after an SEV the thread hasn't seen yet
+// returns at once, and otherwise sleeps until the next SEV
+uint get_core_num(void) {
+    return host_core ;
+}
+
+void (*host_wfe_hook)(void) ;
+
+static pthread_mutex_t event_mutex = PTHREAD_MUTEX_INITIALIZER ;
+static pthread_cond_t event_cond = PTHREAD_COND_INITIALIZER ;
+static unsigned int event_count ;
+static _Thread_local unsigned int event_seen ;
+
+void __sev(void) {
+    pthread_mutex_lock(&event_mutex) ;
+    event_count++ ;
+    pthread_cond_broadcast(&event_cond) ;
+    pthread_mutex_unlock(&event_mutex) ;
+}
+
+void __wfe(void) {
+    if (host_wfe_hook) {
+        host_wfe_hook() ;
+        return ;
+    }
+    pthread_mutex_lock(&event_mutex) ;
+    while (event_seen == event_count) pthread_cond_wait(&event_cond, &event_mutex) ;
+    event_seen = event_count ;
+    pthread_mutex_unlock(&event_mutex) ;
+}
+
+bool best_effort_wfe_or_timeout(absolute_time_t t) {
+    // nothing else will move the clock while a single-threaded test sleeps
+    if ((int32_t) ((uint32_t) t - timer_hw->timerawl) > 0) timer_hw->timerawl = (uint32_t) t ;
+    return true ;
+}
+
+// Spinlocks
+static spin_lock_t locks[32] ;
+static uint32_t claimed ;
+
+spin_lock_t *spin_lock_instance(unsigned int lock_num) {
+    return &locks[lock_num] ;
+}
+
+spin_lock_t *spin_lock_init(unsigned int lock_num) {
+    spin_unlock_unsafe(&locks[lock_num]) ;
+    return &locks[lock_num] ;
+}
+
+void spin_lock_claim(unsigned int lock_num) {
+    if (claimed & (1u << lock_num)) {
+        printf("spin lock %u claimed twice\n", lock_num) ;
+        check_failures++ ;
+    }
+    claimed |= 1u << lock_num ;
+}
+
+int spin_lock_claim_unused(bool required) {
+    for (int i = 24; i < 32; i++) {
+        if (!(claimed & (1u << i))) {
+            claimed |= 1u << i ;
+            return i ;
+        }
+    }
+    if (required) check_failures++ ;
+    return -1 ;
+}
+
+bool spin_lock_is_claimed(unsigned int lock_num) {
+    return (claimed >> lock_num) & 1 ;
+}
@@ -0,0 +1,40 @@
+/**
+ * Host-side harness for the tests: the simulated clock, recorded interrupt
+ * handlers and GPIO, and a small check macro
+ */
+#pragma once
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "hardware/irq.h"
+
+extern timer_hw_t host_timer ;
+extern irq_handler_t host_irq_handler[32] ;
+extern gpio_irq_callback_t host_gpio_callback ;
+extern bool host_gpio_level[30] ;
+extern _Thread_local uint host_core ;
+// Runs in place of sleeping in __wfe, to make whatever is waited for happen
+extern void (*host_wfe_hook)(void) ;
+
+// Run the handler recorded for an NVIC interrupt, if any
+void host_irq(uint num) ;
+// True while a handler runs; handlers don't preempt each other
+extern bool host_in_irq ;
+// Set by a model that raises interrupts on its own: runs the ones held
+// back while host_irqs_off was set, once restore_interrupts clears it
+extern void (*host_irq_pending)(void) ;
+// Raise a GPIO edge through the registered callback
+void host_gpio_edge(uint gpio, uint32_t events) ;
+
+// Wall-clock nanoseconds, for the benchmarks
+double host_nsec(void) ;
+// Keeps a benchmark's result from being optimized away
+extern volatile int host_sink ;
+
+extern int check_failures ;
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond) ; \
+        check_failures++ ; \
+    } \
+} while (0)
+#define CHECK_DONE() (printf(check_failures ? "FAIL (%d)\n" : "ok\n", check_failures), check_failures != 0)
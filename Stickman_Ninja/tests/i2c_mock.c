@@ -0,0 +1,269 @@
+/**
+ * A model of the RP2040 I2C controllers with MPU6050s on their buses.
+ * See i2c_mock.h
+ */
+
+#include "host.h"
+#include "i2c_mock.h"
+
+#define REG_INT_PIN_CFG 0x37
+#define REG_INT_ENABLE  0x38
+#define REG_INT_STATUS  0x3A
+#define REG_FIFO_EN     0x23
+#define REG_USER_CTRL   0x6A
+#define REG_FIFO_COUNT  0x72
+#define REG_FIFO_R_W    0x74
+#define FIFO_SIZE       1024
+
+static i2c_inst_t inst[MOCK_BUSES] = {{0}, {1}} ;
+i2c_inst_t *i2c0 = &inst[0] ;
+i2c_inst_t *i2c1 = &inst[1] ;
+
+static i2c_hw_t regs[MOCK_BUSES] ;
+struct i2c_mock_bus i2c_mock_bus[MOCK_BUSES] ;
+static struct mpu_model models[MOCK_DEVS] ;
+static int nmodels ;
+
+static void take_interrupts(void) ;
+
+i2c_hw_t *i2c_get_hw(i2c_inst_t *i2c) {
+    return &regs[i2c->index] ;
+}
+
+static int bus_of(i2c_hw_t *hw) {
+    return (int) (hw - regs) ;
+}
+
+void i2c_mock_reset(void) {
+    memset(regs, 0, sizeof(regs)) ;
+    memset(i2c_mock_bus, 0, sizeof(i2c_mock_bus)) ;
+    memset(models, 0, sizeof(models)) ;
+    nmodels = 0 ;
+    i2c_mock_eager = false ;
+    host_irq_pending = take_interrupts ;
+}
+
+struct mpu_model *mpu_model_add(int bus, uint8_t address) {
+    struct mpu_model *m = &models[nmodels++] ;
+    m->bus = bus ;
+    m->address = address ;
+    m->reg[0x6B] = 0x40 ;       // PWR_MGMT_1 resets to sleep
+    m->reg[0x75] = 0x68 ;       // WHO_AM_I
+    return m ;
+}
+
+static void put_word(uint8_t *p, int16_t v) {
+    p[0] = (uint8_t) ((uint16_t) v >> 8) ;
+    p[1] = (uint8_t) v ;
+}
+
+void mpu_model_fifo_push(struct mpu_model *m, const uint8_t *bytes, int n) {
+    int drop = m->fifo_count + n - FIFO_SIZE ;
+
+    if (drop > 0) {
+        // full: the oldest bytes go, and the stream no longer lines up
+        memmove(m->fifo, m->fifo + drop, m->fifo_count - drop) ;
+        m->fifo_count -= drop ;
+        if (m->reg[REG_INT_ENABLE] & 0x10) m->reg[REG_INT_STATUS] |= 0x10 ;
+    }
+    memcpy(m->fifo + m->fifo_count, bytes, n) ;
+    m->fifo_count += n ;
+}
+
+void mpu_model_sample(struct mpu_model *m, const int16_t accel[3], int16_t temp, const int16_t gyro[3]) {
+    uint8_t record[12] ;
+
+    for (int i = 0; i < 3; i++) {
+        put_word(&m->reg[0x3B + 2*i], accel[i]) ;
+        put_word(&m->reg[0x43 + 2*i], gyro[i]) ;
+        put_word(&record[2*i], accel[i]) ;
+        put_word(&record[6 + 2*i], gyro[i]) ;
+    }
+    put_word(&m->reg[0x41], temp) ;
+    if (m->reg[REG_INT_ENABLE] & 0x01) m->reg[REG_INT_STATUS] |= 0x01 ;
+    // accel and all three gyro axes queued: the 12-byte record
+    if ((m->reg[REG_USER_CTRL] & 0x40) && m->reg[REG_FIFO_EN] == 0x78) mpu_model_fifo_push(m, record, 12) ;
+}
+
+// Device side of one byte
+static uint8_t model_read(struct mpu_model *m) {
+    uint8_t v = m->reg[m->ptr] ;
+
+    // FIFO_R_W pops the stream and doesn't move the pointer
+    if (m->ptr == REG_FIFO_R_W) {
+        if (!m->fifo_count) return 0 ;
+        v = m->fifo[0] ;
+        memmove(m->fifo, m->fifo + 1, --m->fifo_count) ;
+        return v ;
+    }
+    if (m->ptr == REG_FIFO_COUNT) v = (uint8_t) (m->fifo_count >> 8) ;
+    if (m->ptr == REG_FIFO_COUNT + 1) v = (uint8_t) m->fifo_count ;
+    // INT_STATUS clears when read, or on any read with INT_RD_CLEAR set
+    if (m->ptr == REG_INT_STATUS || (m->reg[REG_INT_PIN_CFG] & 0x10)) m->reg[REG_INT_STATUS] = 0 ;
+    m->ptr++ ;
+    return v ;
+}
+
+static void model_write(struct mpu_model *m, uint8_t v) {
+    // FIFO_RESET empties the FIFO and clears itself
+    if (m->ptr == REG_USER_CTRL && (v & 0x04)) {
+        m->fifo_count = 0 ;
+        v &= ~0x04 ;
+    }
+    m->reg[m->ptr++] = v ;
+}
+
+// Controller side: status registers follow the model state
+static void update(int b) {
+    i2c_hw_t *hw = &regs[b] ;
+    struct i2c_mock_bus *bus = &i2c_mock_bus[b] ;
+    uint32_t raw = hw->raw_intr_stat & ~I2C_IC_RAW_INTR_STAT_RX_FULL_BITS ;
+
+    if (bus->rx_count > (int) hw->rx_tl) raw |= I2C_IC_RAW_INTR_STAT_RX_FULL_BITS ;
+    hw->raw_intr_stat = raw ;
+    hw->intr_stat = raw & hw->intr_mask ;
+    hw->rxflr = bus->rx_count ;
+    hw->status = 0 ;
+}
+
+static struct mpu_model *find(int b, uint8_t address) {
+    for (int i = 0; i < nmodels; i++) {
+        if (models[i].bus == b && models[i].address == address) return &models[i] ;
+    }
+    return 0 ;
+}
+
+void i2c_mock_push(i2c_hw_t *hw, uint32_t cmd) {
+    int b = bus_of(hw) ;
+    struct i2c_mock_bus *bus = &i2c_mock_bus[b] ;
+    bool read = cmd & I2C_IC_DATA_CMD_CMD_BITS ;
+
+    if (!host_in_irq && !host_irqs_off) bus->unmasked++ ;
+    if (bus->aborted) return ;
+
+    // (Re)start and address phase: a new transaction, a RESTART, or a
+    // change of direction (the controller restarts on its own)
+    if (!bus->dev || (cmd & I2C_IC_DATA_CMD_RESTART_BITS) || read != bus->reading) {
+        struct mpu_model *m = find(b, (uint8_t) hw->tar) ;
+        if (!bus->dev) bus->transactions++ ;
+        bus->bits += 1 + 9 ;
+        if (!m || m->nak) {
+            bus->aborted = true ;
+            bus->dev = 0 ;
+            bus->bits += 1 ;
+            hw->raw_intr_stat |= I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS | I2C_IC_RAW_INTR_STAT_STOP_DET_BITS ;
+            update(b) ;
+            take_interrupts() ;
+            return ;
+        }
+        if (!bus->dev) m->transactions++ ;
+        bus->dev = m ;
+        bus->reading = read ;
+        bus->pointer_next = !read ;
+    }
+
+    bus->bits += 9 ;
+    if (read) {
+        uint8_t v = model_read(bus->dev) ;
+        if (bus->rx_count == 16) bus->rx_overflows++ ;
+        else bus->rx[bus->rx_count++] = v ;
+    } else if (bus->pointer_next) {
+        bus->dev->ptr = (uint8_t) cmd ;
+        bus->pointer_next = false ;
+    } else {
+        model_write(bus->dev, (uint8_t) cmd) ;
+    }
+
+    if (cmd & I2C_IC_DATA_CMD_STOP_BITS) {
+        bus->dev = 0 ;
+        bus->bits += 1 ;
+        hw->raw_intr_stat |= I2C_IC_RAW_INTR_STAT_STOP_DET_BITS ;
+    }
+    update(b) ;
+    take_interrupts() ;
+}
+
+uint8_t i2c_mock_pop(i2c_hw_t *hw) {
+    int b = bus_of(hw) ;
+    struct i2c_mock_bus *bus = &i2c_mock_bus[b] ;
+    uint8_t v ;
+
+    if (bus->rx_count == 0) {
+        bus->rx_underflows++ ;
+        return 0 ;
+    }
+    v = bus->rx[0] ;
+    memmove(bus->rx, bus->rx + 1, --bus->rx_count) ;
+    update(b) ;
+    return v ;
+}
+
+void i2c_mock_clear(i2c_hw_t *hw, size_t reg) {
+    int b = bus_of(hw) ;
+
+    if (reg == offsetof(i2c_hw_t, clr_tx_abrt)) {
+        hw->raw_intr_stat &= ~I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS ;
+        i2c_mock_bus[b].aborted = false ;
+    }
+    if (reg == offsetof(i2c_hw_t, clr_stop_det)) {
+        hw->raw_intr_stat &= ~I2C_IC_RAW_INTR_STAT_STOP_DET_BITS ;
+    }
+    update(b) ;
+}
+
+int i2c_mock_service(int bus, int limit) {
+    int runs = 0 ;
+    update(bus) ;
+    while (regs[bus].intr_stat && runs < limit) {
+        host_irq(I2C0_IRQ + bus) ;
+        update(bus) ;
+        runs++ ;
+    }
+    return runs ;
+}
+
+void i2c_mock_run(void) {
+    while (i2c_mock_service(0, 100) + i2c_mock_service(1, 100)) ;
+}
+
+bool i2c_mock_eager ;
+
+// Eager mode: an interrupt the thread's last register access raised runs
+// now, in the middle of whatever the thread was doing
+static void take_interrupts(void) {
+    if (i2c_mock_eager && !host_irqs_off && !host_in_irq) i2c_mock_run() ;
+}
+
+double i2c_mock_usec(int bus, unsigned int baud) {
+    return i2c_mock_bus[bus].bits * 1e6 / baud ;
+}
+
+// The SDK's blocking calls, one byte at a time
+int i2c_write_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop) {
+    i2c_hw_t *hw = i2c_get_hw(i2c) ;
+    hw->tar = addr ;
+    for (size_t i = 0; i < len; i++) {
+        i2c_mock_push(hw, src[i] | (i == len-1 && !nostop ? I2C_IC_DATA_CMD_STOP_BITS : 0)) ;
+    }
+    if (hw->raw_intr_stat & I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS) {
+        i2c_mock_clear(hw, offsetof(i2c_hw_t, clr_tx_abrt)) ;
+        return -2 ;
+    }
+    return (int) len ;
+}
+
+int i2c_read_blocking(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len, bool nostop) {
+    i2c_hw_t *hw = i2c_get_hw(i2c) ;
+    hw->tar = addr ;
+    for (size_t i = 0; i < len; i++) {
+        i2c_mock_push(hw, I2C_IC_DATA_CMD_CMD_BITS
+                        | (i == 0 ? I2C_IC_DATA_CMD_RESTART_BITS : 0)
+                        | (i == len-1 && !nostop ? I2C_IC_DATA_CMD_STOP_BITS : 0)) ;
+        if (hw->raw_intr_stat & I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS) {
+            i2c_mock_clear(hw, offsetof(i2c_hw_t, clr_tx_abrt)) ;
+            return -2 ;
+        }
+        dst[i] = i2c_mock_pop(hw) ;
+    }
+    return (int) len ;
+}
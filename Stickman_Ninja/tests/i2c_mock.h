@@ -0,0 +1,69 @@
+/**
+ * A model of the RP2040 I2C controllers with MPU6050s on their buses
+ *
+ * Commands pushed into data_cmd run at once: the addressed device answers,
+ * read bytes land in a 16-deep RX FIFO and a STOP sets STOP_DET. A missing
+ * or NAKing device aborts the transaction the way the controller does:
+ * TX_ABRT and STOP_DET are raised and further commands are flushed until
+ * clr_tx_abrt is read. Interrupt status follows rx_tl and intr_mask.
+ * Every bit on the wire is counted, for bus timing.
+ *
+ * The devices model the FIFO as a byte stream: with FIFO_EN and USER_CTRL
+ * set, each sample appends a 12-byte record, FIFO_COUNT reports the bytes
+ * queued and FIFO_R_W pops one per read. A full FIFO drops its oldest
+ * bytes and raises FIFO_OFLOW, as the part does.
+ */
+#pragma once
+#include "hardware/i2c.h"
+
+#define MOCK_BUSES 2
+#define MOCK_DEVS  4
+
+struct mpu_model {
+    int bus ;
+    uint8_t address ;
+    bool nak ;                  // refuse to ACK the address
+    uint8_t reg[128] ;
+    uint8_t ptr ;               // register pointer
+    unsigned int transactions ; // transactions addressed to it
+    uint8_t fifo[1024] ;
+    int fifo_count ;
+} ;
+
+struct i2c_mock_bus {
+    struct mpu_model *dev ;     // device addressed, 0 between transactions
+    bool reading ;
+    bool pointer_next ;         // next written byte sets the register pointer
+    bool aborted ;              // flushing until clr_tx_abrt is read
+    uint8_t rx[16] ;
+    int rx_count ;
+    unsigned long bits ;        // bit times on the wire
+    unsigned int transactions ;
+    unsigned int rx_overflows ; // bytes lost to a full RX FIFO: driver bug
+    unsigned int rx_underflows ;// pops from an empty RX FIFO: driver bug
+    unsigned int unmasked ;     // commands from thread context with interrupts on
+} ;
+
+extern struct i2c_mock_bus i2c_mock_bus[MOCK_BUSES] ;
+
+// Forget every device and reset both controllers
+void i2c_mock_reset(void) ;
+struct mpu_model *mpu_model_add(int bus, uint8_t address) ;
+
+// Latch a new raw sample into the data registers (and raise data ready)
+void mpu_model_sample(struct mpu_model *m, const int16_t accel[3], int16_t temp, const int16_t gyro[3]) ;
+// Append raw bytes to the FIFO, e.g. half a record
+void mpu_model_fifo_push(struct mpu_model *m, const uint8_t *bytes, int n) ;
+
+// Run the controller's interrupt handler while its interrupt is asserted.
+// Returns how many times it ran; stops at limit (a stuck interrupt)
+int i2c_mock_service(int bus, int limit) ;
+// Service both buses until neither has an interrupt pending
+void i2c_mock_run(void) ;
+
+// Interrupts taken as soon as they assert, as on the chip: from inside
+// the driver's own register writes, unless it has masked them
+extern bool i2c_mock_eager ;
+
+// Microseconds the bits counted so far take at baud
+double i2c_mock_usec(int bus, unsigned int baud) ;
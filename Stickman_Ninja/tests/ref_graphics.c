@@ -0,0 +1,149 @@
+#include <stdlib.h>
+#include <string.h>
+#include "ref_graphics.h"
+#include "glcdfont.c"
+
+unsigned char ref_frame[REF_WIDTH*REF_HEIGHT/2] ;
+bool ref_drop_offscreen ;
+
+// Bit masks for drawPixel routine
+#define TOPMASK 0b11000111
+#define BOTTOMMASK 0b11111000
+
+#define swap(a, b) { short t = a; a = b; b = t; }
+
+void ref_clear(void) {
+    memset(ref_frame, 0, sizeof(ref_frame)) ;
+}
+
+void ref_drawPixel(short x, short y, char color) {
+    if (ref_drop_offscreen && ((x < 0) || (x > 639) || (y < 0) || (y > 479))) return ;
+    // Range checks (640x480 display)
+    if (x > 639) x = 639 ;
+    if (x < 0) x = 0 ;
+    if (y < 0) y = 0 ;
+    if (y > 479) y = 479 ;
+
+    // Which pixel is it?
+    int pixel = ((640 * y) + x) ;
+
+    // Is this pixel stored in the first 3 bits
+    // of the vga data array index, or the second
+    // 3 bits? Check, then mask.
+    if (pixel & 1) {
+        ref_frame[pixel>>1] = (ref_frame[pixel>>1] & TOPMASK) | (color << 3) ;
+    }
+    else {
+        ref_frame[pixel>>1] = (ref_frame[pixel>>1] & BOTTOMMASK) | (color) ;
+    }
+}
+
+// Bresenham's algorithm - thx wikipedia and thx Bruce!
+void ref_drawLine(short x0, short y0, short x1, short y1, char color) {
+      short steep = abs(y1 - y0) > abs(x1 - x0);
+      if (steep) {
+        swap(x0, y0);
+        swap(x1, y1);
+      }
+
+      if (x0 > x1) {
+        swap(x0, x1);
+        swap(y0, y1);
+      }
+
+      short dx, dy;
+      dx = x1 - x0;
+      dy = abs(y1 - y0);
+
+      short err = dx / 2;
+      short ystep;
+
+      if (y0 < y1) {
+        ystep = 1;
+      } else {
+        ystep = -1;
+      }
+
+      for (; x0<=x1; x0++) {
+        if (steep) {
+          ref_drawPixel(y0, x0, color);
+        } else {
+          ref_drawPixel(x0, y0, color);
+        }
+        err -= dy;
+        if (err < 0) {
+          y0 += ystep;
+          err += dx;
+        }
+      }
+}
+
+void ref_fillRect(short x, short y, short w, short h, char color) {
+  for(int i=x; i<(x+w); i++) {
+    for(int j=y; j<(y+h); j++) {
+        ref_drawPixel(i, j, color);
+    }
+  }
+}
+
+// One pixel (or size x size block) at a time, as before the glyph cache
+void ref_drawChar(short x, short y, unsigned char c, char color, char bg, unsigned char size) {
+  char i, j;
+  if((x >= 640)               || // Clip right
+     (y >= 480)               || // Clip bottom
+     ((x + 6 * size - 1) < 0) || // Clip left
+     ((y + 8 * size - 1) < 0))   // Clip top
+    return;
+
+  for (i=0; i<6; i++ ) {
+    unsigned char line;
+    if (i == 5)
+      line = 0x0;
+    else
+      line = font[(c*5)+i];
+    for ( j = 0; j<8; j++) {
+      if (line & 0x1) {
+        if (size == 1) // default size
+          ref_drawPixel(x+i, y+j, color);
+        else {  // big size
+          ref_fillRect(x+(i*size), y+(j*size), size, size, color);
+        }
+      } else if (bg != color) {
+        if (size == 1) // default size
+          ref_drawPixel(x+i, y+j, bg);
+        else {  // big size
+          ref_fillRect(x+i*size, y+j*size, size, size, bg);
+        }
+      }
+      line >>= 1;
+    }
+  }
+}
+
+int ref_pixel(short x, short y) {
+    int pixel = 640*y + x ;
+    return (ref_frame[pixel>>1] >> ((pixel & 1) ? 3 : 0)) & 0x7 ;
+}
+
+#ifdef VGA_PACKED
+extern unsigned int vga_data_array[] ;
+
+int vga_pixel(short x, short y) {
+    return (vga_data_array[64*y + x/10] >> (3*(x%10))) & 0x7 ;
+}
+#else
+extern unsigned char vga_data_array[] ;
+
+int vga_pixel(short x, short y) {
+    int pixel = 640*y + x ;
+    return (vga_data_array[pixel>>1] >> ((pixel & 1) ? 3 : 0)) & 0x7 ;
+}
+#endif
+
+int frame_diff(void) {
+    int n = 0 ;
+    for (short y = 0; y < REF_HEIGHT; y++) {
+        for (short x = 0; x < REF_WIDTH; x++) n += vga_pixel(x, y) != ref_pixel(x, y) ;
+    }
+    return n ;
+}
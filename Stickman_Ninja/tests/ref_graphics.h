@@ -0,0 +1,28 @@
+/**
+ * The drawing primitives as they were before the span and line
+ * rewrites and the glyph cache -- per-pixel, clamping, two pixels per
+ * byte -- drawing into a frame of their own, to compare images and speed
+ * against
+ */
+#pragma once
+#include <stdbool.h>
+
+#define REF_WIDTH  640
+#define REF_HEIGHT 480
+
+extern unsigned char ref_frame[REF_WIDTH*REF_HEIGHT/2] ;
+// Set to drop off-screen pixels, as drawPixel does now, instead of
+// clamping them onto the border
+extern bool ref_drop_offscreen ;
+
+void ref_clear(void) ;
+void ref_drawPixel(short x, short y, char color) ;
+void ref_drawLine(short x0, short y0, short x1, short y1, char color) ;
+void ref_fillRect(short x, short y, short w, short h, char color) ;
+void ref_drawChar(short x, short y, unsigned char c, char color, char bg, unsigned char size) ;
+int ref_pixel(short x, short y) ;
+
+// Read back one pixel of vga_graphics' framebuffer, in either layout
+int vga_pixel(short x, short y) ;
+// Pixels where the two frames differ
+int frame_diff(void) ;
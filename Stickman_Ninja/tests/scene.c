@@ -0,0 +1,67 @@
+#include "vga_graphics.h"
+#include "hud.h"
+#include "scene.h"
+
+static struct hud_health hud0, hud1 ;
+static sprite stickman ;
+
+// A stickman in the block pose, as draw_stickman has it
+static void draw_figure(short x, short y, char color) {
+    drawCircle(x, y-30, 15, color) ;
+    drawVLine_fast(x, y-15, 45, color) ;
+    drawLine(x, y+30, x-15, y+53, color) ;
+    drawVLine_fast(x-15, y+53, 22, color) ;
+    drawLine(x, y+30, x+6, y+53, color) ;
+    drawLine(x+6, y+53, x+15, y+75, color) ;
+    drawLine(x, y, x+15, y+30, color) ;
+    drawLine(x, y, x-11, y+23, color) ;
+    drawLine(x-11, y+23, x-24, y+15, color) ;
+    drawVLine_fast(x-24, y-37, 60, color) ;
+    drawHLine_fast(x-29, y+12, 10, color) ;
+}
+
+// About what the game puts up at the end of a round, plus a few of each
+// of the other primitives. A display list holds 2048 spans, and vertical
+// lines take one per row, so the filled round shapes stay small
+void scene_draw(void) {
+    // a pose captured from the corner as the game does at boot, then
+    // blitted where the players are
+    fillRect(0, 0, 640, 480, BLACK) ;
+    draw_figure(90, 60, WHITE) ;
+    captureSprite(&stickman, 0, 0, 170, 140) ;
+    fillRect(0, 0, 640, 480, BLACK) ;
+    blitSprite(&stickman, 56, 285, RED) ;
+    blitSprite(&stickman, 401, 285, BLUE) ;
+    // and one drawn straight, partly off the right edge
+    draw_figure(628, 300, GREEN) ;
+
+    // ground and HUD
+    drawHLine_fast(0, 420, 640, WHITE) ;
+    hud_health_init(&hud0, 40, 42, 247, 43, RED, 100) ;
+    hud_health_init(&hud1, 350, 42, 557, 43, BLUE, 100) ;
+    hud_health_update(&hud0, 73) ;
+    hud_health_update(&hud1, 8) ;
+
+    // text: transparent and opaque, every size the game uses
+    setTextColor(WHITE) ;
+    setTextSize(1) ;
+    setCursor(175, 90) ;
+    writeString("Press any button to begin") ;
+    setTextColor2(YELLOW, MAGENTA) ;
+    setTextSize(2) ;
+    setCursor(151, 150) ;
+    writeString("PLAYER 1 WINS") ;
+    setTextColor2(CYAN, BLACK) ;
+    setTextSize(3) ;
+    setCursor(203, 200) ;
+    writeString("ROUND 2") ;
+
+    // the rest of the primitives, some clipped
+    drawRect(300, 250, 41, 31, WHITE) ;
+    fillCircle(320, 265, 6, YELLOW) ;
+    drawRoundRect(5, 430, 100, 40, 8, GREEN) ;
+    fillRoundRect(575, 440, 60, 16, 4, MAGENTA) ;
+    drawLine(-40, 470, 700, 440, CYAN) ;
+    fillRect(630, -5, 20, 20, RED) ;
+    drawPixel(639, 479, WHITE) ;
+}
@@ -0,0 +1,7 @@
+/**
+ * A game screen drawn with every kind of primitive, shared by the
+ * framebuffer and scanline builds so their images can be compared
+ */
+#pragma once
+
+void scene_draw(void) ;
@@ -0,0 +1,18 @@
+/**
+ * The shared scene drawn by the framebuffer backend, written to stdout
+ * one byte per pixel, row by row, for test_scanline to compare against
+ */
+
+#include <stdio.h>
+#include "vga_graphics.h"
+#include "ref_graphics.h"
+#include "scene.h"
+
+int main(void) {
+    initVGA() ;
+    scene_draw() ;
+    for (short y = 0; y < 480; y++) {
+        for (short x = 0; x < 640; x++) putchar(vga_pixel(x, y)) ;
+    }
+    return 0 ;
+}
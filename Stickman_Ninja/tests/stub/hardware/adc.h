@@ -0,0 +1,5 @@
+/**
+ * Host stand-in for hardware/adc.h, which stickman_main.c includes but
+ * doesn't use
+ */
+#pragma once
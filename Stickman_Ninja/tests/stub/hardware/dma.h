@@ -0,0 +1,34 @@
+/**
+ * Host stand-in for hardware/dma.h: channels can be configured and
+ * started, but nothing moves. The transfer size of each is kept
+ */
+#pragma once
+#include "pico/stdlib.h"
+
+typedef struct { io_rw_32 read_addr, write_addr, transfer_count, ctrl_trig ; io_rw_32 alias[12] ; } dma_channel_hw_t ;
+typedef struct { dma_channel_hw_t ch[12] ; io_rw_32 ints0, inte0 ; } dma_hw_t ;
+extern dma_hw_t *dma_hw ;
+
+enum dma_channel_transfer_size { DMA_SIZE_8, DMA_SIZE_16, DMA_SIZE_32 } ;
+typedef struct { uint32_t ctrl ; enum dma_channel_transfer_size size ; } dma_channel_config ;
+extern enum dma_channel_transfer_size host_dma_size[12] ;
+
+static inline dma_channel_config dma_channel_get_default_config(uint channel) {
+    dma_channel_config c = {channel, DMA_SIZE_32} ;
+    return c ;
+}
+static inline void channel_config_set_transfer_data_size(dma_channel_config *c, enum dma_channel_transfer_size size) { c->size = size ; }
+static inline void channel_config_set_read_increment(dma_channel_config *c, bool incr) { (void) c ; (void) incr ; }
+static inline void channel_config_set_write_increment(dma_channel_config *c, bool incr) { (void) c ; (void) incr ; }
+static inline void channel_config_set_dreq(dma_channel_config *c, uint dreq) { (void) c ; (void) dreq ; }
+static inline void channel_config_set_chain_to(dma_channel_config *c, uint channel) { (void) c ; (void) channel ; }
+static inline void dma_channel_configure(uint channel, const dma_channel_config *c, volatile void *write,
+                                         const volatile void *read, uint count, bool trigger) {
+    (void) trigger ;
+    host_dma_size[channel] = c->size ;
+    dma_hw->ch[channel].write_addr = (uint32_t) (uintptr_t) write ;
+    dma_hw->ch[channel].read_addr = (uint32_t) (uintptr_t) read ;
+    dma_hw->ch[channel].transfer_count = count ;
+}
+static inline void dma_start_channel_mask(uint32_t mask) { (void) mask ; }
+static inline void dma_channel_set_irq0_enabled(uint channel, bool enabled) { (void) channel ; (void) enabled ; }
@@ -0,0 +1,45 @@
+/**
+ * Host I2C: the controller registers the mpu6050 driver touches, backed by
+ * the bus model in i2c_mock.c. Pushes into data_cmd, pops out of it and
+ * clear-on-read registers go through i2c_push/i2c_pop/i2c_clear so the
+ * model sees every access
+ */
+#pragma once
+#include <stddef.h>
+#include "pico/stdlib.h"
+
+typedef struct i2c_inst { int index ; } i2c_inst_t ;
+extern i2c_inst_t *i2c0, *i2c1 ;
+
+typedef struct {
+    io_rw_32 enable, tar, data_cmd, rx_tl, intr_mask ;
+    io_rw_32 intr_stat, raw_intr_stat, rxflr, status ;
+    io_rw_32 clr_tx_abrt, clr_stop_det ;
+} i2c_hw_t ;
+
+i2c_hw_t *i2c_get_hw(i2c_inst_t *i2c) ;
+static inline uint i2c_hw_index(i2c_inst_t *i2c) { return i2c->index ; }
+static inline uint i2c_init(i2c_inst_t *i2c, uint baudrate) { (void) i2c ; return baudrate ; }
+int i2c_write_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop) ;
+int i2c_read_blocking(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len, bool nostop) ;
+
+void i2c_mock_push(i2c_hw_t *hw, uint32_t cmd) ;
+uint8_t i2c_mock_pop(i2c_hw_t *hw) ;
+void i2c_mock_clear(i2c_hw_t *hw, size_t reg) ;
+#define i2c_push(hw, cmd)   i2c_mock_push((hw), (cmd))
+#define i2c_pop(hw)         i2c_mock_pop(hw)
+#define i2c_clear(hw, reg)  i2c_mock_clear((hw), offsetof(i2c_hw_t, reg))
+
+#define I2C_IC_DATA_CMD_CMD_BITS            0x100u
+#define I2C_IC_DATA_CMD_STOP_BITS           0x200u
+#define I2C_IC_DATA_CMD_RESTART_BITS        0x400u
+#define I2C_IC_INTR_MASK_M_RX_FULL_BITS     0x004u
+#define I2C_IC_INTR_MASK_M_TX_ABRT_BITS     0x040u
+#define I2C_IC_INTR_MASK_M_STOP_DET_BITS    0x200u
+#define I2C_IC_INTR_STAT_R_RX_FULL_BITS     0x004u
+#define I2C_IC_INTR_STAT_R_TX_ABRT_BITS     0x040u
+#define I2C_IC_INTR_STAT_R_STOP_DET_BITS    0x200u
+#define I2C_IC_RAW_INTR_STAT_RX_FULL_BITS   0x004u
+#define I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS   0x040u
+#define I2C_IC_RAW_INTR_STAT_STOP_DET_BITS  0x200u
+#define I2C_IC_STATUS_ACTIVITY_BITS         0x001u
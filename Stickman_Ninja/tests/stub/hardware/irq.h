@@ -0,0 +1,15 @@
+#pragma once
+#include "pico/stdlib.h"
+typedef void (*irq_handler_t)(void) ;
+#define TIMER_IRQ_0  0
+#define PWM_IRQ_WRAP 4
+#define PIO0_IRQ_0   7
+#define DMA_IRQ_0    11
+#define DMA_IRQ_1    12
+#define IO_IRQ_BANK0 13
+#define I2C0_IRQ     23
+#define I2C1_IRQ     24
+// handlers are recorded in host_irq_handler[] (host.h)
+void irq_set_exclusive_handler(uint num, irq_handler_t handler) ;
+static inline void irq_set_enabled(uint num, bool enabled) { (void) num ; (void) enabled ; }
+static inline void irq_set_priority(uint num, uint8_t priority) { (void) num ; (void) priority ; }
@@ -0,0 +1,17 @@
+/**
+ * Host stand-in for hardware/pwm.h: enough for stickman_main.c to build.
+ * No slice ever wraps; nothing here is run by the tests
+ */
+#pragma once
+#include "pico/stdlib.h"
+
+#define PWM_CHAN_A 0
+#define PWM_CHAN_B 1
+
+static inline uint pwm_gpio_to_slice_num(uint gpio) { return (gpio >> 1) & 7 ; }
+static inline void pwm_clear_irq(uint slice) { (void) slice ; }
+static inline void pwm_set_irq_enabled(uint slice, bool enabled) { (void) slice ; (void) enabled ; }
+static inline void pwm_set_wrap(uint slice, uint16_t wrap) { (void) slice ; (void) wrap ; }
+static inline void pwm_set_clkdiv(uint slice, float div) { (void) slice ; (void) div ; }
+static inline void pwm_set_chan_level(uint slice, uint chan, uint16_t level) { (void) slice ; (void) chan ; (void) level ; }
+static inline void pwm_set_mask_enabled(uint32_t mask) { (void) mask ; }
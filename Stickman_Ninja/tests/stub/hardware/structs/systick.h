@@ -0,0 +1,4 @@
+#pragma once
+#include "pico/stdlib.h"
+typedef struct { io_rw_32 csr, rvr, cvr, calib ; } systick_hw_t ;
+extern systick_hw_t *systick_hw ;
@@ -0,0 +1,46 @@
+/**
+ * Host spinlocks: the same API, backed by C11 atomics so the lock-free and
+ * cross-core code can be exercised from real threads. Masking interrupts
+ * sets a per-thread flag; restoring it runs whatever interrupt a test
+ * model held back meanwhile (see host.h)
+ */
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+typedef atomic_uint spin_lock_t ;
+
+spin_lock_t *spin_lock_instance(unsigned int lock_num) ;
+spin_lock_t *spin_lock_init(unsigned int lock_num) ;
+void spin_lock_claim(unsigned int lock_num) ;
+int spin_lock_claim_unused(bool required) ;
+bool spin_lock_is_claimed(unsigned int lock_num) ;
+
+static inline void spin_lock_unsafe_blocking(spin_lock_t *lock) {
+    while (atomic_exchange_explicit(lock, 1, memory_order_acquire)) ;
+}
+static inline void spin_unlock_unsafe(spin_lock_t *lock) {
+    atomic_store_explicit(lock, 0, memory_order_release) ;
+}
+static inline uint32_t spin_lock_blocking(spin_lock_t *lock) {
+    spin_lock_unsafe_blocking(lock) ;
+    return 0 ;
+}
+static inline void spin_unlock(spin_lock_t *lock, uint32_t saved) {
+    (void) saved ;
+    spin_unlock_unsafe(lock) ;
+}
+static inline bool is_spin_locked(spin_lock_t *lock) { return atomic_load(lock) != 0 ; }
+extern _Thread_local bool host_irqs_off ;
+void host_irqs_enabled(void) ;
+
+static inline uint32_t save_and_disable_interrupts(void) {
+    uint32_t saved = host_irqs_off ;
+    host_irqs_off = true ;
+    return saved ;
+}
+static inline void restore_interrupts(uint32_t saved) {
+    host_irqs_off = saved ;
+    if (!saved) host_irqs_enabled() ;
+}
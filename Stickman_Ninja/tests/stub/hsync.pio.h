@@ -0,0 +1,7 @@
+// Host stand-in for the assembled hsync.pio
+#pragma once
+#include "hardware/pio.h"
+static const pio_program_t hsync_program = {0} ;
+static inline void hsync_program_init(PIO pio, uint sm, uint offset, uint pin) {
+    (void) pio ; (void) sm ; (void) offset ; (void) pin ;
+}
@@ -0,0 +1,9 @@
+#pragma once
+#include "pico/stdlib.h"
+static inline void multicore_reset_core1(void) {}
+static inline void multicore_launch_core1(void (*entry)(void)) { (void) entry ; }
+static inline bool multicore_fifo_wready(void) { return true ; }
+static inline bool multicore_fifo_rvalid(void) { return false ; }
+static inline void multicore_fifo_push_blocking(uint32_t data) { (void) data ; }
+static inline uint32_t multicore_fifo_pop_blocking(void) { return 0 ; }
+static inline void multicore_fifo_drain(void) {}
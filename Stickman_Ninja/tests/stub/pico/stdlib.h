@@ -0,0 +1,59 @@
+/**
+ * Host stand-in for the parts of pico/stdlib.h the game uses. Time is
+ * whatever the test puts in host_timer.timerawl, and each spin of a busy
+ * wait moves it on a microsecond so waits on the clock end. GPIO
+ * interrupts and NVIC handlers are recorded so a test can fire them (see
+ * host.h)
+ */
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdatomic.h>
+
+typedef unsigned int uint ;
+typedef volatile uint32_t io_rw_32 ;
+typedef volatile uint32_t io_ro_32 ;
+
+typedef struct { io_rw_32 timerawl, timerawh ; } timer_hw_t ;
+extern timer_hw_t *timer_hw ;
+
+typedef uint64_t absolute_time_t ;
+static inline uint32_t time_us_32(void) { return timer_hw->timerawl ; }
+static inline uint64_t time_us_64(void) { return timer_hw->timerawl ; }
+static inline absolute_time_t get_absolute_time(void) { return timer_hw->timerawl ; }
+static inline absolute_time_t delayed_by_us(absolute_time_t t, uint64_t us) { return t + us ; }
+static inline void sleep_us(uint64_t us) { timer_hw->timerawl += (uint32_t) us ; }
+static inline void sleep_ms(uint32_t ms) { timer_hw->timerawl += ms * 1000 ; }
+static inline void tight_loop_contents(void) { timer_hw->timerawl++ ; }
+static inline void stdio_init_all(void) {}
+
+// Cores, events and barriers: see host.c
+uint get_core_num(void) ;
+void __sev(void) ;
+void __wfe(void) ;
+bool best_effort_wfe_or_timeout(absolute_time_t t) ;
+static inline void __wfi(void) { __wfe() ; }
+static inline void __dmb(void) { atomic_thread_fence(memory_order_seq_cst) ; }
+
+#define GPIO_IN  0
+#define GPIO_OUT 1
+#define GPIO_FUNC_I2C 3
+#define GPIO_IRQ_EDGE_FALL 4
+#define GPIO_IRQ_EDGE_RISE 8
+typedef void (*gpio_irq_callback_t)(uint gpio, uint32_t events) ;
+static inline void gpio_init(uint gpio) { (void) gpio ; }
+static inline void gpio_set_dir(uint gpio, bool out) { (void) gpio ; (void) out ; }
+static inline void gpio_pull_up(uint gpio) { (void) gpio ; }
+static inline void gpio_set_function(uint gpio, int fn) { (void) gpio ; (void) fn ; }
+bool gpio_get(uint gpio) ;
+void gpio_set_irq_enabled_with_callback(uint gpio, uint32_t events, bool enabled, gpio_irq_callback_t callback) ;
+
+#define __not_in_flash_func(f) f
+#define __time_critical_func(f) f
+#define __scratch_x(n)
+#define __scratch_y(n)
+
+#include "hardware/sync.h"
+#include "hardware/uart.h"
@@ -0,0 +1,102 @@
+/**
+ * atan2fix15 against libm: quadrant rules, worst error over a grid of
+ * small inputs and over random fix15 pairs of every magnitude, and the
+ * time per call against the float path it replaced
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include "host.h"
+#include "mpu6050.h"
+
+#define MAX_ERROR_DEG 0.005
+#define BENCH_CALLS   2000000
+
+static double worst ;
+static fix15 worst_y, worst_x ;
+
+static void check_one(fix15 y, fix15 x) {
+    double want, got, error ;
+
+    if (!x && !y) return ;
+    want = atan2((double) y, (double) x) * 180.0 / M_PI ;
+    got = fix2float15(atan2fix15(y, x)) ;
+    error = fabs(want - got) ;
+    // +180 and -180 are the same angle
+    if (error > 180.0) error = fabs(error - 360.0) ;
+    if (error > worst) {
+        worst = error ;
+        worst_y = y ;
+        worst_x = x ;
+    }
+}
+
+static void test_quadrants(void) {
+    CHECK(atan2fix15(0, 0) == 0) ;
+    CHECK(atan2fix15(0, int2fix15(1)) == 0) ;
+    CHECK(atan2fix15(int2fix15(1), 0) == int2fix15(90)) ;
+    CHECK(atan2fix15(0, -int2fix15(1)) == int2fix15(180)) ;
+    CHECK(atan2fix15(-int2fix15(1), 0) == -int2fix15(90)) ;
+    CHECK(atan2fix15(int2fix15(1), int2fix15(1)) == int2fix15(45)) ;
+    CHECK(atan2fix15(-int2fix15(3), -int2fix15(3)) == -int2fix15(135)) ;
+}
+
+static void test_grid(void) {
+    worst = 0 ;
+    for (fix15 y = -2048; y <= 2048; y++) {
+        for (fix15 x = -2048; x <= 2048; x++) check_one(y, x) ;
+    }
+    printf("grid |x|,|y| <= 2048: worst %.5f deg at (%d, %d)\n", worst, worst_x, worst_y) ;
+    CHECK(worst < MAX_ERROR_DEG) ;
+}
+
+static void test_random(void) {
+    worst = 0 ;
+    srand(18) ;
+    for (int n = 0; n < 4000000; n++) {
+        // every magnitude, not just full-scale values
+        fix15 y = (fix15) (((unsigned) rand() << 1) ^ (unsigned) rand()) >> (rand() % 31) ;
+        fix15 x = (fix15) (((unsigned) rand() << 1) ^ (unsigned) rand()) >> (rand() % 31) ;
+        check_one(y, x) ;
+    }
+    check_one(INT32_MIN, 5) ;
+    check_one(5, INT32_MIN) ;
+    check_one(INT32_MIN, INT32_MIN) ;
+    check_one(INT32_MAX, INT32_MAX) ;
+    printf("random fix15: worst %.5f deg at (%d, %d)\n", worst, worst_x, worst_y) ;
+    CHECK(worst < MAX_ERROR_DEG) ;
+}
+
+// What sensor_update did before: atan2 in double, then to degrees in fix15
+static fix15 float_angle(fix15 y, fix15 x) {
+    return multfix15(float2fix15(atan2(-y, -x)), oneeightyoverpi) ;
+}
+
+// Host time per call. The host has an FPU and the RP2040 doesn't, so the
+// float path costs far more there; this just tracks the fixed-point one
+static void bench(void) {
+    static fix15 ys[1024], xs[1024] ;
+    double start, fixed, floating ;
+    unsigned int sum = 0 ;
+
+    for (int i = 0; i < 1024; i++) {
+        ys[i] = (rand() % int2fix15(4)) - int2fix15(2) ;
+        xs[i] = (rand() % int2fix15(4)) - int2fix15(2) ;
+    }
+    start = host_nsec() ;
+    for (int n = 0; n < BENCH_CALLS; n++) sum += atan2fix15(ys[n & 1023], xs[n & 1023]) ;
+    fixed = (host_nsec() - start) / BENCH_CALLS ;
+    start = host_nsec() ;
+    for (int n = 0; n < BENCH_CALLS; n++) sum += float_angle(ys[n & 1023], xs[n & 1023]) ;
+    floating = (host_nsec() - start) / BENCH_CALLS ;
+    host_sink = (int) sum ;
+    printf("atan2fix15 %.1f ns/call, double atan2 + conversions %.1f ns/call (host)\n", fixed, floating) ;
+}
+
+int main(void) {
+    test_quadrants() ;
+    test_grid() ;
+    test_random() ;
+    bench() ;
+    return CHECK_DONE() ;
+}
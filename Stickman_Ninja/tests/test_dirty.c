@@ -0,0 +1,173 @@
+/**
+ * Dirty-rectangle erase/redraw against redrawing the whole screen: two
+ * players wander, turn and change pose over the ground line for a
+ * thousand frames, updated the way fight_update does it (mark what moved,
+ * clearDirty, repair the ground, redraw whatever the clear touched). After
+ * every frame the screen must match one drawn from scratch, and the
+ * clears must cost a small part of a full one
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "host.h"
+#include "vga_graphics.h"
+
+#ifdef VGA_PACKED
+#define FRAME_BYTES (640/10*4*480)
+#else
+#define FRAME_BYTES (640/2*480)
+#endif
+#define FRAMES 1000
+
+// The capture box, and where the figure's origin sits in it, as in
+// stickman_main
+#define BOX_W  170
+#define BOX_H  140
+#define BOX_DX 85
+#define BOX_DY 45
+#define GROUND 420
+
+extern char vga_data_array[] ;
+
+struct player {
+    short x, y ;
+    int pose ;
+} ;
+
+// What is on screen for a player, as drawn_struct keeps it
+struct drawn {
+    bool valid ;
+    short x, y ;
+    int pose ;
+} ;
+
+static sprite poses[2] ;
+static struct player players[2] ;
+static struct drawn drawn[2] ;
+static const char colors[2] = {RED, BLUE} ;
+static char incremental[FRAME_BYTES] ;
+
+// Two poses: sword held up, and thrust forward
+static void draw_figure(short x, short y, int pose, char color) {
+    drawCircle(x, y-30, 15, color) ;
+    drawVLine_fast(x, y-15, 45, color) ;
+    drawLine(x, y+30, x-15, y+75, color) ;
+    drawLine(x, y+30, x+15, y+75, color) ;
+    if (pose == 0) {
+        drawLine(x, y, x-11, y+23, color) ;
+        drawVLine_fast(x-11, y-37, 60, color) ;
+    } else {
+        drawLine(x, y, x+20, y+5, color) ;
+        drawHLine_fast(x+20, y+5, 50, color) ;
+    }
+}
+
+static void capture_poses(void) {
+    for (int pose = 0; pose < 2; pose++) {
+        fillRect(0, 0, BOX_W, BOX_H, BLACK) ;
+        draw_figure(BOX_DX, BOX_DY, pose, WHITE) ;
+        CHECK(captureSprite(&poses[pose], 0, 0, BOX_W, BOX_H)) ;
+    }
+    fillRect(0, 0, BOX_W, BOX_H, BLACK) ;
+}
+
+// erase_player: queue the old image if the player moved or changed pose
+static void erase(int i) {
+    const sprite *s = &poses[drawn[i].pose] ;
+
+    if (!drawn[i].valid) return ;
+    if ((drawn[i].x == players[i].x) && (drawn[i].y == players[i].y) && (drawn[i].pose == players[i].pose)) return ;
+    markDirty(drawn[i].x - BOX_DX + s->bx, drawn[i].y - BOX_DY + s->by, s->bw, s->bh) ;
+    drawn[i].valid = false ;
+}
+
+// draw_player: blit if the image is gone, or the clear cut into it
+static void draw(int i) {
+    const sprite *s = &poses[players[i].pose] ;
+    short x = players[i].x - BOX_DX, y = players[i].y - BOX_DY ;
+
+    if (drawn[i].valid && !isDirty(x + s->bx, y + s->by, s->bw, s->bh)) return ;
+    blitSprite(s, x, y, colors[i]) ;
+    drawn[i].valid = true ;
+    drawn[i].x = players[i].x ;
+    drawn[i].y = players[i].y ;
+    drawn[i].pose = players[i].pose ;
+}
+
+// repair_ground: put the ground back wherever a clear cut through it
+static void repair_ground(void) {
+    const struct vga_rect *rects ;
+    int n = getDirtyRects(&rects) ;
+
+    for (int i = 0; i < n; i++) {
+        if ((rects[i].y <= GROUND) && (rects[i].y + rects[i].h > GROUND)) {
+            drawHLine_fast(rects[i].x, GROUND, rects[i].w, WHITE) ;
+        }
+    }
+}
+
+static void full_redraw(void) {
+    fillRect(0, 0, 640, 480, BLACK) ;
+    drawHLine_fast(0, GROUND, 640, WHITE) ;
+    for (int i = 0; i < 2; i++) {
+        blitSprite(&poses[players[i].pose], players[i].x - BOX_DX, players[i].y - BOX_DY, colors[i]) ;
+    }
+}
+
+// A step of up to 5 pixels, inside the player's side; player 1 can walk
+// partly off the right edge
+static void wander(int i) {
+    short lo = i ? 330 : 20, hi = i ? 630 : 250 ;
+    int r = rand() % 8 ;
+
+    if (r < 3) players[i].x += (r - 1) * 5 ;
+    else if (r == 3) players[i].pose ^= 1 ;
+    else if (r == 4) players[i].y += (rand() % 3 - 1) * 2 ;
+    if (players[i].x < lo) players[i].x = lo ;
+    if (players[i].x > hi) players[i].x = hi ;
+    if (players[i].y < 335) players[i].y = 335 ;
+    if (players[i].y > 355) players[i].y = 355 ;
+}
+
+int main(void) {
+    const struct dirty_stats *stats = getDirtyStats() ;
+    unsigned long long before ;
+    unsigned int frames ;
+    int wrong = 0, first = -1 ;
+
+    capture_poses() ;
+    players[0] = (struct player) {100, 345, 0} ;
+    players[1] = (struct player) {600, 345, 1} ;
+    full_redraw() ;
+    for (int i = 0; i < 2; i++) draw(i) ;
+    before = stats->total_pixels ;
+    frames = stats->frames ;
+
+    srand(1) ;
+    for (int f = 0; f < FRAMES; f++) {
+        wander(0) ;
+        wander(1) ;
+        erase(0) ;
+        erase(1) ;
+        clearDirty(BLACK) ;
+        repair_ground() ;
+        draw(0) ;
+        draw(1) ;
+
+        memcpy(incremental, vga_data_array, FRAME_BYTES) ;
+        full_redraw() ;
+        if (memcmp(incremental, vga_data_array, FRAME_BYTES)) {
+            if (!wrong++) first = f ;
+        }
+        memcpy(vga_data_array, incremental, FRAME_BYTES) ;
+    }
+    if (wrong) printf("%d frames differ, first %d\n", wrong, first) ;
+    CHECK(wrong == 0) ;
+
+    printf("cleared %.0f pixels a frame, %.1f%% of the screen\n",
+           (double) (stats->total_pixels - before) / FRAMES,
+           100.0 * (stats->total_pixels - before) / FRAMES / (640*480)) ;
+    CHECK(stats->frames - frames == FRAMES) ;
+    CHECK(stats->total_pixels - before < (unsigned long long) FRAMES * 640*480 / 10) ;
+    return CHECK_DONE() ;
+}
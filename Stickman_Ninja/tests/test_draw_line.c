@@ -0,0 +1,135 @@
+/**
+ * Clipped, incremental-address drawLine against the per-pixel Bresenham
+ * it replaced: the same pixels for every stickman segment and for lines
+ * in all octants, clipped lines that keep exactly the on-screen pixels
+ * instead of smearing onto the border, and ns/pixel before and after
+ * over the segments the poses draw
+ */
+
+#include <stdlib.h>
+#include "host.h"
+#include "vga_graphics.h"
+#include "ref_graphics.h"
+
+// The drawLine segments of draw_stickman, every pose and facing,
+// relative to the player's position
+static const short segments[][4] = {
+    // facing left: legs, arm, stab, block, wait
+    {0, 30, -15, 53}, {0, 30, 6, 53}, {6, 53, 15, 75}, {0, 0, 15, 30},
+    {0, 0, -30, 3},
+    {0, 0, -11, 23}, {-11, 23, -24, 15},
+    {0, 0, -9, 12}, {-9, 12, -30, 0}, {-24, 6, -69, -39}, {-29, -5, -35, 2},
+    // facing right
+    {0, 30, -6, 53}, {-6, 53, -15, 75}, {0, 30, 15, 53}, {0, 0, -15, 30},
+    {0, 0, 30, 3},
+    {0, 0, 11, 23}, {11, 23, 24, 15},
+    {0, 0, 9, 12}, {9, 12, 30, 0}, {24, 6, 69, -39}, {29, -5, 35, 2},
+} ;
+#define SEGMENTS (sizeof(segments) / sizeof(segments[0]))
+
+static void clear_both(void) {
+    fillRect(0, 0, 640, 480, BLACK) ;
+    ref_clear() ;
+}
+
+static void draw_segments(void (*line)(short, short, short, short, char), short x, short y, char color) {
+    for (unsigned int i = 0; i < SEGMENTS; i++) {
+        line(x + segments[i][0], y + segments[i][1], x + segments[i][2], y + segments[i][3], color) ;
+    }
+}
+
+static void test_image(void) {
+    clear_both() ;
+    // both players at their start and a spread of odd/even positions
+    for (short i = 0; i < 8; i++) {
+        draw_segments(drawLine, 100 + 57*i, 120 + 35*i, 1 + i % 7) ;
+        draw_segments(ref_drawLine, 100 + 57*i, 120 + 35*i, 1 + i % 7) ;
+    }
+    CHECK(frame_diff() == 0) ;
+
+    // every octant, from a fan of endpoints around a centre
+    clear_both() ;
+    for (short a = -60; a <= 60; a += 7) {
+        short ends[4][2] = {{a, -60}, {a, 60}, {-60, a}, {60, a}} ;
+        for (int e = 0; e < 4; e++) {
+            drawLine(320, 240, 320 + ends[e][0], 240 + ends[e][1], (a & 7) | 1) ;
+            ref_drawLine(320, 240, 320 + ends[e][0], 240 + ends[e][1], (a & 7) | 1) ;
+        }
+    }
+    drawLine(5, 5, 5, 5, WHITE) ;
+    ref_drawLine(5, 5, 5, 5, WHITE) ;
+    drawLine(0, 0, 639, 479, RED) ;
+    ref_drawLine(0, 0, 639, 479, RED) ;
+    CHECK(frame_diff() == 0) ;
+}
+
+// Lines with one or both ends off the screen, some a long way off: the
+// pixels on screen are exactly the unclipped line's. The old line clamped,
+// piling the overhang onto the border row or column
+static void clip_both(short x0, short y0, short x1, short y1, char color) {
+    drawLine(x0, y0, x1, y1, color) ;
+    ref_drawLine(x0, y0, x1, y1, color) ;
+}
+
+static void test_clip(void) {
+    int differ = 0 ;
+
+    ref_drop_offscreen = true ;
+    srand(3) ;
+    for (int n = 0; n < 300; n++) {
+        short x0 = rand() % 1400 - 380, y0 = rand() % 1100 - 310 ;
+        short x1 = rand() % 1400 - 380, y1 = rand() % 1100 - 310 ;
+        clear_both() ;
+        clip_both(x0, y0, x1, y1, WHITE) ;
+        if (frame_diff()) differ++ ;
+    }
+    CHECK(differ == 0) ;
+
+    clear_both() ;
+    // entirely off the screen, or crossing only a corner
+    clip_both(-10, -10, -100, 300, WHITE) ;
+    clip_both(700, 0, 800, 479, WHITE) ;
+    clip_both(-5, 10, 10, -5, RED) ;
+    clip_both(630, 490, 650, 470, RED) ;
+    // far off, in every direction (the old line's short arithmetic
+    // overflows past 32767 across)
+    clip_both(-16000, 100, 16000, 300, GREEN) ;
+    clip_both(300, -16000, 320, 16000, GREEN) ;
+    clip_both(-16000, -12000, 16000, 12000, BLUE) ;
+    clip_both(16320, -11760, -15680, 12240, BLUE) ;
+    // along the edges
+    clip_both(-50, 0, 700, 0, YELLOW) ;
+    clip_both(639, -50, 639, 600, YELLOW) ;
+    CHECK(frame_diff() == 0) ;
+    ref_drop_offscreen = false ;
+}
+
+// ns per pixel for n sets of pose segments
+static double time_segments(void (*line)(short, short, short, short, char), int n) {
+    unsigned int pixels = 0 ;
+    double start ;
+
+    for (unsigned int i = 0; i < SEGMENTS; i++) {
+        short dx = abs(segments[i][2] - segments[i][0]), dy = abs(segments[i][3] - segments[i][1]) ;
+        pixels += (dx > dy ? dx : dy) + 1 ;
+    }
+    start = host_nsec() ;
+    for (int i = 0; i < n; i++) draw_segments(line, 140 + (i & 1), 345, i & 7) ;
+    return (host_nsec() - start) / ((double) n * pixels) ;
+}
+
+static void bench(void) {
+    double before = time_segments(ref_drawLine, 20000) ;
+    double after = time_segments(drawLine, 20000) ;
+
+    printf("pose segments: %.3f -> %.3f ns/pixel\n", before, after) ;
+    CHECK(after < before) ;
+}
+
+int main(void) {
+    initVGA() ;
+    test_image() ;
+    test_clip() ;
+    bench() ;
+    return CHECK_DONE() ;
+}
@@ -0,0 +1,75 @@
+/**
+ * Cross-core event flags from real threads: two producers (a thread and an
+ * "interrupt" on the other core) raise bits as fast as they can while a
+ * consumer sleeps in __wfe between takes. Every signal must be either
+ * taken or counted as coalesced, and the consumer must never sleep
+ * through a raised bit
+ */
+
+#include <pthread.h>
+#include "host.h"
+#include "pt_cornell_rp2040_v1.h"
+
+#define SIGNALS 200000
+
+static struct pt_event event ;
+static atomic_int producers_done ;
+static unsigned int taken[2], sleeps ;
+
+static void *producer(void *arg) {
+    unsigned int bit = (unsigned int) (uintptr_t) arg ;
+
+    host_core = bit == 1 ? 0 : 1 ;
+    for (int i = 0; i < SIGNALS; i++) {
+        pt_event_signal(&event, bit) ;
+    }
+    atomic_fetch_add(&producers_done, 1) ;
+    __sev() ;
+    return 0 ;
+}
+
+static void *consumer(void *arg) {
+    unsigned int got ;
+    bool done ;
+
+    (void) arg ;
+    host_core = 1 ;
+    while (1) {
+        // read done first: once it's set, every signal is already in the bits
+        done = atomic_load(&producers_done) == 2 ;
+        got = pt_event_take(&event, 3) ;
+        if (got & 1) taken[0]++ ;
+        if (got & 2) taken[1]++ ;
+        if (got) continue ;
+        if (done) break ;
+        __wfe() ;
+        sleeps++ ;
+    }
+    return 0 ;
+}
+
+int main(void) {
+    pthread_t threads[3] ;
+    struct pt_event other ;
+    int lock ;
+
+    // each event claims a spinlock of its own
+    pt_event_init(&event) ;
+    pt_event_init(&other) ;
+    CHECK(event.lock != other.lock) ;
+    for (lock = 0; lock < 32 && spin_lock_instance(lock) != event.lock; lock++) ;
+    CHECK(lock < 32 && spin_lock_is_claimed(lock)) ;
+
+    pthread_create(&threads[0], 0, consumer, 0) ;
+    pthread_create(&threads[1], 0, producer, (void *) 1) ;
+    pthread_create(&threads[2], 0, producer, (void *) 2) ;
+    for (int i = 0; i < 3; i++) pthread_join(threads[i], 0) ;
+
+    printf("signals %u, taken %u + %u, coalesced %u, consumer slept %u times\n",
+           event.signals, taken[0], taken[1], event.coalesced, sleeps) ;
+    CHECK(event.signals == 2 * SIGNALS) ;
+    CHECK(taken[0] > 0 && taken[1] > 0) ;
+    CHECK(taken[0] + taken[1] + event.coalesced == event.signals) ;
+    CHECK(event.bits == 0) ;
+    return CHECK_DONE() ;
+}
@@ -0,0 +1,88 @@
+/**
+ * Span fillRect against the per-pixel one it replaced: the same image for
+ * rectangles at every odd/even edge, clipping where the old one clamped,
+ * and ns/pixel before and after for the player erase box and the full
+ * screen clear
+ */
+
+#include <stdlib.h>
+#include "host.h"
+#include "vga_graphics.h"
+#include "ref_graphics.h"
+
+#define BOX_W  168      // a player's erase box
+#define BOX_H  135
+
+static void clear_both(void) {
+    fillRect(0, 0, 640, 480, BLACK) ;
+    ref_clear() ;
+}
+
+// Both ways on an on-screen rectangle
+static void same(short x, short y, short w, short h, char color) {
+    fillRect(x, y, w, h, color) ;
+    ref_fillRect(x, y, w, h, color) ;
+}
+
+static void test_image(void) {
+    clear_both() ;
+    // every combination of odd and even edges, narrow and wide
+    for (short w = 0; w <= 23; w++) {
+        for (short dx = 0; dx < 10; dx++) same(20 + 30*dx, 10 + 12*w, w, 10, 1 + (w+dx) % 7) ;
+    }
+    // overlapping, so the edge masks must keep their neighbours
+    srand(1) ;
+    for (int i = 0; i < 500; i++) {
+        short x = rand() % 600, y = 300 + rand() % 150 ;
+        same(x, y, 1 + rand() % (640 - x), 1 + rand() % (480 - y), rand() & 7) ;
+    }
+    same(0, 0, 640, 5, WHITE) ;
+    same(0, 475, 640, 5, CYAN) ;
+    CHECK(frame_diff() == 0) ;
+}
+
+// Off the edges the old fill clamped, smearing the overhang onto the
+// border; the span fill drops it
+static void test_clip(void) {
+    clear_both() ;
+    fillRect(-50, -20, 100, 60, RED) ;
+    ref_fillRect(0, 0, 50, 40, RED) ;
+    fillRect(600, 450, 100, 100, GREEN) ;
+    ref_fillRect(600, 450, 40, 30, GREEN) ;
+    fillRect(-10, 100, 700, 3, BLUE) ;
+    ref_fillRect(0, 100, 640, 3, BLUE) ;
+    fillRect(700, 100, 10, 10, WHITE) ;
+    fillRect(100, -30, 10, 10, WHITE) ;
+    fillRect(100, 100, -5, 10, WHITE) ;
+    fillRect(100, 200, 10, 0, WHITE) ;
+    CHECK(frame_diff() == 0) ;
+}
+
+// ns per pixel of n fills of w x h, alternating x by step
+static double time_fill(void (*fill)(short, short, short, short, char),
+                        short x, short y, short w, short h, short step, int n) {
+    double start = host_nsec() ;
+    for (int i = 0; i < n; i++) fill(x + (i & 1)*step, y, w, h, i & 7) ;
+    return (host_nsec() - start) / ((double) n * w * h) ;
+}
+
+static void bench(void) {
+    double box_before, box_after, full_before, full_after ;
+
+    // odd and even left edges
+    box_before = time_fill(ref_fillRect, 56, 285, BOX_W, BOX_H, 1, 400) ;
+    box_after = time_fill(fillRect, 56, 285, BOX_W, BOX_H, 1, 4000) ;
+    full_before = time_fill(ref_fillRect, 0, 0, 640, 480, 0, 20) ;
+    full_after = time_fill(fillRect, 0, 0, 640, 480, 0, 400) ;
+    printf("erase box %dx%d: %.3f -> %.3f ns/pixel\n", BOX_W, BOX_H, box_before, box_after) ;
+    printf("full screen:      %.3f -> %.3f ns/pixel\n", full_before, full_after) ;
+    CHECK(box_after < box_before && full_after < full_before) ;
+}
+
+int main(void) {
+    initVGA() ;
+    test_image() ;
+    test_clip() ;
+    bench() ;
+    return CHECK_DONE() ;
+}
@@ -0,0 +1,95 @@
+/**
+ * Cached drawChar against the uncached one it sped up: the same image
+ * for every character, size the game uses and pixel phase, over a busy
+ * background whose neighbouring pixels must survive, with characters off
+ * the edges and transparent ones taking the uncached path, and across
+ * cache flushes. Also reports ns/char for the HUD-sized text
+ */
+
+#include <stdlib.h>
+#include "host.h"
+#include "vga_graphics.h"
+#include "ref_graphics.h"
+
+#define BENCH_CHARS 100000
+// glcdfont.c stops at 254
+#define CHARS       255
+
+static void clear_both(void) {
+    fillRect(0, 0, 640, 480, BLACK) ;
+    ref_clear() ;
+}
+
+static void same(short x, short y, unsigned char c, char color, char bg, unsigned char size) {
+    drawChar(x, y, c, color, bg, size) ;
+    ref_drawChar(x, y, c, color, bg, size) ;
+}
+
+// Stripes under the text, so a glyph row copied over a whole unit would
+// show up in the pixels either side of it
+static void background(void) {
+    for (short y = 0; y < 480; y += 3) {
+        fillRect(0, y, 640, 1, 1 + (y % 7)) ;
+        ref_fillRect(0, y, 640, 1, 1 + (y % 7)) ;
+    }
+}
+
+// Every character once in each phase, sizes 1 to 3, then again from the
+// cache; the table holds 64, so this also flushes it many times
+static void test_image(void) {
+    const struct glyph_stats *stats = getGlyphStats() ;
+    unsigned int hits, misses ;
+
+    clear_both() ;
+    background() ;
+    for (int pass = 0; pass < 2; pass++) {
+        for (unsigned char size = 1; size <= 3; size++) {
+            for (int c = 0; c < CHARS; c++) {
+                short x = (c % 40) * 6 * size / 2 + (c % 10) + 3*pass ;
+                short y = (c / 40) * 8 * size + 160*(size - 1) ;
+                same(x, y, c, WHITE, (size + c) % 7, size) ;
+            }
+        }
+    }
+    CHECK(frame_diff() == 0) ;
+    CHECK(stats->misses > 0 && stats->flushes > 0) ;
+
+    // a line of the HUD's digits, over and over, comes from the cache
+    hits = stats->hits ;
+    misses = stats->misses ;
+    for (int i = 0; i < 100; i++) {
+        for (int d = 0; d < 10; d++) same(300 + 6*d, 460, '0' + d, RED, BLACK, 1) ;
+    }
+    CHECK(stats->misses - misses == 10 && stats->hits - hits == 990) ;
+    CHECK(frame_diff() == 0) ;
+}
+
+// Random characters, colors and places, some transparent and some off
+// the edges of the screen
+static void test_random(void) {
+    clear_both() ;
+    background() ;
+    srand(1) ;
+    for (int i = 0; i < 5000; i++) {
+        unsigned char size = 1 + rand() % 4 ;
+        short x = rand() % 680 - 30, y = rand() % 520 - 30 ;
+        char color = rand() & 7 ;
+        char bg = (rand() % 4) ? (rand() & 7) : color ;
+        same(x, y, rand() % CHARS, color, bg, size) ;
+    }
+    CHECK(frame_diff() == 0) ;
+}
+
+static double bench(void (*draw)(short, short, unsigned char, char, char, unsigned char)) {
+    double start = host_nsec() ;
+    for (int i = 0; i < BENCH_CHARS; i++) draw(200 + 6*(i % 40), 100, '0' + i % 10, RED, BLACK, 1) ;
+    return (host_nsec() - start) / BENCH_CHARS ;
+}
+
+int main(void) {
+    ref_drop_offscreen = true ;
+    test_image() ;
+    test_random() ;
+    printf("size 1 digits: %.1f ns/char uncached, %.1f cached\n", bench(ref_drawChar), bench(drawChar)) ;
+    return CHECK_DONE() ;
+}
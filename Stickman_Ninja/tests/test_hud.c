@@ -0,0 +1,88 @@
+/**
+ * HUD health widget: hud_format's reciprocal multiplies against sprintf
+ * over 0..999 and the clamps either side, and an update from any health
+ * to any other against drawing the widget from scratch at the new value
+ */
+
+#include <string.h>
+#include "host.h"
+#include "vga_graphics.h"
+#include "hud.h"
+#include "ref_graphics.h"
+
+// The game's left widget, and the area it covers: the bar with its
+// border, then the number
+#define BAR_X   40
+#define BAR_Y   42
+#define TEXT_X  247
+#define TEXT_Y  43
+#define AREA_X  (BAR_X - 2)
+#define AREA_Y  (BAR_Y - 2)
+#define AREA_W  (TEXT_X + 18 - AREA_X)
+#define AREA_H  14
+
+static unsigned char fresh[101][AREA_H][AREA_W] ;
+
+static void test_format(void) {
+    char digits[3], want[8] ;
+    int n, wrong = 0 ;
+
+    for (int v = 0; v <= 999; v++) {
+        n = hud_format(v, digits) ;
+        if ((n != sprintf(want, "%d", v)) || memcmp(digits, want, n)) wrong++ ;
+    }
+    CHECK(wrong == 0) ;
+
+    // out of range clamps to 0 and 999
+    CHECK(hud_format(-1, digits) == 1 && digits[0] == '0') ;
+    CHECK(hud_format(-32768, digits) == 1 && digits[0] == '0') ;
+    CHECK(hud_format(1000, digits) == 3 && !memcmp(digits, "999", 3)) ;
+    CHECK(hud_format(32767, digits) == 3 && !memcmp(digits, "999", 3)) ;
+}
+
+static void grab(unsigned char area[AREA_H][AREA_W]) {
+    for (short y = 0; y < AREA_H; y++) {
+        for (short x = 0; x < AREA_W; x++) area[y][x] = vga_pixel(AREA_X + x, AREA_Y + y) ;
+    }
+}
+
+static void draw_fresh(struct hud_health *w, short value) {
+    fillRect(AREA_X, AREA_Y, AREA_W, AREA_H, BLACK) ;
+    hud_health_init(w, BAR_X, BAR_Y, TEXT_X, TEXT_Y, RED, value) ;
+}
+
+// Every health the game shows, updated to from every other, must leave
+// the image a fresh draw gives; out of range clamps like the bar does
+static void test_update(void) {
+    struct hud_health w ;
+    unsigned char now[AREA_H][AREA_W] ;
+    int wrong = 0 ;
+
+    for (short v = 0; v <= 100; v++) {
+        draw_fresh(&w, v) ;
+        grab(fresh[v]) ;
+    }
+    for (short from = 0; from <= 100; from++) {
+        for (short to = 0; to <= 100; to++) {
+            draw_fresh(&w, from) ;
+            hud_health_update(&w, to) ;
+            grab(now) ;
+            if (memcmp(now, fresh[to], sizeof(now))) wrong++ ;
+        }
+    }
+    CHECK(wrong == 0) ;
+
+    draw_fresh(&w, 50) ;
+    hud_health_update(&w, -20) ;
+    grab(now) ;
+    CHECK(memcmp(now, fresh[0], sizeof(now)) == 0) ;
+    hud_health_update(&w, 250) ;
+    grab(now) ;
+    CHECK(memcmp(now, fresh[100], sizeof(now)) == 0) ;
+}
+
+int main(void) {
+    test_format() ;
+    test_update() ;
+    return CHECK_DONE() ;
+}
@@ -0,0 +1,111 @@
+/**
+ * Bus time per sample on the I2C model, at the driver's baud rate: the
+ * two pointer-write + 6-byte reads (accel at 0x3B, gyro at 0x43) the
+ * driver used to do, against the 14-byte burst, blocking and from the
+ * interrupts, and against draining the FIFO eight samples at a time
+ */
+
+#include "host.h"
+#include "i2c_mock.h"
+#include "mpu6050.h"
+
+#define FIFO_SAMPLES 8
+
+static struct mpu6050_dev imu ;
+static struct mpu_model *model ;
+static unsigned long bits ;
+static unsigned int transactions ;
+
+static void sample(int n) {
+    int16_t accel[3] = {(int16_t) n, 0, 16384} ;
+    int16_t gyro[3] = {(int16_t) (131*n), 0, 0} ;
+    mpu_model_sample(model, accel, 0, gyro) ;
+}
+
+static void setup(bool fifo) {
+    i2c_mock_reset() ;
+    model = mpu_model_add(0, ADDRESS) ;
+    mpu6050_dev_init(&imu, i2c0, ADDRESS) ;
+    CHECK(mpu6050_init_all(&imu, 1) == 0) ;
+    if (fifo) mpu6050_fifo_enable(&imu) ;
+}
+
+static void mark(void) {
+    bits = i2c_mock_bus[0].bits ;
+    transactions = model->transactions ;
+}
+
+// Bits since mark, per sample; prints the line and returns the bits
+static double report(const char *name, int samples) {
+    double per = (double) (i2c_mock_bus[0].bits - bits) / samples ;
+
+    printf("%-22s %6.1f bits  %6.1f usec  %4.2f transactions per sample\n", name,
+           per, per * 1e6 / I2C_BAUD_RATE, (double) (model->transactions - transactions) / samples) ;
+    return per ;
+}
+
+// The old read: pointer write, keep the bus, 6 bytes, twice
+static double before(void) {
+    uint8_t reg, buffer[6] ;
+
+    setup(false) ;
+    sample(1) ;
+    mark() ;
+    reg = 0x3B ;
+    CHECK(i2c_write_blocking(i2c0, ADDRESS, &reg, 1, true) == 1) ;
+    CHECK(i2c_read_blocking(i2c0, ADDRESS, buffer, 6, false) == 6) ;
+    CHECK(buffer[0] == 0 && buffer[1] == 1) ;
+    reg = 0x43 ;
+    CHECK(i2c_write_blocking(i2c0, ADDRESS, &reg, 1, true) == 1) ;
+    CHECK(i2c_read_blocking(i2c0, ADDRESS, buffer, 6, false) == 6) ;
+    CHECK(buffer[0] == 0 && buffer[1] == 131) ;
+    CHECK(model->transactions - transactions == 2) ;
+    return report("two 6-byte reads", 1) ;
+}
+
+static double burst(void) {
+    struct mpu6050_sample s ;
+
+    setup(false) ;
+    sample(1) ;
+    mark() ;
+    CHECK(mpu6050_read_all(&imu, 1, &s) == 0) ;
+    CHECK(s.accel[0] == 1 << 2 && s.gyro[0] == 65500) ;
+    CHECK(model->transactions - transactions == 1) ;
+    return report("14-byte burst", 1) ;
+}
+
+static double burst_async(void) {
+    setup(false) ;
+    mpu6050_async_init(&imu, 1, 0) ;
+    sample(1) ;
+    mark() ;
+    CHECK(mpu6050_async_start() == 1) ;
+    i2c_mock_run() ;
+    CHECK(mpu6050_async_frame()->imu[0].gyro[0] == 65500) ;
+    CHECK(model->transactions - transactions == 1) ;
+    return report("14-byte burst, async", 1) ;
+}
+
+static double fifo(void) {
+    setup(true) ;
+    mpu6050_async_init(&imu, 1, 0) ;
+    for (int i = 1; i <= FIFO_SAMPLES; i++) sample(i) ;
+    mark() ;
+    CHECK(mpu6050_async_start() == 1) ;
+    i2c_mock_run() ;
+    CHECK(mpu6050_async_batch()->count[0] == FIFO_SAMPLES) ;
+    return report("FIFO, 8 per drain", FIFO_SAMPLES) ;
+}
+
+int main(void) {
+    double old = before() ;
+    double now = burst() ;
+
+    // the burst also brings the temperature, and is still shorter
+    CHECK(now < old) ;
+    CHECK(burst_async() == now) ;
+    CHECK(fifo() < now) ;
+    CHECK(i2c_mock_bus[0].rx_overflows == 0 && i2c_mock_bus[0].rx_underflows == 0) ;
+    return CHECK_DONE() ;
+}
@@ -0,0 +1,226 @@
+/**
+ * mpu6050 driver against the bus model: blocking init and reads, the
+ * interrupt-driven engine, aborts, interrupts that arrive with nothing
+ * in flight, and reads driven by the data-ready lines
+ */
+
+#include <math.h>
+#include "host.h"
+#include "i2c_mock.h"
+#include "mpu6050.h"
+
+static struct mpu6050_dev imu[2] ;
+static struct mpu_model *model[2] ;
+static int callbacks ;
+
+static void frame_ready(void) {
+    callbacks++ ;
+}
+
+static void sample(struct mpu_model *m, int16_t a, int16_t g, int16_t t) {
+    int16_t accel[3] = {a, (int16_t) -a, (int16_t) (a/2)} ;
+    int16_t gyro[3] = {g, (int16_t) (2*g), (int16_t) -g} ;
+    mpu_model_sample(m, accel, t, gyro) ;
+}
+
+static void setup(void) {
+    i2c_mock_reset() ;
+    model[0] = mpu_model_add(0, ADDRESS) ;
+    model[1] = mpu_model_add(1, ADDRESS) ;
+    mpu6050_dev_init(&imu[0], i2c0, ADDRESS) ;
+    mpu6050_dev_init(&imu[1], i2c1, ADDRESS) ;
+}
+
+static void test_blocking(void) {
+    struct mpu6050_sample s[2] ;
+
+    setup() ;
+    imu[1].accel_range = 2 ;
+    CHECK(mpu6050_init_all(imu, 2) == 0) ;
+    CHECK(model[0]->reg[0x6B] == 0x00) ;
+    CHECK(model[0]->reg[0x19] == 7) ;
+    CHECK(model[0]->reg[0x38] == 0x01) ;
+    CHECK(model[1]->reg[0x1C] == 2 << 3) ;
+
+    // 16384 LSB/g at +/-2g, 4096 at +/-8g; 131 LSB/(deg/sec);
+    // -521 is 35.0 degC
+    sample(model[0], 16384, 131, -521) ;
+    sample(model[1], 4096, -131, -521) ;
+    CHECK(mpu6050_read_all(imu, 2, s) == 0) ;
+    CHECK(s[0].accel[0] == int2fix15(1) && s[0].accel[1] == -int2fix15(1) && s[0].accel[2] == int2fix15(1)/2) ;
+    CHECK(s[1].accel[0] == int2fix15(1)) ;
+    CHECK(s[0].gyro[0] == 65500 && s[0].gyro[1] == 131000 && s[1].gyro[0] == -65500) ;
+    CHECK(fabs(fix2float15(s[0].temp) - 35.0) < 0.01) ;
+    // one burst per device
+    CHECK(model[0]->transactions == 6 + 1) ;
+
+    // a device that doesn't answer is reported, the other still read
+    model[1]->nak = true ;
+    CHECK(mpu6050_read_all(imu, 2, s) == 2) ;
+    CHECK(i2c_mock_bus[0].rx_overflows == 0 && i2c_mock_bus[0].rx_underflows == 0) ;
+}
+
+static void test_async(void) {
+    const struct mpu6050_frame *f ;
+
+    setup() ;
+    mpu6050_init_all(imu, 2) ;
+    callbacks = 0 ;
+    mpu6050_async_init(imu, 2, frame_ready) ;
+
+    sample(model[0], 16384, 131, 0) ;
+    sample(model[1], 8192, 262, 0) ;
+    host_timer.timerawl = 1000 ;
+    CHECK(mpu6050_async_start() == 1) ;
+    // still in flight: a second start is refused
+    CHECK(mpu6050_async_start() == 0) ;
+    i2c_mock_run() ;
+    CHECK(callbacks == 1) ;
+    CHECK(mpu6050_async_count() == 1) ;
+    f = mpu6050_async_frame() ;
+    CHECK(f->errors == 0 && f->fresh == 3) ;
+    CHECK(f->imu[0].accel[0] == int2fix15(1) && f->imu[1].accel[0] == int2fix15(1)/2) ;
+    CHECK(f->imu[1].gyro[0] == 131000) ;
+    CHECK(f->stamp[0] == 1000 && f->stamp[1] == 1000) ;
+
+    // NAK on bus 1: the frame still publishes, with the old sample for it
+    model[1]->nak = true ;
+    sample(model[0], -16384, 0, 0) ;
+    CHECK(mpu6050_async_start() == 1) ;
+    i2c_mock_run() ;
+    CHECK(callbacks == 2) ;
+    f = mpu6050_async_frame() ;
+    CHECK(f->errors == 2 && f->fresh == 1) ;
+    CHECK(f->imu[0].accel[0] == -int2fix15(1)) ;
+    CHECK(f->imu[1].accel[0] == int2fix15(1)/2) ;
+    CHECK(mpu6050_async_aborts() == 1) ;
+    model[1]->nak = false ;
+
+    for (int b = 0; b < 2; b++) {
+        CHECK(i2c_mock_bus[b].rx_overflows == 0 && i2c_mock_bus[b].rx_underflows == 0) ;
+    }
+}
+
+// An interrupt with nothing in flight (late, or spurious) is cleared and
+// ignored
+static void test_spurious(void) {
+    i2c_hw_t *hw = i2c_get_hw(i2c0) ;
+    unsigned int aborts ;
+
+    setup() ;
+    mpu6050_init_all(imu, 2) ;
+    callbacks = 0 ;
+    mpu6050_async_init(imu, 2, frame_ready) ;
+    mpu6050_async_start() ;
+    i2c_mock_run() ;
+    CHECK(callbacks == 1) ;
+    aborts = mpu6050_async_aborts() ;
+
+    // a stray byte over the threshold, and a stale abort
+    hw->rx_tl = 0 ;
+    i2c_mock_bus[0].rx[0] = 0x55 ;
+    i2c_mock_bus[0].rx_count = 1 ;
+    hw->raw_intr_stat |= I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS ;
+    CHECK(i2c_mock_service(0, 10) == 1) ;
+    CHECK(i2c_mock_bus[0].rx_count == 0) ;
+    CHECK(!(hw->raw_intr_stat & I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS)) ;
+    CHECK(callbacks == 1 && mpu6050_async_aborts() == aborts) ;
+
+    // and the engine still works afterwards
+    hw->rx_tl = 13 ;
+    CHECK(mpu6050_async_start() == 1) ;
+    i2c_mock_run() ;
+    CHECK(callbacks == 2) ;
+}
+
+// A data-ready pulse on imu n's INT line at time t
+static void ready(int n, unsigned int t) {
+    host_timer.timerawl = t ;
+    host_gpio_edge(imu[n].int_pin, GPIO_IRQ_EDGE_RISE) ;
+}
+
+static void test_data_ready(void) {
+    const struct mpu6050_frame *f ;
+    unsigned int transactions ;
+
+    setup() ;
+    mpu6050_init_all(imu, 2) ;
+    imu[0].int_pin = 21 ;
+    imu[1].int_pin = 22 ;
+    callbacks = 0 ;
+    mpu6050_async_init(imu, 2, frame_ready) ;
+
+    // one pulse each: a whole frame, each sample stamped with its own edge
+    sample(model[0], 16384, 0, 0) ;
+    sample(model[1], 8192, 0, 0) ;
+    ready(0, 100) ;
+    i2c_mock_run() ;
+    CHECK(callbacks == 0) ;
+    ready(1, 150) ;
+    i2c_mock_run() ;
+    CHECK(callbacks == 1) ;
+    f = mpu6050_async_frame() ;
+    CHECK(f->fresh == 3 && f->stamp[0] == 100 && f->stamp[1] == 150) ;
+    CHECK(f->imu[0].accel[0] == int2fix15(1) && f->imu[1].accel[0] == int2fix15(1)/2) ;
+    CHECK(imu[0].overruns == 0 && imu[1].overruns == 0) ;
+
+    // the pulse ending is not a new sample
+    transactions = model[0]->transactions ;
+    host_gpio_edge(imu[0].int_pin, GPIO_IRQ_EDGE_FALL) ;
+    i2c_mock_run() ;
+    CHECK(model[0]->transactions == transactions && callbacks == 1 && imu[0].overruns == 0) ;
+
+    // imu 0 ready again before imu 1: the frame goes out with only imu 0
+    // fresh, rather than the second sample overwriting the first
+    sample(model[0], 4096, 0, 0) ;
+    ready(0, 1000) ;
+    i2c_mock_run() ;
+    sample(model[0], -16384, 0, 0) ;
+    ready(0, 2000) ;
+    CHECK(callbacks == 2 && imu[0].overruns == 1) ;
+    f = mpu6050_async_frame() ;
+    CHECK(f->fresh == 1 && f->stamp[0] == 1000 && f->imu[0].accel[0] == int2fix15(1)/4) ;
+    // imu 1 carries its last sample
+    CHECK(f->stamp[1] == 150 && f->imu[1].accel[0] == int2fix15(1)/2) ;
+    i2c_mock_run() ;
+    sample(model[1], 16384, 0, 0) ;
+    ready(1, 2500) ;
+    i2c_mock_run() ;
+    CHECK(callbacks == 3) ;
+    f = mpu6050_async_frame() ;
+    CHECK(f->fresh == 3 && f->stamp[0] == 2000 && f->imu[0].accel[0] == -int2fix15(1)) ;
+    CHECK(f->stamp[1] == 2500 && f->imu[1].accel[0] == int2fix15(1)) ;
+
+    // pulses faster than the bus: one while the read is in flight, one
+    // while the next is still queued. The queued read picks up the newest
+    // sample; the one in between is lost, and each pulse counts
+    sample(model[0], 16384, 0, 0) ;
+    ready(0, 3000) ;
+    sample(model[0], 8192, 0, 0) ;
+    ready(0, 3100) ;
+    sample(model[0], 4096, 0, 0) ;
+    ready(0, 3200) ;
+    CHECK(imu[0].overruns == 3) ;
+    i2c_mock_run() ;
+    CHECK(callbacks == 4) ;
+    f = mpu6050_async_frame() ;
+    CHECK(f->fresh == 1 && f->stamp[0] == 3000 && f->imu[0].accel[0] == int2fix15(1)) ;
+    ready(1, 3300) ;
+    i2c_mock_run() ;
+    CHECK(callbacks == 5) ;
+    f = mpu6050_async_frame() ;
+    CHECK(f->fresh == 3 && f->stamp[0] == 3200 && f->imu[0].accel[0] == int2fix15(1)/4) ;
+    CHECK(imu[1].overruns == 0) ;
+
+    for (int b = 0; b < 2; b++) {
+        CHECK(i2c_mock_bus[b].rx_overflows == 0 && i2c_mock_bus[b].rx_underflows == 0) ;
+    }
+}
+
+int main(void) {
+    test_blocking() ;
+    test_async() ;
+    test_spurious() ;
+    test_data_ready() ;
+    return CHECK_DONE() ;
+}
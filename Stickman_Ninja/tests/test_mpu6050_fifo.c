@@ -0,0 +1,241 @@
+/**
+ * mpu6050 FIFO batching against the byte-stream model: blocking and
+ * interrupt-driven drains, records split by a drain, overflow and
+ * recovery, drains started from thread context with interrupts taken as
+ * they assert, and batches through the fusion filter
+ */
+
+#include "host.h"
+#include "i2c_mock.h"
+#include "mpu6050.h"
+#include "fusion.h"
+
+static struct mpu6050_dev imu[2] ;
+static struct mpu_model *model[2] ;
+static int callbacks ;
+
+static const struct mpu6050_batch *batch ;
+static const struct mpu6050_frame *f ;
+
+static void frame_ready(void) {
+    callbacks++ ;
+}
+
+// One async drain of every device; batch and frame move with each publish
+static void drain(void) {
+    mpu6050_async_start() ;
+    i2c_mock_run() ;
+    batch = mpu6050_async_batch() ;
+    f = mpu6050_async_frame() ;
+}
+
+// Sample n of a ramp: accel X = n, gyro X = 131*n (n deg/sec)
+static void sample(struct mpu_model *m, int n) {
+    int16_t accel[3] = {(int16_t) n, 0, 16384} ;
+    int16_t gyro[3] = {(int16_t) (131*n), 0, 0} ;
+    mpu_model_sample(m, accel, 0, gyro) ;
+}
+
+static bool is_sample(const struct mpu6050_sample *s, int n) {
+    return s->accel[0] == n << 2 && s->accel[2] == int2fix15(1) && s->gyro[0] == 65500 * n ;
+}
+
+static void setup(void) {
+    i2c_mock_reset() ;
+    model[0] = mpu_model_add(0, ADDRESS) ;
+    model[1] = mpu_model_add(1, ADDRESS) ;
+    mpu6050_dev_init(&imu[0], i2c0, ADDRESS) ;
+    mpu6050_dev_init(&imu[1], i2c1, ADDRESS) ;
+    mpu6050_init_all(imu, 2) ;
+    mpu6050_fifo_enable(&imu[0]) ;
+    mpu6050_fifo_enable(&imu[1]) ;
+}
+
+static void test_blocking(void) {
+    struct mpu6050_sample s[100] ;
+    uint8_t half[6] = {0} ;
+
+    setup() ;
+    CHECK(model[0]->reg[0x23] == 0x78 && model[0]->reg[0x6A] == 0x40) ;
+    for (int i = 1; i <= 10; i++) sample(model[0], i) ;
+    CHECK(model[0]->fifo_count == 120) ;
+    CHECK(mpu6050_fifo_read(&imu[0], s, 100) == 10) ;
+    CHECK(is_sample(&s[0], 1) && is_sample(&s[9], 10)) ;
+    CHECK(model[0]->fifo_count == 0) ;
+
+    // caught part way through writing a record: no false overflow, the
+    // whole records come out and the partial one waits
+    sample(model[0], 11) ;
+    mpu_model_fifo_push(model[0], half, 6) ;
+    CHECK(mpu6050_fifo_read(&imu[0], s, 100) == 1) ;
+    CHECK(is_sample(&s[0], 11)) ;
+    CHECK(imu[0].fifo_overflows == 0 && model[0]->fifo_count == 6) ;
+    mpu_model_fifo_push(model[0], half, 6) ;
+    CHECK(mpu6050_fifo_read(&imu[0], s, 100) == 1) ;
+
+    // max caps a drain, the rest stays queued
+    for (int i = 1; i <= 5; i++) sample(model[0], i) ;
+    CHECK(mpu6050_fifo_read(&imu[0], s, 3) == 3 && model[0]->fifo_count == 24) ;
+    CHECK(mpu6050_fifo_read(&imu[0], s, 3) == 2 && is_sample(&s[1], 5)) ;
+
+    // 86 records overflow the 1024 bytes: reset, then carry on
+    for (int i = 1; i <= 86; i++) sample(model[0], i) ;
+    CHECK(model[0]->reg[0x3A] & 0x10) ;
+    CHECK(mpu6050_fifo_read(&imu[0], s, 100) == -1) ;
+    CHECK(imu[0].fifo_overflows == 1 && model[0]->fifo_count == 0) ;
+    CHECK(!(model[0]->reg[0x3A] & 0x10)) ;
+    sample(model[0], 7) ;
+    CHECK(mpu6050_fifo_read(&imu[0], s, 100) == 1 && is_sample(&s[0], 7)) ;
+
+    // a full FIFO that hasn't overflowed is fine (85 records, 1020 bytes)
+    for (int i = 1; i <= 85; i++) sample(model[0], i) ;
+    CHECK(mpu6050_fifo_read(&imu[0], s, 100) == 85 && imu[0].fifo_overflows == 1) ;
+    CHECK(is_sample(&s[84], 85)) ;
+
+    mpu6050_fifo_disable(&imu[0]) ;
+    CHECK(model[0]->reg[0x6A] == 0 && model[0]->reg[0x38] == 0x01) ;
+}
+
+static void test_async(void) {
+    unsigned int transactions ;
+
+    setup() ;
+    callbacks = 0 ;
+    mpu6050_async_init(imu, 2, frame_ready) ;
+
+    // 8 ms of samples on one IMU, 5 on the other
+    for (int i = 1; i <= 8; i++) sample(model[0], i) ;
+    for (int i = 1; i <= 5; i++) sample(model[1], 100 + i) ;
+    transactions = model[0]->transactions ;
+    CHECK(mpu6050_async_start() == 1) ;
+    CHECK(mpu6050_async_start() == 0) ;
+    drain() ;
+    CHECK(callbacks == 1) ;
+    CHECK(batch->count[0] == 8 && batch->count[1] == 5) ;
+    CHECK(is_sample(&batch->imu[0][0], 1) && is_sample(&batch->imu[0][7], 8)) ;
+    CHECK(is_sample(&batch->imu[1][4], 105)) ;
+    CHECK(is_sample(&f->imu[0], 8) && is_sample(&f->imu[1], 105)) ;
+    CHECK(f->errors == 0 && batch->overflows == 0) ;
+    // status, count, data: three transactions for eight samples where
+    // bursts would take eight
+    CHECK(model[0]->transactions - transactions == 3) ;
+
+    // more than a batch: 16 now, the other 4 next time
+    for (int i = 1; i <= 20; i++) sample(model[0], i) ;
+    drain() ;
+    CHECK(batch->count[0] == 16 && batch->count[1] == 0) ;
+    CHECK(is_sample(&batch->imu[0][15], 16)) ;
+    // nothing new on imu 1: the frame keeps its last sample
+    CHECK(is_sample(&f->imu[1], 105)) ;
+    drain() ;
+    CHECK(batch->count[0] == 4 && is_sample(&batch->imu[0][3], 20)) ;
+
+    // a record only half written is left for the next drain
+    for (int i = 1; i <= 2; i++) sample(model[0], i) ;
+    mpu_model_fifo_push(model[0], (const uint8_t *) "\0\0\0\0\0", 5) ;
+    drain() ;
+    CHECK(batch->count[0] == 2 && batch->overflows == 0 && model[0]->fifo_count == 5) ;
+    model[0]->fifo_count = 0 ;
+
+    // overflow: the drain resets the FIFO and the next one picks up
+    for (int i = 1; i <= 90; i++) sample(model[1], i) ;
+    drain() ;
+    CHECK(batch->count[1] == 0 && batch->overflows == 2) ;
+    CHECK(imu[1].fifo_overflows == 1 && model[1]->fifo_count == 0) ;
+    sample(model[1], 3) ;
+    drain() ;
+    CHECK(batch->count[1] == 1 && batch->overflows == 0 && is_sample(&batch->imu[1][0], 3)) ;
+
+    // the bus lost part way through the data: the next drain resets the
+    // FIFO rather than read misaligned records
+    for (int i = 1; i <= 4; i++) sample(model[0], i) ;
+    mpu6050_async_start() ;
+    // status and count go through, then arbitration is lost mid-record
+    i2c_mock_service(0, 2) ;
+    i2c_mock_bus[0].aborted = true ;
+    i2c_mock_bus[0].dev = 0 ;
+    i2c_get_hw(i2c0)->raw_intr_stat |= I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS ;
+    i2c_mock_run() ;
+    f = mpu6050_async_frame() ;
+    CHECK(f->errors == 1 && mpu6050_async_aborts() == 1) ;
+    CHECK(model[0]->fifo_count > 0) ;
+    drain() ;
+    CHECK(batch->count[0] == 0 && model[0]->fifo_count == 0 && f->errors == 0) ;
+    sample(model[0], 9) ;
+    drain() ;
+    CHECK(batch->count[0] == 1 && is_sample(&batch->imu[0][0], 9)) ;
+
+    for (int b = 0; b < 2; b++) {
+        CHECK(i2c_mock_bus[b].rx_overflows == 0 && i2c_mock_bus[b].rx_underflows == 0) ;
+    }
+}
+
+// Interrupts taken the moment they assert, as on the chip. Started from
+// thread context, the requests mustn't be cut into by the bus interrupts
+// they set off, or a device's drain is lost or the frame goes out early
+static void test_eager(void) {
+    setup() ;
+    callbacks = 0 ;
+    mpu6050_async_init(imu, 2, frame_ready) ;
+    i2c_mock_eager = true ;
+    i2c_mock_bus[0].unmasked = i2c_mock_bus[1].unmasked = 0 ;
+    for (int round = 1; round <= 3; round++) {
+        for (int i = 1; i <= 8; i++) sample(model[0], 10*round + i) ;
+        for (int i = 1; i <= 5; i++) sample(model[1], 100 + i) ;
+        CHECK(mpu6050_async_start() == 1) ;
+        // the whole drain ran from the interrupts as start returned
+        CHECK(callbacks == round) ;
+        batch = mpu6050_async_batch() ;
+        f = mpu6050_async_frame() ;
+        CHECK(batch->count[0] == 8 && batch->count[1] == 5) ;
+        CHECK(is_sample(&batch->imu[0][7], 10*round + 8) && is_sample(&f->imu[1], 105)) ;
+        CHECK(f->fresh == 3 && f->errors == 0) ;
+    }
+    i2c_mock_eager = false ;
+    for (int b = 0; b < 2; b++) {
+        CHECK(i2c_mock_bus[b].unmasked == 0) ;
+        CHECK(i2c_mock_bus[b].rx_overflows == 0 && i2c_mock_bus[b].rx_underflows == 0) ;
+    }
+}
+
+// A batch through the filter ends where sample-by-sample fusion does
+static void test_fusion(void) {
+    struct fusion a, b ;
+    struct mpu6050_sample s ;
+    fix15 dt = fusion_dt_usec(MPU6050_SAMPLE_USEC) ;
+
+    setup() ;
+    mpu6050_async_init(imu, 2, 0) ;
+    fusion_init(&a, 4, zeropt99, zeropt01) ;
+    fusion_init(&b, 4, zeropt99, zeropt01) ;
+    for (int i = 1; i <= 12; i++) {
+        sample(model[0], 50*i) ;
+        s.accel[0] = (50*i) << 2 ;
+        s.accel[1] = 0 ;
+        s.accel[2] = int2fix15(1) ;
+        s.gyro[0] = 65500 * 50*i ;
+        s.gyro[1] = s.gyro[2] = 0 ;
+        fusion_update(&a, &s, dt) ;
+    }
+    drain() ;
+    CHECK(batch->count[0] == 12) ;
+    fusion_update_batch(&b, batch->imu[0], batch->count[0], dt) ;
+    CHECK(a.angle == b.angle && a.ax == b.ax) ;
+    CHECK(a.angle != 0) ;
+}
+
+// Intervals in microseconds, up to a second and past it
+static void test_dt(void) {
+    CHECK(fusion_dt_usec(1000) == 65) ;
+    CHECK(fusion_dt_usec(1000000) == int2fix15(1)) ;
+    CHECK(fusion_dt_usec(4000000) == int2fix15(4) + 1) ;
+}
+
+int main(void) {
+    test_blocking() ;
+    test_async() ;
+    test_eager() ;
+    test_fusion() ;
+    test_dt() ;
+    return CHECK_DONE() ;
+}
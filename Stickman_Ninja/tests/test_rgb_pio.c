@@ -0,0 +1,319 @@
+/**
+ * The RGB state machine on a cycle model of the PIO. The program is read
+ * from rgb.pio itself (rgb, or rgb_packed under VGA_PACKED), with the
+ * shift and autopull settings from its init function, and fed the DMA
+ * words of a framebuffer row that drawPixel filled. Checks that the pins
+ * show every pixel of the row in order, that autopull refills the OSR
+ * exactly on each word boundary with no stall, that the DMA moves 32-bit
+ * words, and that each pixel lasts one pixel clock (two in 320x240)
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "host.h"
+#include "hardware/pio.h"
+#include "hardware/dma.h"
+#include "vga_graphics.h"
+
+#ifdef VGA_PACKED
+#define PROGRAM         "rgb_packed"
+#define PIXELS_PER_WORD 10
+#else
+#define PROGRAM         "rgb"
+#define PIXELS_PER_WORD 8
+#endif
+#define SYS_MHZ   125
+#define PIXEL_MHZ 25
+#define RGB_SM    2
+
+extern char *address_pointer ;
+
+/////////////////////////////////////////////////////////////////
+// The subset of PIO assembly rgb.pio uses
+
+enum op {OP_PULL, OP_OUT, OP_SET, OP_MOV, OP_WAIT, OP_JMP} ;
+enum reg {R_PINS, R_X, R_Y, R_NULL, R_OSR} ;
+
+struct insn {
+    enum op op ;
+    enum reg dest, src ;
+    int bits ;              // out bit count, or set value
+    int delay ;
+    char label[32] ;        // jmp target, resolved into target
+    int target ;
+} ;
+
+static struct {
+    struct insn code[32] ;
+    int n, wrap_target, wrap ;
+    int threshold ;         // autopull threshold, from sm_config_set_out_shift
+    bool autopull, shift_right ;
+} prog ;
+
+#define LABELS 8
+static char labels[LABELS][32] ;
+static int label_at[LABELS], nlabels ;
+
+static enum reg reg_of(const char *s) {
+    if (!strcmp(s, "pins")) return R_PINS ;
+    if (!strcmp(s, "x")) return R_X ;
+    if (!strcmp(s, "y")) return R_Y ;
+    if (!strcmp(s, "osr")) return R_OSR ;
+    return R_NULL ;
+}
+
+// One instruction, comment and label already stripped. 0 if not understood
+static bool assemble(char *line, struct insn *in) {
+    char op[16], a[16] = "", b[16] = "", *d = strchr(line, '[') ;
+
+    memset(in, 0, sizeof(*in)) ;
+    if (d) {
+        in->delay = atoi(d + 1) ;
+        *d = 0 ;
+    }
+    for (char *c = line; *c; c++) if (*c == ',') *c = ' ' ;
+    if (sscanf(line, "%15s %15s %15s", op, a, b) < 1) return false ;
+    if (!strcmp(op, "pull")) in->op = OP_PULL ;
+    else if (!strcmp(op, "out")) {
+        in->op = OP_OUT ;
+        in->dest = reg_of(a) ;
+        in->bits = atoi(b) ;
+    } else if (!strcmp(op, "set")) {
+        in->op = OP_SET ;
+        in->dest = reg_of(a) ;
+        in->bits = atoi(b) ;
+    } else if (!strcmp(op, "mov")) {
+        in->op = OP_MOV ;
+        in->dest = reg_of(a) ;
+        in->src = reg_of(b) ;
+    } else if (!strcmp(op, "wait")) in->op = OP_WAIT ;
+    else if (!strcmp(op, "jmp") && !strcmp(a, "x--")) {
+        in->op = OP_JMP ;
+        strcpy(in->label, b) ;
+    } else return false ;
+    return true ;
+}
+
+// Assemble program name from the .pio file, and take its OSR settings
+// from the c-sdk block that follows it
+static bool load(const char *path, const char *name) {
+    FILE *f = fopen(path, "r") ;
+    char line[256], want[64], sr[8], ap[8] ;
+    bool in = false, sdk = false ;
+
+    if (!f) return false ;
+    memset(&prog, 0, sizeof(prog)) ;
+    nlabels = 0 ;
+    snprintf(want, sizeof(want), ".program %s", name) ;
+    while (fgets(line, sizeof(line), f)) {
+        char *c = strchr(line, ';'), *s = line, *e ;
+        if (c) *c = 0 ;
+        while (*s == ' ' || *s == '\t') s++ ;
+        for (e = s + strlen(s); e > s && (e[-1] == '\n' || e[-1] == '\r' || e[-1] == ' ' || e[-1] == '\t'); ) *--e = 0 ;
+
+        if (!strncmp(s, ".program", 8)) {
+            in = !strcmp(s, want) ;
+            sdk = false ;
+        } else if (!strncmp(s, "% c-sdk", 7)) {
+            sdk = in ;
+            in = false ;
+        } else if (sdk) {
+            if (sscanf(s, "sm_config_set_out_shift(&c, %7[a-z], %7[a-z], %d", sr, ap, &prog.threshold) == 3) {
+                prog.shift_right = !strcmp(sr, "true") ;
+                prog.autopull = !strcmp(ap, "true") ;
+            }
+            if (!strncmp(s, "%}", 2)) sdk = false ;
+        } else if (in && *s) {
+            if (!strcmp(s, ".wrap_target")) prog.wrap_target = prog.n ;
+            else if (!strcmp(s, ".wrap")) prog.wrap = prog.n - 1 ;
+            else if (e[-1] == ':' && nlabels < LABELS) {
+                e[-1] = 0 ;
+                strcpy(labels[nlabels], s) ;
+                label_at[nlabels++] = prog.n ;
+            } else if (!assemble(s, &prog.code[prog.n++])) {
+                printf("can't model: %s\n", s) ;
+                fclose(f) ;
+                return false ;
+            }
+        }
+    }
+    fclose(f) ;
+    for (int i = 0; i < prog.n; i++) {
+        if (prog.code[i].op != OP_JMP) continue ;
+        prog.code[i].target = -1 ;
+        for (int l = 0; l < nlabels && l < LABELS; l++) {
+            if (!strcmp(labels[l], prog.code[i].label)) prog.code[i].target = label_at[l] ;
+        }
+        if (prog.code[i].target < 0) return false ;
+    }
+    return prog.n > 0 && prog.threshold > 0 ;
+}
+
+/////////////////////////////////////////////////////////////////
+// One state machine
+
+static struct {
+    uint32_t osr, x, y ;
+    int count ;             // output shift count
+    int pc ;
+    unsigned long cycle ;   // state machine clocks
+    int pins ;
+    const uint32_t *fifo ;  // words DMA has ready, always enough
+    int fifo_used ;
+    int stalls ;
+    int refills ;
+    int bad_refills ;       // refilled with the shift count off the threshold
+    int pixels_at_refill[128] ;
+} sm ;
+
+static int pixel[640] ;
+static unsigned long pixel_cycle[640] ;
+static int npixels ;
+
+static void refill(void) {
+    if (sm.count != prog.threshold && sm.fifo_used > 1) sm.bad_refills++ ;
+    if (sm.refills < 128) sm.pixels_at_refill[sm.refills] = npixels ;
+    sm.refills++ ;
+    sm.osr = sm.fifo[sm.fifo_used++] ;
+    sm.count = 0 ;
+}
+
+// Run from pc until the machine waits for the vsync machine's irq, or
+// runs away. The wait is let through once if go is set
+static void run(bool go) {
+    for (int steps = 0; steps < 100000; steps++) {
+        struct insn *in = &prog.code[sm.pc] ;
+        int next = sm.pc == prog.wrap ? prog.wrap_target : sm.pc + 1 ;
+        uint32_t v ;
+
+        switch (in->op) {
+        case OP_PULL:
+            sm.osr = sm.fifo[sm.fifo_used++] ;
+            sm.count = 0 ;
+            break ;
+        case OP_OUT:
+            // an out from an empty OSR stalls for autopull
+            if (prog.autopull && sm.count >= prog.threshold) {
+                sm.stalls++ ;
+                sm.cycle++ ;
+                refill() ;
+            }
+            v = in->bits == 32 ? sm.osr : sm.osr & ((1u << in->bits) - 1) ;
+            sm.osr = in->bits == 32 ? 0 : sm.osr >> in->bits ;
+            sm.count += in->bits ;
+            if (in->dest == R_PINS) {
+                sm.pins = v & 0x7 ;
+                if (npixels < 640) {
+                    pixel[npixels] = sm.pins ;
+                    pixel_cycle[npixels] = sm.cycle ;
+                }
+                npixels++ ;
+            }
+            if (in->dest == R_X) sm.x = v ;
+            if (in->dest == R_Y) sm.y = v ;
+            // autopull refills on the out that empties the OSR
+            if (prog.autopull && sm.count >= prog.threshold) refill() ;
+            break ;
+        case OP_SET:
+            if (in->dest == R_PINS) sm.pins = in->bits ;
+            break ;
+        case OP_MOV:
+            v = in->src == R_Y ? sm.y : in->src == R_X ? sm.x : sm.osr ;
+            if (in->dest == R_X) sm.x = v ;
+            if (in->dest == R_Y) sm.y = v ;
+            break ;
+        case OP_WAIT:
+            if (!go) return ;
+            go = false ;
+            break ;
+        case OP_JMP:
+            if (sm.x != 0) next = in->target ;
+            sm.x-- ;
+            break ;
+        }
+        sm.cycle += 1 + in->delay ;
+        sm.pc = next ;
+    }
+    CHECK(false) ;
+}
+
+/////////////////////////////////////////////////////////////////
+
+static void test_mode(char mode, short width) {
+    int colors[640], words ;
+    uint32_t line[82] ;
+    float clkdiv ;
+    unsigned long sys_cycles ;
+    bool uniform = true ;
+
+    memset(&host_pio_sm, 0, sizeof(host_pio_sm)) ;
+    initVGAMode(mode) ;
+    clkdiv = host_pio_sm[RGB_SM].clkdiv ? host_pio_sm[RGB_SM].clkdiv : 1 ;
+    // 32-bit transfers: the whole frame, or one line at a time
+    CHECK(host_dma_size[0] == DMA_SIZE_32) ;
+    words = dma_hw->ch[0].transfer_count ;
+    if (mode == VGA_640x480) {
+        CHECK(words % 480 == 0) ;
+        words /= 480 ;
+    }
+    CHECK(words * PIXELS_PER_WORD >= width && (words - 1) * PIXELS_PER_WORD < width) ;
+
+    // a row of every color, in a shuffled order
+    srand(width) ;
+    for (short x = 0; x < width; x++) {
+        colors[x] = rand() & 7 ;
+        drawPixel(x, 0, colors[x]) ;
+    }
+    if (mode == VGA_320x240) {
+        // it was drawn off-screen: flip it in, through to the next frame
+        vga_flip() ;
+        while (vga_flip_pending()) host_irq(DMA_IRQ_0) ;
+    }
+    // the loop counter initVGAMode sends, the row, and the next row's first
+    // word, which autopull takes as the row ends
+    line[0] = host_pio_sm[RGB_SM].put ;
+    memcpy(line + 1, address_pointer, words * 4) ;
+    line[1 + words] = 0 ;
+
+    memset(&sm, 0, sizeof(sm)) ;
+    npixels = 0 ;
+    sm.fifo = line ;
+    // the first word is in the OSR while the machine waits for the line
+    run(false) ;
+    CHECK(sm.fifo_used == 2) ;
+    run(true) ;
+    for (int x = 0; x < width; x++) {
+        if (pixel[x] != colors[x]) {
+            printf("pixel %d: %d, want %d\n", x, pixel[x], colors[x]) ;
+            break ;
+        }
+    }
+
+    CHECK(npixels == width) ;
+    CHECK(memcmp(pixel, colors, width * sizeof(int)) == 0) ;
+    // back to black for the blanking
+    CHECK(sm.pins == 0) ;
+    // every word used, each refill right on its boundary, and no stalls
+    CHECK(sm.fifo_used == 2 + words) ;
+    CHECK(sm.bad_refills == 0 && sm.stalls == 0) ;
+    for (int i = 1; i < sm.refills && i < 128; i++) {
+        if (sm.pixels_at_refill[i] != i * PIXELS_PER_WORD) uniform = false ;
+    }
+    // each pixel lasts the same, across word boundaries too
+    sys_cycles = (unsigned long) ((pixel_cycle[1] - pixel_cycle[0]) * clkdiv) ;
+    for (int x = 1; x < width; x++) {
+        if (pixel_cycle[x] - pixel_cycle[x-1] != pixel_cycle[1] - pixel_cycle[0]) uniform = false ;
+    }
+    CHECK(uniform) ;
+    CHECK(sys_cycles * PIXEL_MHZ == SYS_MHZ * (640 / width)) ;
+    printf("%dx%d %s: %d pixels per 32-bit word, %d words per line, %lu system clocks per pixel\n",
+           width, width * 3 / 4, PROGRAM, PIXELS_PER_WORD, words, sys_cycles) ;
+}
+
+int main(void) {
+    CHECK(load(RGB_PIO, PROGRAM)) ;
+    CHECK(prog.shift_right && prog.autopull) ;
+    test_mode(VGA_640x480, 640) ;
+    test_mode(VGA_320x240, 320) ;
+    return CHECK_DONE() ;
+}
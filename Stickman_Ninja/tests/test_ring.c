@@ -0,0 +1,103 @@
+/**
+ * The SPSC frame ring from two threads: a producer standing in for the
+ * I2C interrupt on one core and a consumer standing in for the sensor
+ * thread on the other. Every frame is filled from its sequence number so
+ * a torn copy or a slot read before it was written shows up. Run once
+ * retrying when full (nothing may be lost) and once dropping when full
+ * (as the callback does), with the indices starting just short of the
+ * 32-bit wrap
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include "host.h"
+#include "mpu6050.h"
+
+#define FRAMES 2000000
+
+static struct mpu6050_ring ring ;
+static atomic_int producer_done ;
+static bool retry ;
+static unsigned int pushed ;
+
+static void fill(struct mpu6050_frame *f, unsigned int seq) {
+    for (int i = 0; i < MPU6050_MAX_DEVS; i++) {
+        for (int j = 0; j < 3; j++) {
+            f->imu[i].accel[j] = (fix15) (seq * 3 + i + j) ;
+            f->imu[i].gyro[j] = (fix15) (seq * 5 - i - j) ;
+        }
+        f->imu[i].temp = (fix15) (seq ^ i) ;
+        f->stamp[i] = seq + i ;
+    }
+    f->time = seq ;
+    f->errors = ~seq ;
+    f->fresh = seq ;
+}
+
+static bool intact(const struct mpu6050_frame *f) {
+    struct mpu6050_frame want ;
+    fill(&want, f->time) ;
+    return memcmp(f, &want, sizeof(want)) == 0 ;
+}
+
+static void *producer(void *arg) {
+    struct mpu6050_frame f ;
+
+    (void) arg ;
+    host_core = 0 ;
+    for (unsigned int seq = 1; seq <= FRAMES; seq++) {
+        fill(&f, seq) ;
+        while (!mpu6050_ring_push(&ring, &f)) {
+            if (!retry) break ;
+            sched_yield() ;
+        }
+        if (seq % 256 == 0) sched_yield() ;
+    }
+    atomic_store(&producer_done, 1) ;
+    return 0 ;
+}
+
+static void run(bool retry_when_full) {
+    pthread_t thread ;
+    struct mpu6050_frame f ;
+    unsigned int popped = 0, last = 0, torn = 0, out_of_order = 0 ;
+    bool done ;
+
+    memset(&ring, 0, sizeof(ring)) ;
+    // head - tail must stay right as both counters wrap
+    ring.head = ring.tail = 0xfffffff0u ;
+    retry = retry_when_full ;
+    atomic_store(&producer_done, 0) ;
+
+    host_core = 1 ;
+    pthread_create(&thread, 0, producer, 0) ;
+    while (1) {
+        done = atomic_load(&producer_done) ;
+        if (mpu6050_ring_pop(&ring, &f)) {
+            if (!intact(&f)) torn++ ;
+            if (f.time <= last) out_of_order++ ;
+            last = f.time ;
+            popped++ ;
+        } else if (done) {
+            break ;
+        } else {
+            sched_yield() ;
+        }
+    }
+    pthread_join(thread, 0) ;
+    pushed = ring.head - 0xfffffff0u ;
+
+    printf("%s: popped %u, dropped %u, high water %u\n",
+           retry_when_full ? "retry" : "drop", popped, ring.overflows, ring.high_water) ;
+    CHECK(torn == 0 && out_of_order == 0) ;
+    CHECK(popped == pushed && ring.tail == ring.head) ;
+    CHECK(ring.high_water <= MPU6050_RING_SIZE) ;
+    if (retry_when_full) CHECK(popped == FRAMES && last == FRAMES) ;
+    else CHECK(popped + ring.overflows == FRAMES) ;
+}
+
+int main(void) {
+    run(true) ;
+    run(false) ;
+    return CHECK_DONE() ;
+}
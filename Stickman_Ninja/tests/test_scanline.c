@@ -0,0 +1,111 @@
+/**
+ * The VGA_SCANLINE backend against the framebuffer: the shared scene goes
+ * into a display list, the line interrupt paints it a line at a time into
+ * the ring the DMA reads, and each line is picked up as it is queued. The
+ * image must match the framebuffer build's pixel for pixel (that build
+ * runs as a separate program, named on the command line). Also reports
+ * the slowest line against the 25.4 usec an active line lasts
+ */
+
+#include <stdio.h>
+#include "host.h"
+#include "vga_graphics.h"
+#include "scene.h"
+
+#define LINE_BUDGET_NSEC 25400.0
+#define TIMED_FRAMES     20
+
+// the line buffer channel 1 hands the DMA next
+extern char *address_pointer ;
+
+static unsigned char image[480][640], want[480][640] ;
+static double line_nsec[480] ;
+static unsigned int queued = 1 ;     // line address_pointer holds
+
+static int line_pixel(const char *line, short x) {
+#ifdef VGA_PACKED
+    return (((const unsigned int *) line)[x/10] >> (3*(x%10))) & 0x7 ;
+#else
+    return (((const unsigned char *) line)[x>>1] >> ((x & 1) ? 3 : 0)) & 0x7 ;
+#endif
+}
+
+// One line interrupt: queue the next line, paint the one two lines on.
+// Keeps the fastest time seen for each painted line
+static void line_irq(void) {
+    unsigned int painted ;
+    double start = host_nsec(), nsec ;
+
+    host_irq(DMA_IRQ_0) ;
+    nsec = host_nsec() - start ;
+    queued = (queued + 1) % 480 ;
+    painted = (queued + 2) % 480 ;
+    if (line_nsec[painted] == 0 || nsec < line_nsec[painted]) line_nsec[painted] = nsec ;
+}
+
+static bool load_framebuffer_image(const char *program) {
+    FILE *f = popen(program, "r") ;
+    size_t n ;
+
+    if (!f) return false ;
+    n = fread(want, 1, sizeof(want), f) ;
+    return (pclose(f) == 0) && (n == sizeof(want)) ;
+}
+
+static void test_image(const char *program) {
+    int differ = 0, first_x = -1, first_y = -1 ;
+
+    scene_draw() ;
+    vga_flip() ;
+    CHECK(vga_flip_pending()) ;
+    // the flip lands where line 0 is painted, two lines ahead of the DMA;
+    // run to the end of that frame, picking each line up as it's queued
+    while (queued != 0) line_irq() ;
+    CHECK(!vga_flip_pending()) ;
+    do {
+        for (short x = 0; x < 640; x++) image[queued][x] = line_pixel(address_pointer, x) ;
+        line_irq() ;
+    } while (queued != 0) ;
+
+    CHECK(load_framebuffer_image(program)) ;
+    for (short y = 0; y < 480; y++) {
+        for (short x = 0; x < 640; x++) {
+            if (image[y][x] == want[y][x]) continue ;
+            if (!differ++) {
+                first_x = x ;
+                first_y = y ;
+            }
+        }
+    }
+    if (differ) printf("%d pixels differ, first at (%d, %d)\n", differ, first_x, first_y) ;
+    CHECK(differ == 0) ;
+    CHECK(getScanlineStats()->dropped_spans == 0) ;
+}
+
+// The host is a good deal faster than the RP2040, so this only shows how
+// the lines compare and catches one that could never fit; on the board,
+// getScanlineStats() counts the lines that were actually late
+static void test_line_time(void) {
+    int worst = 0 ;
+
+    for (int i = 0; i < TIMED_FRAMES * 480; i++) line_irq() ;
+    for (int y = 1; y < 480; y++) {
+        if (line_nsec[y] > line_nsec[worst]) worst = y ;
+    }
+    printf("display list: %u spans, at most %u on a line; slowest line %d: %.2f usec on the host (budget %.1f)\n",
+           getScanlineStats()->max_spans, getScanlineStats()->max_line_spans,
+           worst, line_nsec[worst] / 1000, LINE_BUDGET_NSEC / 1000) ;
+    CHECK(line_nsec[worst] < LINE_BUDGET_NSEC) ;
+}
+
+int main(int argc, char **argv) {
+    if (argc != 2) {
+        printf("usage: %s <framebuffer scene program>\n", argv[0]) ;
+        return 2 ;
+    }
+    initVGA() ;
+    CHECK(host_irq_handler[DMA_IRQ_0] != 0) ;
+    test_image(argv[1]) ;
+    test_line_time() ;
+    return CHECK_DONE() ;
+}
@@ -0,0 +1,233 @@
+/**
+ * The SCHED_RATE scheduler on a simulated clock: threads "run" by moving
+ * the timer on by their cost, and the scheduler's idle sleep jumps it to
+ * the next wake time. Release counts and deadline misses for the game's
+ * input/render split, an overload, idle accounting, the 32-bit timer
+ * wrap, and PT_YIELD_INTERVAL across the wrap and from a stale marker.
+ * Built again with PT_STATS, where SysTick counts down 125 cycles per
+ * simulated usec: each thread's calls, cycles, longest run and wake
+ * latency must come out of the costs and releases exactly
+ */
+
+#include "host.h"
+#ifdef PT_STATS
+#define CYCLES_PER_USEC 125
+#define pt_stats_cycles() ((0u - CYCLES_PER_USEC * host_timer.timerawl) & 0x00ffffff)
+#endif
+#include "pt_cornell_rp2040_v1.h"
+
+#define SECOND       1000000
+#define INPUT_USEC   1000
+#define RENDER_USEC  16667
+
+static unsigned int cost[3], runs[3] ;
+static int input_id, render_id ;
+
+static PT_THREAD (protothread_input(struct pt *pt))
+{
+    PT_BEGIN(pt) ;
+    while (1) {
+        runs[0]++ ;
+        host_timer.timerawl += cost[0] ;
+        PT_YIELD(pt) ;
+    }
+    PT_END(pt) ;
+}
+
+static PT_THREAD (protothread_render(struct pt *pt))
+{
+    PT_BEGIN(pt) ;
+    while (1) {
+        runs[1]++ ;
+        host_timer.timerawl += cost[1] ;
+        PT_YIELD(pt) ;
+    }
+    PT_END(pt) ;
+}
+
+static PT_THREAD (protothread_background(struct pt *pt))
+{
+    PT_BEGIN(pt) ;
+    while (1) {
+        runs[2]++ ;
+        host_timer.timerawl += cost[2] ;
+        PT_YIELD(pt) ;
+    }
+    PT_END(pt) ;
+}
+
+static PT_THREAD (protothread_interval(struct pt *pt))
+{
+    PT_BEGIN(pt) ;
+    PT_INTERVAL_INIT() ;
+    while (1) {
+        PT_YIELD_INTERVAL(10000) ;
+        runs[0]++ ;
+        host_timer.timerawl += 300 ;
+    }
+    PT_END(pt) ;
+}
+
+// An empty core 0 with the clock at start
+static void reset(unsigned int start) {
+    host_timer.timerawl = start ;
+    pt_task_count = 0 ;
+    memset(pt_thread_list, 0, sizeof(pt_thread_list)) ;
+    memset(pt_order, 0, sizeof(pt_order)) ;
+    memset(runs, 0, sizeof(runs)) ;
+    pt_idle_usec[0] = 0 ;
+    pt_idle_mark[0] = 0 ;
+    pt_idle_window[0] = start ;
+}
+
+// input and render as the game sets them up, optionally with an always
+// ready background thread
+static void add_game(unsigned int render_cost, bool background) {
+    cost[0] = 50 ;
+    cost[1] = render_cost ;
+    cost[2] = 10 ;
+    if (background) pt_add(protothread_background) ;
+    render_id = pt_add_rate(protothread_render, RENDER_USEC, 10) ;
+    input_id = pt_add_rate(protothread_input, INPUT_USEC, 0) ;
+}
+
+static void run_for(unsigned int usec) {
+    unsigned int end = host_timer.timerawl + usec ;
+    while ((int) (host_timer.timerawl - end) < 0) {
+        pt_sched_rate_step(pt_thread_list, pt_order, pt_task_count, 0) ;
+    }
+}
+
+#ifdef PT_STATS
+// A thread that ran n times at cost usec each; it became due at most
+// late usec before each call, or never had a due time if late < 0
+static void check_stats(int id, unsigned int n, unsigned int cost, int late) {
+    const struct pt_stats *s = pt_get_stats(0, id) ;
+    unsigned int run = cost * CYCLES_PER_USEC ;
+
+    CHECK(s->calls == n) ;
+    CHECK(s->cycles == (unsigned long long) n * run) ;
+    CHECK(s->run_max == run && pt_stats_run_p99(s) == run) ;
+    if (late < 0) {
+        CHECK(s->wakes == 0 && s->wake_max == 0) ;
+        return ;
+    }
+    CHECK(s->wakes == n) ;
+    CHECK(s->wake_max <= (unsigned int) late) ;
+    CHECK(pt_stats_wake_p99(s) <= s->wake_max) ;
+}
+#endif
+
+static void report(const char *name) {
+    printf("%s: input %u (miss %u), render %u (miss %u), background %u\n", name,
+           runs[0], pt_deadline_misses(0, input_id), runs[1], pt_deadline_misses(0, render_id), runs[2]) ;
+}
+
+// A second of the normal load: every release runs, none late
+static void test_rates(unsigned int start) {
+    reset(start) ;
+    add_game(800, true) ;
+    run_for(SECOND) ;
+    report(start ? "across the wrap" : "normal") ;
+    CHECK(runs[0] >= 1000 && runs[0] <= 1001) ;
+    CHECK(runs[1] >= 60 && runs[1] <= 61) ;
+    CHECK(pt_deadline_misses(0, input_id) == 0 && pt_deadline_misses(0, render_id) == 0) ;
+    // the background thread soaks up the rest
+    CHECK(runs[2] > 50000) ;
+#ifdef PT_STATS
+    // input waits out at most a render run, render at most one run of
+    // input and one of the background thread
+    check_stats(input_id, runs[0], 50, 800) ;
+    check_stats(render_id, runs[1], 800, 60) ;
+    check_stats(0, runs[2], 10, -1) ;
+    CHECK(pt_get_stats(0, 3) == 0 && pt_get_stats(1, 0) == 0 && pt_get_stats(0, -1) == 0) ;
+#endif
+}
+
+// render longer than its period: it misses every release, and each run
+// holds input off for 19 of its releases, but input still runs first
+// whenever both are due
+static void test_overload(void) {
+    reset(0) ;
+    add_game(20000, true) ;
+    run_for(SECOND) ;
+    report("overload") ;
+    CHECK(pt_deadline_misses(0, render_id) >= runs[1]) ;
+    CHECK(pt_deadline_misses(0, input_id) >= 18 * runs[1]) ;
+    CHECK(runs[0] >= runs[1]) ;
+    CHECK(pt_deadline_misses(1, input_id) == 0 && pt_deadline_misses(0, 7) == 0) ;
+    CHECK(pt_deadline_misses(0, -1) == 0) ;
+#ifdef PT_STATS
+    // 20 msec runs, 2.5M cycles each, wrap SysTick's 24 bits many times
+    // over the second and still add up
+    check_stats(render_id, runs[1], 20000, 20000) ;
+    check_stats(input_id, runs[0], 50, 20000 + 50) ;
+    CHECK(pt_get_stats(0, input_id)->wake_max > 19000) ;
+    pt_stats_reset(0) ;
+    CHECK(pt_get_stats(0, render_id)->calls == 0 && pt_get_stats(0, render_id)->cycles == 0) ;
+#endif
+}
+
+// Without a background thread the core sleeps between releases, and the
+// idle share is what's left: 1000 x 50 usec plus 60 x 800 usec busy
+static void test_idle(void) {
+    unsigned int start = 12345 ;
+
+    reset(start) ;
+    add_game(800, false) ;
+    run_for(SECOND) ;
+    pt_idle_update(0, host_timer.timerawl) ;
+    printf("idle %d%%\n", pt_idle_percent(0)) ;
+    CHECK(pt_idle_percent(0) >= 89 && pt_idle_percent(0) <= 91) ;
+    CHECK(pt_deadline_misses(0, input_id) == 0 && pt_deadline_misses(0, render_id) == 0) ;
+}
+
+#ifdef PT_STATS
+// Two threads released together every msec: the second always waits out
+// the first's 50 usec, to the usec, and the first never waits
+static void test_wake(void) {
+    int late_id ;
+
+    reset(0) ;
+    cost[0] = 50 ;
+    cost[2] = 100 ;
+    input_id = pt_add_rate(protothread_input, INPUT_USEC, 0) ;
+    late_id = pt_add_rate(protothread_background, INPUT_USEC, 1) ;
+    run_for(SECOND) ;
+    check_stats(input_id, runs[0], 50, 0) ;
+    check_stats(late_id, runs[2], 100, 50) ;
+    CHECK(pt_get_stats(0, late_id)->wake_max == 50) ;
+    CHECK(pt_get_stats(0, late_id)->wake_hist[6] == runs[2]) ;
+    CHECK(pt_get_stats(0, input_id)->wake_hist[0] == runs[0]) ;
+}
+#endif
+
+// 100 runs a second on a 10 msec interval: starting an hour after boot,
+// where the never-set marker is more than 2^31 usec behind, then jumping
+// to just short of the wrap and running across it
+static void test_interval(void) {
+    reset(0x90000000u) ;
+    pt_add(protothread_interval) ;
+    run_for(SECOND) ;
+    printf("interval: %u runs from a stale marker", runs[0]) ;
+    CHECK(runs[0] >= 99 && runs[0] <= 101) ;
+
+    runs[0] = 0 ;
+    host_timer.timerawl = 0xffffffffu - SECOND / 2 ;
+    run_for(SECOND) ;
+    printf(", %u across the wrap\n", runs[0]) ;
+    CHECK(runs[0] >= 99 && runs[0] <= 101) ;
+}
+
+int main(void) {
+    pt_sched_method = SCHED_RATE ;
+    test_rates(0) ;
+    test_rates(0xffffffffu - SECOND / 2) ;
+    test_overload() ;
+    test_idle() ;
+#ifdef PT_STATS
+    test_wake() ;
+#endif
+    test_interval() ;
+    return CHECK_DONE() ;
+}
@@ -0,0 +1,117 @@
+/**
+ * 320x240 scanout: the line interrupt queues every buffer row twice, in
+ * order, from the page on screen; a flip asked for anywhere in a frame
+ * latches only where line 0 is queued, so no frame mixes two pages; and
+ * the primitives draw into the page that is not on screen
+ */
+
+#include <string.h>
+#include "host.h"
+#include "vga_graphics.h"
+
+#ifdef VGA_PACKED
+#define ROW_BYTES (320/10*4)
+#else
+#define ROW_BYTES (320/2)
+#endif
+#define PAGE_BYTES (ROW_BYTES*240)
+
+// the line address channel 1 hands the DMA next, and the array it points in
+extern char *address_pointer ;
+extern char vga_data_array[] ;
+
+static unsigned int queued = 1 ;     // line address_pointer holds
+
+static char *page(int n) {
+    return vga_data_array + n*PAGE_BYTES ;
+}
+
+static char *line_address(int n, unsigned int line) {
+    return page(n) + ROW_BYTES*(line >> 1) ;
+}
+
+// One line finishes: the interrupt queues the line after the next
+static void line_irq(void) {
+    host_irq(DMA_IRQ_0) ;
+    queued = (queued + 1) % 480 ;
+}
+
+// Run to the end of the frame being queued; every line left in it comes
+// from page n, in order
+static void frame_from(int n) {
+    int wrong = 0 ;
+
+    do {
+        if (address_pointer != line_address(n, queued)) wrong++ ;
+        line_irq() ;
+    } while (queued != 0) ;
+    CHECK(wrong == 0) ;
+}
+
+static void test_sequence(void) {
+    // line 0 went out from the initial read address; line 1 is row 0 again
+    CHECK(address_pointer == line_address(0, 1)) ;
+    frame_from(0) ;
+    frame_from(0) ;
+    CHECK(!vga_flip_pending()) ;
+}
+
+static void test_flip(void) {
+    // asked for in the middle of a frame: the rest of it stays on page 0
+    while (queued != 200) line_irq() ;
+    vga_flip() ;
+    CHECK(vga_flip_pending()) ;
+    frame_from(0) ;
+    // and it has landed as line 0 was queued
+    CHECK(!vga_flip_pending()) ;
+    CHECK(address_pointer == line_address(1, 0)) ;
+    frame_from(1) ;
+
+    // asked for right after line 0 was queued: that line is already on
+    // page 1, so the whole frame is, and the flip waits for the next
+    line_irq() ;
+    CHECK(queued == 1) ;
+    vga_flip() ;
+    frame_from(1) ;
+    CHECK(!vga_flip_pending()) ;
+    frame_from(0) ;
+
+    // asked for with line 479 queued: the very next line is the boundary
+    while (queued != 479) line_irq() ;
+    vga_flip() ;
+    line_irq() ;
+    CHECK(!vga_flip_pending()) ;
+    frame_from(1) ;
+}
+
+// Page 1 is on screen after test_flip, so drawing goes into page 0
+static void test_draw(void) {
+    char before[PAGE_BYTES] ;
+
+    memcpy(before, page(1), PAGE_BYTES) ;
+    fillRect(0, 0, 320, 240, BLACK) ;
+    drawPixel(319, 239, WHITE) ;
+    CHECK(memcmp(before, page(1), PAGE_BYTES) == 0) ;
+    CHECK(page(0)[PAGE_BYTES - 1] != 0) ;
+    // pixels past the low-res screen are clipped, not written into page 1
+    drawPixel(320, 0, WHITE) ;
+    drawPixel(0, 240, WHITE) ;
+    CHECK(memcmp(before, page(1), PAGE_BYTES) == 0) ;
+
+    vga_flip() ;
+    frame_from(1) ;
+    CHECK(address_pointer == line_address(0, 0)) ;
+    // the last row goes out twice, both times holding the pixel
+    while (queued != 478) line_irq() ;
+    CHECK(address_pointer[ROW_BYTES - 1] != 0) ;
+    line_irq() ;
+    CHECK(address_pointer[ROW_BYTES - 1] != 0) ;
+}
+
+int main(void) {
+    initVGAMode(VGA_320x240) ;
+    test_sequence() ;
+    test_flip() ;
+    test_draw() ;
+    return CHECK_DONE() ;
+}
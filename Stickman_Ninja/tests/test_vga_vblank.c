@@ -0,0 +1,95 @@
+/**
+ * Vertical blank timing with a 60 Hz stand-in for the vsync machine: the
+ * blanking window opens a line after the interrupt (which comes as the
+ * last active line starts), and a loop that draws after vga_wait_vblank
+ * always lands inside it, once per frame
+ */
+
+#include "host.h"
+#include "hardware/pio.h"
+#include "vga_graphics.h"
+
+#define FRAME_USEC   16667      // 60 Hz
+#define LINE_USEC    32
+#define WINDOW_USEC  (44 * LINE_USEC)
+
+static unsigned int next_vblank ;
+static int callbacks ;
+
+static void vblank(void) {
+    callbacks++ ;
+}
+
+// The vsync machine's irq 2: raise it at the next frame's time
+static void fire_vblank(void) {
+    host_timer.timerawl = next_vblank ;
+    next_vblank += FRAME_USEC ;
+    host_irq(PIO0_IRQ_0) ;
+}
+
+static void test_window(void) {
+    unsigned int t ;
+
+    next_vblank = 100000 ;
+    fire_vblank() ;
+    t = host_timer.timerawl ;
+    CHECK(vga_frame_count() == 1 && callbacks == 1) ;
+    CHECK(pio0->irq == 1u << 2) ;
+
+    // the last active line is still going out
+    CHECK(vga_vblank_usec_left() == 0) ;
+    host_timer.timerawl = t + LINE_USEC - 1 ;
+    CHECK(vga_vblank_usec_left() == 0) ;
+    // then 44 lines of blanking
+    host_timer.timerawl = t + LINE_USEC ;
+    CHECK(vga_vblank_usec_left() == WINDOW_USEC) ;
+    host_timer.timerawl = t + LINE_USEC + WINDOW_USEC - 1 ;
+    CHECK(vga_vblank_usec_left() == 1) ;
+    host_timer.timerawl = t + LINE_USEC + WINDOW_USEC ;
+    CHECK(vga_vblank_usec_left() == 0) ;
+    host_timer.timerawl = t + FRAME_USEC / 2 ;
+    CHECK(vga_vblank_usec_left() == 0) ;
+
+    // waiting right after the interrupt spins out the last line only
+    host_timer.timerawl = t + 5 ;
+    vga_wait_vblank() ;
+    CHECK(host_timer.timerawl == t + LINE_USEC) ;
+    CHECK(vga_frame_count() == 1) ;
+    // inside the window it doesn't wait at all
+    host_timer.timerawl = t + 500 ;
+    vga_wait_vblank() ;
+    CHECK(host_timer.timerawl == t + 500) ;
+}
+
+// A second of frames: each wait from the middle of the frame sleeps to the
+// next vblank, and the "drawing" that follows is inside the window
+static void test_60hz(void) {
+    unsigned int start, frame, in_window = 0 ;
+
+    host_wfe_hook = fire_vblank ;
+    host_timer.timerawl = next_vblank - FRAME_USEC / 2 ;
+    start = next_vblank ;
+    frame = vga_frame_count() ;
+    for (int i = 0; i < 60; i++) {
+        vga_wait_vblank() ;
+        if (vga_vblank_usec_left() > 0 && vga_vblank_usec_left() <= WINDOW_USEC) in_window++ ;
+        CHECK(vga_frame_count() == frame + i + 1) ;
+        // a redraw that fits the window, then the rest of the frame's work
+        host_timer.timerawl += 1000 ;
+        CHECK(vga_vblank_usec_left() > 0) ;
+        host_timer.timerawl += 5000 ;
+    }
+    host_wfe_hook = 0 ;
+    CHECK(in_window == 60) ;
+    CHECK(callbacks == 61) ;
+    CHECK(host_timer.timerawl - start == 59 * FRAME_USEC + LINE_USEC + 6000) ;
+}
+
+int main(void) {
+    initVGA() ;
+    CHECK(host_irq_handler[PIO0_IRQ_0] != 0) ;
+    vga_set_vblank_callback(vblank) ;
+    test_window() ;
+    test_60hz() ;
+    return CHECK_DONE() ;
+}
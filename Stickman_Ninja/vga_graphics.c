@@ -1,554 +1,1537 @@
-#include <stdio.h>
-#include <stdlib.h>
-#include "pico/stdlib.h"
-#include "hardware/pio.h"
-#include "hardware/dma.h"
-// Our assembled programs:
-// Each gets the name <pio_filename.pio.h>
-#include "hsync.pio.h"
-#include "vsync.pio.h"
-#include "rgb.pio.h"
-// Header file
-#include "vga_graphics.h"
-// Font file
-#include "glcdfont.c"
-
-// VGA timing constants
-#define H_ACTIVE   655    // (active + frontporch - 1) - one cycle delay for mov
-#define V_ACTIVE   479    // (active - 1)
-#define RGB_ACTIVE 319    // (horizontal active)/2 - 1
-// #define RGB_ACTIVE 639 // change to this if 1 pixel/byte
-
-// Length of the pixel array, and number of DMA transfers
-#define TXCOUNT 153600 // Total pixels/2 (since we have 2 pixels per byte)
-
-// Pixel color array that is DMA's to the PIO machines and
-// a pointer to the ADDRESS of this color array.
-// Note that this array is automatically initialized to all 0's (black)
-unsigned char vga_data_array[TXCOUNT];
-char * address_pointer = &vga_data_array[0] ;
-
-// Bit masks for drawPixel routine
-#define TOPMASK 0b11000111
-#define BOTTOMMASK 0b11111000
-
-// For drawLine
-#define swap(a, b) { short t = a; a = b; b = t; }
-
-// For writing text
-#define tabspace 4 // number of spaces for a tab
-
-// For accessing the font library
-#define pgm_read_byte(addr) (*(const unsigned char *)(addr))
-
-// For drawing characters
-unsigned short cursor_y, cursor_x, textsize ;
-char textcolor, textbgcolor, wrap;
-
-// Screen width/height
-#define _width 640
-#define _height 480
-
-void initVGA() {
-        // Choose which PIO instance to use (there are two instances, each with 4 state machines)
-    PIO pio = pio0;
-
-    // Our assembled program needs to be loaded into this PIO's instruction
-    // memory. This SDK function will find a location (offset) in the
-    // instruction memory where there is enough space for our program. We need
-    // to remember these locations!
-    //
-    // We only have 32 instructions to spend! If the PIO programs contain more than
-    // 32 instructions, then an error message will get thrown at these lines of code.
-    //
-    // The program name comes from the .program part of the pio file
-    // and is of the form <program name_program>
-    uint hsync_offset = pio_add_program(pio, &hsync_program);
-    uint vsync_offset = pio_add_program(pio, &vsync_program);
-    uint rgb_offset = pio_add_program(pio, &rgb_program);
-
-    // Manually select a few state machines from pio instance pio0.
-    uint hsync_sm = 0;
-    uint vsync_sm = 1;
-    uint rgb_sm = 2;
-
-    // Call the initialization functions that are defined within each PIO file.
-    // Why not create these programs here? By putting the initialization function in
-    // the pio file, then all information about how to use/setup that state machine
-    // is consolidated in one place. Here in the C, we then just import and use it.
-    hsync_program_init(pio, hsync_sm, hsync_offset, HSYNC);
-    vsync_program_init(pio, vsync_sm, vsync_offset, VSYNC);
-    rgb_program_init(pio, rgb_sm, rgb_offset, RED_PIN);
-
-
-    /////////////////////////////////////////////////////////////////////////////////////////////////////
-    // ============================== PIO DMA Channels =================================================
-    /////////////////////////////////////////////////////////////////////////////////////////////////////
-
-    // DMA channels - 0 sends color data, 1 reconfigures and restarts 0
-    int rgb_chan_0 = 0;
-    int rgb_chan_1 = 1;
-
-    // Channel Zero (sends color data to PIO VGA machine)
-    dma_channel_config c0 = dma_channel_get_default_config(rgb_chan_0);  // default configs
-    channel_config_set_transfer_data_size(&c0, DMA_SIZE_8);              // 8-bit txfers
-    channel_config_set_read_increment(&c0, true);                        // yes read incrementing
-    channel_config_set_write_increment(&c0, false);                      // no write incrementing
-    channel_config_set_dreq(&c0, DREQ_PIO0_TX2) ;                        // DREQ_PIO0_TX2 pacing (FIFO)
-    channel_config_set_chain_to(&c0, rgb_chan_1);                        // chain to other channel
-
-    dma_channel_configure(
-        rgb_chan_0,                 // Channel to be configured
-        &c0,                        // The configuration we just created
-        &pio->txf[rgb_sm],          // write address (RGB PIO TX FIFO)
-        &vga_data_array,            // The initial read address (pixel color array)
-        TXCOUNT,                    // Number of transfers; in this case each is 1 byte.
-        false                       // Don't start immediately.
-    );
-
-    // Channel One (reconfigures the first channel)
-    dma_channel_config c1 = dma_channel_get_default_config(rgb_chan_1);   // default configs
-    channel_config_set_transfer_data_size(&c1, DMA_SIZE_32);              // 32-bit txfers
-    channel_config_set_read_increment(&c1, false);                        // no read incrementing
-    channel_config_set_write_increment(&c1, false);                       // no write incrementing
-    channel_config_set_chain_to(&c1, rgb_chan_0);                         // chain to other channel
-
-    dma_channel_configure(
-        rgb_chan_1,                         // Channel to be configured
-        &c1,                                // The configuration we just created
-        &dma_hw->ch[rgb_chan_0].read_addr,  // Write address (channel 0 read address)
-        &address_pointer,                   // Read address (POINTER TO AN ADDRESS)
-        1,                                  // Number of transfers, in this case each is 4 byte
-        false                               // Don't start immediately.
-    );
-
-    /////////////////////////////////////////////////////////////////////////////////////////////////////
-    /////////////////////////////////////////////////////////////////////////////////////////////////////
-
-    // Initialize PIO state machine counters. This passes the information to the state machines
-    // that they retrieve in the first 'pull' instructions, before the .wrap_target directive
-    // in the assembly. Each uses these values to initialize some counting registers.
-    pio_sm_put_blocking(pio, hsync_sm, H_ACTIVE);
-    pio_sm_put_blocking(pio, vsync_sm, V_ACTIVE);
-    pio_sm_put_blocking(pio, rgb_sm, RGB_ACTIVE);
-
-
-    // Start the two pio machine IN SYNC
-    // Note that the RGB state machine is running at full speed,
-    // so synchronization doesn't matter for that one. But, we'll
-    // start them all simultaneously anyway.
-    pio_enable_sm_mask_in_sync(pio, ((1u << hsync_sm) | (1u << vsync_sm) | (1u << rgb_sm)));
-
-    // Start DMA channel 0. Once started, the contents of the pixel color array
-    // will be continously DMA's to the PIO machines that are driving the screen.
-    // To change the contents of the screen, we need only change the contents
-    // of that array.
-    dma_start_channel_mask((1u << rgb_chan_0)) ;
-}
-
-
-// A function for drawing a pixel with a specified color.
-// Note that because information is passed to the PIO state machines through
-// a DMA channel, we only need to modify the contents of the array and the
-// pixels will be automatically updated on the screen.
-void drawPixel(short x, short y, char color) {
-    // Range checks (640x480 display)
-    if (x > 639) x = 639 ;
-    if (x < 0) x = 0 ;
-    if (y < 0) y = 0 ;
-    if (y > 479) y = 479 ;
-
-    // Which pixel is it?
-    int pixel = ((640 * y) + x) ;
-
-    // Is this pixel stored in the first 3 bits
-    // of the vga data array index, or the second
-    // 3 bits? Check, then mask.
-    if (pixel & 1) {
-        vga_data_array[pixel>>1] = (vga_data_array[pixel>>1] & TOPMASK) | (color << 3) ;
-    }
-    else {
-        vga_data_array[pixel>>1] = (vga_data_array[pixel>>1] & BOTTOMMASK) | (color) ;
-    }
-}
-
-void drawVLine(short x, short y, short h, char color) {
-    for (short i=y; i<(y+h); i++) {
-        drawPixel(x, i, color) ;
-    }
-}
-
-void drawHLine(short x, short y, short w, char color) {
-    for (short i=x; i<(x+w); i++) {
-        drawPixel(i, y, color) ;
-    }
-}
-
-// Bresenham's algorithm - thx wikipedia and thx Bruce!
-void drawLine(short x0, short y0, short x1, short y1, char color) {
-/* Draw a straight line from (x0,y0) to (x1,y1) with given color
- * Parameters:
- *      x0: x-coordinate of starting point of line. The x-coordinate of
- *          the top-left of the screen is 0. It increases to the right.
- *      y0: y-coordinate of starting point of line. The y-coordinate of
- *          the top-left of the screen is 0. It increases to the bottom.
- *      x1: x-coordinate of ending point of line. The x-coordinate of
- *          the top-left of the screen is 0. It increases to the right.
- *      y1: y-coordinate of ending point of line. The y-coordinate of
- *          the top-left of the screen is 0. It increases to the bottom.
- *      color: 3-bit color value for line
- */
-      short steep = abs(y1 - y0) > abs(x1 - x0);
-      if (steep) {
-        swap(x0, y0);
-        swap(x1, y1);
-      }
-
-      if (x0 > x1) {
-        swap(x0, x1);
-        swap(y0, y1);
-      }
-
-      short dx, dy;
-      dx = x1 - x0;
-      dy = abs(y1 - y0);
-
-      short err = dx / 2;
-      short ystep;
-
-      if (y0 < y1) {
-        ystep = 1;
-      } else {
-        ystep = -1;
-      }
-
-      for (; x0<=x1; x0++) {
-        if (steep) {
-          drawPixel(y0, x0, color);
-        } else {
-          drawPixel(x0, y0, color);
-        }
-        err -= dy;
-        if (err < 0) {
-          y0 += ystep;
-          err += dx;
-        }
-      }
-}
-
-// Draw a rectangle
-void drawRect(short x, short y, short w, short h, char color) {
-/* Draw a rectangle outline with top left vertex (x,y), width w
- * and height h at given color
- * Parameters:
- *      x:  x-coordinate of top-left vertex. The x-coordinate of
- *          the top-left of the screen is 0. It increases to the right.
- *      y:  y-coordinate of top-left vertex. The y-coordinate of
- *          the top-left of the screen is 0. It increases to the bottom.
- *      w:  width of the rectangle
- *      h:  height of the rectangle
- *      color:  16-bit color of the rectangle outline
- * Returns: Nothing
- */
-  drawHLine(x, y, w, color);
-  drawHLine(x, y+h-1, w, color);
-  drawVLine(x, y, h, color);
-  drawVLine(x+w-1, y, h, color);
-}
-
-void drawCircle(short x0, short y0, short r, char color) {
-/* Draw a circle outline with center (x0,y0) and radius r, with given color
- * Parameters:
- *      x0: x-coordinate of center of circle. The top-left of the screen
- *          has x-coordinate 0 and increases to the right
- *      y0: y-coordinate of center of circle. The top-left of the screen
- *          has y-coordinate 0 and increases to the bottom
- *      r:  radius of circle
- *      color: 16-bit color value for the circle. Note that the circle
- *          isn't filled. So, this is the color of the outline of the circle
- * Returns: Nothing
- */
-  short f = 1 - r;
-  short ddF_x = 1;
-  short ddF_y = -2 * r;
-  short x = 0;
-  short y = r;
-
-  drawPixel(x0  , y0+r, color);
-  drawPixel(x0  , y0-r, color);
-  drawPixel(x0+r, y0  , color);
-  drawPixel(x0-r, y0  , color);
-
-  while (x<y) {
-    if (f >= 0) {
-      y--;
-      ddF_y += 2;
-      f += ddF_y;
-    }
-    x++;
-    ddF_x += 2;
-    f += ddF_x;
-
-    drawPixel(x0 + x, y0 + y, color);
-    drawPixel(x0 - x, y0 + y, color);
-    drawPixel(x0 + x, y0 - y, color);
-    drawPixel(x0 - x, y0 - y, color);
-    drawPixel(x0 + y, y0 + x, color);
-    drawPixel(x0 - y, y0 + x, color);
-    drawPixel(x0 + y, y0 - x, color);
-    drawPixel(x0 - y, y0 - x, color);
-  }
-}
-
-void drawCircleHelper( short x0, short y0, short r, unsigned char cornername, char color) {
-// Helper function for drawing circles and circular objects
-  short f     = 1 - r;
-  short ddF_x = 1;
-  short ddF_y = -2 * r;
-  short x     = 0;
-  short y     = r;
-
-  while (x<y) {
-    if (f >= 0) {
-      y--;
-      ddF_y += 2;
-      f     += ddF_y;
-    }
-    x++;
-    ddF_x += 2;
-    f     += ddF_x;
-    if (cornername & 0x4) {
-      drawPixel(x0 + x, y0 + y, color);
-      drawPixel(x0 + y, y0 + x, color);
-    }
-    if (cornername & 0x2) {
-      drawPixel(x0 + x, y0 - y, color);
-      drawPixel(x0 + y, y0 - x, color);
-    }
-    if (cornername & 0x8) {
-      drawPixel(x0 - y, y0 + x, color);
-      drawPixel(x0 - x, y0 + y, color);
-    }
-    if (cornername & 0x1) {
-      drawPixel(x0 - y, y0 - x, color);
-      drawPixel(x0 - x, y0 - y, color);
-    }
-  }
-}
-
-void fillCircle(short x0, short y0, short r, char color) {
-/* Draw a filled circle with center (x0,y0) and radius r, with given color
- * Parameters:
- *      x0: x-coordinate of center of circle. The top-left of the screen
- *          has x-coordinate 0 and increases to the right
- *      y0: y-coordinate of center of circle. The top-left of the screen
- *          has y-coordinate 0 and increases to the bottom
- *      r:  radius of circle
- *      color: 16-bit color value for the circle
- * Returns: Nothing
- */
-  drawVLine(x0, y0-r, 2*r+1, color);
-  fillCircleHelper(x0, y0, r, 3, 0, color);
-}
-
-void fillCircleHelper(short x0, short y0, short r, unsigned char cornername, short delta, char color) {
-// Helper function for drawing filled circles
-  short f     = 1 - r;
-  short ddF_x = 1;
-  short ddF_y = -2 * r;
-  short x     = 0;
-  short y     = r;
-
-  while (x<y) {
-    if (f >= 0) {
-      y--;
-      ddF_y += 2;
-      f     += ddF_y;
-    }
-    x++;
-    ddF_x += 2;
-    f     += ddF_x;
-
-    if (cornername & 0x1) {
-      drawVLine(x0+x, y0-y, 2*y+1+delta, color);
-      drawVLine(x0+y, y0-x, 2*x+1+delta, color);
-    }
-    if (cornername & 0x2) {
-      drawVLine(x0-x, y0-y, 2*y+1+delta, color);
-      drawVLine(x0-y, y0-x, 2*x+1+delta, color);
-    }
-  }
-}
-
-// Draw a rounded rectangle
-void drawRoundRect(short x, short y, short w, short h, short r, char color) {
-/* Draw a rounded rectangle outline with top left vertex (x,y), width w,
- * height h and radius of curvature r at given color
- * Parameters:
- *      x:  x-coordinate of top-left vertex. The x-coordinate of
- *          the top-left of the screen is 0. It increases to the right.
- *      y:  y-coordinate of top-left vertex. The y-coordinate of
- *          the top-left of the screen is 0. It increases to the bottom.
- *      w:  width of the rectangle
- *      h:  height of the rectangle
- *      color:  16-bit color of the rectangle outline
- * Returns: Nothing
- */
-  // smarter version
-  drawHLine(x+r  , y    , w-2*r, color); // Top
-  drawHLine(x+r  , y+h-1, w-2*r, color); // Bottom
-  drawVLine(x    , y+r  , h-2*r, color); // Left
-  drawVLine(x+w-1, y+r  , h-2*r, color); // Right
-  // draw four corners
-  drawCircleHelper(x+r    , y+r    , r, 1, color);
-  drawCircleHelper(x+w-r-1, y+r    , r, 2, color);
-  drawCircleHelper(x+w-r-1, y+h-r-1, r, 4, color);
-  drawCircleHelper(x+r    , y+h-r-1, r, 8, color);
-}
-
-// Fill a rounded rectangle
-void fillRoundRect(short x, short y, short w, short h, short r, char color) {
-  // smarter version
-  fillRect(x+r, y, w-2*r, h, color);
-
-  // draw four corners
-  fillCircleHelper(x+w-r-1, y+r, r, 1, h-2*r-1, color);
-  fillCircleHelper(x+r    , y+r, r, 2, h-2*r-1, color);
-}
-
-
-// fill a rectangle
-void fillRect(short x, short y, short w, short h, char color) {
-/* Draw a filled rectangle with starting top-left vertex (x,y),
- *  width w and height h with given color
- * Parameters:
- *      x:  x-coordinate of top-left vertex; top left of screen is x=0
- *              and x increases to the right
- *      y:  y-coordinate of top-left vertex; top left of screen is y=0
- *              and y increases to the bottom
- *      w:  width of rectangle
- *      h:  height of rectangle
- *      color:  3-bit color value
- * Returns:     Nothing
- */
-
-  // rudimentary clipping (drawChar w/big text requires this)
-  // if((x >= _width) || (y >= _height)) return;
-  // if((x + w - 1) >= _width)  w = _width  - x;
-  // if((y + h - 1) >= _height) h = _height - y;
-
-  // tft_setAddrWindow(x, y, x+w-1, y+h-1);
-
-  for(int i=x; i<(x+w); i++) {
-    for(int j=y; j<(y+h); j++) {
-        drawPixel(i, j, color);
-    }
-  }
-}
-
-// Draw a character
-void drawChar(short x, short y, unsigned char c, char color, char bg, unsigned char size) {
-    char i, j;
-  if((x >= _width)            || // Clip right
-     (y >= _height)           || // Clip bottom
-     ((x + 6 * size - 1) < 0) || // Clip left
-     ((y + 8 * size - 1) < 0))   // Clip top
-    return;
-
-  for (i=0; i<6; i++ ) {
-    unsigned char line;
-    if (i == 5)
-      line = 0x0;
-    else
-      line = pgm_read_byte(font+(c*5)+i);
-    for ( j = 0; j<8; j++) {
-      if (line & 0x1) {
-        if (size == 1) // default size
-          drawPixel(x+i, y+j, color);
-        else {  // big size
-          fillRect(x+(i*size), y+(j*size), size, size, color);
-        }
-      } else if (bg != color) {
-        if (size == 1) // default size
-          drawPixel(x+i, y+j, bg);
-        else {  // big size
-          fillRect(x+i*size, y+j*size, size, size, bg);
-        }
-      }
-      line >>= 1;
-    }
-  }
-}
-
-
-inline void setCursor(short x, short y) {
-/* Set cursor for text to be printed
- * Parameters:
- *      x = x-coordinate of top-left of text starting
- *      y = y-coordinate of top-left of text starting
- * Returns: Nothing
- */
-  cursor_x = x;
-  cursor_y = y;
-}
-
-inline void setTextSize(unsigned char s) {
-/*Set size of text to be displayed
- * Parameters:
- *      s = text size (1 being smallest)
- * Returns: nothing
- */
-  textsize = (s > 0) ? s : 1;
-}
-
-inline void setTextColor(char c) {
-  // For 'transparent' background, we'll set the bg
-  // to the same as fg instead of using a flag
-  textcolor = textbgcolor = c;
-}
-
-inline void setTextColor2(char c, char b) {
-/* Set color of text to be displayed
- * Parameters:
- *      c = 16-bit color of text
- *      b = 16-bit color of text background
- */
-  textcolor   = c;
-  textbgcolor = b;
-}
-
-inline void setTextWrap(char w) {
-  wrap = w;
-}
-
-
-void tft_write(unsigned char c){
-  if (c == '\n') {
-    cursor_y += textsize*8;
-    cursor_x  = 0;
-  } else if (c == '\r') {
-    // skip em
-  } else if (c == '\t'){
-      int new_x = cursor_x + tabspace;
-      if (new_x < _width){
-          cursor_x = new_x;
-      }
-  } else {
-    drawChar(cursor_x, cursor_y, c, textcolor, textbgcolor, textsize);
-    cursor_x += textsize*6;
-    if (wrap && (cursor_x > (_width - textsize*6))) {
-      cursor_y += textsize*8;
-      cursor_x = 0;
-    }
-  }
-}
-
-inline void writeString(char* str){
-/* Print text onto screen
- * Call tft_setCursor(), tft_setTextColor(), tft_setTextSize()
- *  as necessary before printing
- */
-    while (*str){
-        tft_write(*str++);
-    }
-}
\ No newline at end of file
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/pio.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+// Our assembled programs:
+// Each gets the name <pio_filename.pio.h>
+#include "hsync.pio.h"
+#include "vsync.pio.h"
+#include "rgb.pio.h"
+// Header file
+#include "vga_graphics.h"
+// Font file
+#include "glcdfont.c"
+
+// VGA timing constants
+#define H_ACTIVE   655    // (active + frontporch - 1) - one cycle delay for mov
+#define V_ACTIVE   479    // (active - 1)
+#ifdef VGA_PACKED
+#define RGB_ACTIVE(w) ((w) - 1)     // (horizontal active) - 1, one pixel per loop
+#else
+#define RGB_ACTIVE(w) ((w)/2 - 1)   // (horizontal active)/2 - 1
+#endif
+
+// Vertical blanking: 10 front porch + 2 sync + 32 back porch lines of 32 us.
+// The vsync machine raises its irq as the last active line starts, so
+// the safe window opens one line after the interrupt and lasts VBLANK_USEC.
+#define LINE_USEC    32
+#define VBLANK_LINES 44
+#define VBLANK_USEC  (LINE_USEC * VBLANK_LINES)
+
+// Framebuffer layout. Each pixel is a 3-bit field of a storage unit:
+//  - default:    unsigned char, 2 pixels in bits 0-5 (bits 6-7 unused)
+//  - VGA_PACKED: unsigned int, 10 pixels in bits 0-29 (bits 30-31 unused)
+// Pixel x of a row lives in unit x/PIXELS_PER_UNIT, at bit 3*(x%PIXELS_PER_UNIT).
+#ifdef VGA_PACKED
+typedef unsigned int vga_unit ;
+#define PIXELS_PER_UNIT 10
+#define FILL_REPEAT 0x09249249    // 0b001 in each of the ten fields
+#else
+typedef unsigned char vga_unit ;
+#define PIXELS_PER_UNIT 2
+#define FILL_REPEAT 0x09          // 0b001 in each of the two fields
+#endif
+#define UNITS_PER_ROW (640/PIXELS_PER_UNIT)  // in a full-resolution row
+#define UNIT_INDEX(x)  ((unsigned)(x) / PIXELS_PER_UNIT)
+#define PIXEL_SHIFT(x) (3 * ((unsigned)(x) % PIXELS_PER_UNIT))
+#define UNIT_SHIFTS    (3 * PIXELS_PER_UNIT)
+
+// A color in the field for pixel x, and a color in every field of a unit
+#define PIXEL_BITS(x, color) ((vga_unit)((color) & 0x7) << PIXEL_SHIFT(x))
+#define FILL(color) ((vga_unit)(((color) & 0x7) * FILL_REPEAT))
+
+// Length of the pixel array, and number of DMA transfers
+#define TXCOUNT (UNITS_PER_ROW*480) // 153600 bytes, or 30720 packed words
+#define TXWORDS (TXCOUNT*sizeof(vga_unit)/4) // DMA moves the array 4 bytes at a time
+#define ROWWORDS(units) ((units)*sizeof(vga_unit)/4) // transfers per low-res line
+
+// DMA channels - 0 sends color data, 1 reconfigures and restarts 0
+#define rgb_chan_0 0
+#define rgb_chan_1 1
+
+#ifndef VGA_SCANLINE
+
+// Pixel color array that is DMA's to the PIO machines and
+// a pointer to the ADDRESS of this color array.
+// Note that this array is automatically initialized to all 0's (black).
+// It is word aligned for the 32-bit DMA transfers.
+vga_unit vga_data_array[TXCOUNT] __attribute__((aligned(4)));
+char * address_pointer = (char *)&vga_data_array[0] ;
+
+// Current mode, and the buffer the primitives draw into. In 640x480 that is
+// the whole array. In 320x240 the array holds two 38.4 kByte pages (30.72
+// packed), and the primitives draw into whichever one is not on screen.
+static char vga_mode = VGA_640x480 ;
+static vga_unit *draw_buffer = vga_data_array ;
+static short row_units = UNITS_PER_ROW ;
+
+// Low-res scanout state, kept by vga_line_irq. front_buffer is on screen,
+// flip_buffer is waiting to replace it at the next frame boundary.
+static vga_unit *front_buffer = vga_data_array ;
+static vga_unit * volatile flip_buffer = 0 ;
+
+#else
+
+// Scanline backend: there is no framebuffer. Each primitive is cut into
+// horizontal spans as it is drawn, and the spans are filed by row in a
+// display list. A character or a sprite from the pool is one entry per
+// row, holding its font bits or pointing at its runs. vga_line_irq
+// paints rows into a small ring of line buffers a couple of lines ahead
+// of the DMA. It runs in the DMA interrupt on the core that called
+// initVGA (core 0 in the game), so the rasterizing comes out of that
+// core's threads: up to a line time, 480 times a frame. One list is
+// being built while the other is on screen; vga_flip() swaps them at the
+// next frame boundary.
+#define LINE_RING 4                 // line buffers (480 must be a multiple)
+#define LINE_BUDGET_USEC 25         // one active line is 25.4 us
+#define DL_SPANS 2048               // spans per display list
+#define DL_END 0xffff
+
+struct dl_span {
+    short x0, x1 ;                  // pixels [x0, x1)
+    unsigned short next ;           // next span on the same row, or DL_END
+    char color ;                    // see kind
+    unsigned char kind ;            // DL_SPAN, DL_GLYPH or DL_SPRITE
+} ;
+// A plain span: pixels [x0, x1) in color
+#define DL_SPAN   0
+// One row of a character: x0, x1 as the span, color = ink | background << 3,
+// and kind has bit i set when column i is ink
+#define DL_GLYPH  0x80
+// One row of a sprite: x0 is the sprite's left, x1 the row's first run in
+// sprite_pool, color = color | number of runs << 3
+#define DL_SPRITE 0x40
+#define DL_SPRITE_RUNS 31
+struct display_list {
+    unsigned short head[480], tail[480] ;
+    unsigned short count ;
+    struct dl_span spans[DL_SPANS] ;
+} ;
+
+static struct display_list display_lists[2] ;
+static struct display_list *build_list = &display_lists[0] ;
+static struct display_list *show_list = &display_lists[1] ;
+static struct display_list * volatile flip_list = 0 ;
+static struct scanline_stats scanline_stats ;
+
+// Line buffers that are DMA'd to the PIO machines, and the pointer channel 1
+// reloads channel 0 from
+static vga_unit line_ring[LINE_RING][UNITS_PER_ROW] __attribute__((aligned(4))) ;
+char * address_pointer = (char *)&line_ring[1][0] ;
+
+static const short row_units = UNITS_PER_ROW ;
+
+#endif
+
+// Line whose address is queued in address_pointer (line-at-a-time DMA)
+static short next_line = 1 ;
+
+// Frame counter and time of the last vertical blank, kept by vga_vblank_irq
+static volatile unsigned int vga_frames = 0 ;
+static volatile unsigned int vga_vblank_time = 0 ;
+// Called from the vblank interrupt, if set
+static void (*vblank_callback)(void) = 0 ;
+
+// Calls to the drawing primitives, for measuring how much a screen redraws
+static unsigned int draw_calls = 0 ;
+
+// For drawLine
+#define swap(a, b) { short t = a; a = b; b = t; }
+
+// Storage shared by all captured sprites (3 bytes per run)
+#define SPRITE_POOL_RUNS 2048
+static struct sprite_run sprite_pool[SPRITE_POOL_RUNS] ;
+static int sprite_pool_used = 0 ;
+
+// Dirty rectangles queued for the next clearDirty(). After a clear the
+// list holds what was cleared, until the next markDirty() starts over.
+#define MAX_DIRTY 16
+static struct vga_rect dirty_list[MAX_DIRTY] ;
+static int dirty_count = 0 ;
+static char dirty_cleared = 0 ;
+static struct dirty_stats dirty_stats ;
+
+// For writing text
+#define tabspace 4 // number of spaces for a tab
+
+#ifndef VGA_SCANLINE
+// Glyph cache. An opaque character (bg != color) is expanded once per size,
+// colors and pixel phase (x % PIXELS_PER_UNIT) into its 8 distinct rows of
+// framebuffer units. Drawing it is then a row copy, repeated size times per
+// font row. When the pool or the table fills up, the whole cache is dropped.
+#define GLYPH_CACHE_BYTES   4096
+#define GLYPH_CACHE_ENTRIES 64
+#define GLYPH_POOL_UNITS    ((int) (GLYPH_CACHE_BYTES/sizeof(vga_unit)))
+struct glyph_entry {
+    unsigned int key ;              // char, size, colors and phase
+    unsigned short offset ;         // first unit in glyph_pool
+    unsigned short units ;          // units per row
+} ;
+static vga_unit glyph_pool[GLYPH_POOL_UNITS] ;
+static struct glyph_entry glyph_table[GLYPH_CACHE_ENTRIES] ;
+static int glyph_count = 0 ;
+static int glyph_pool_used = 0 ;
+static struct glyph_stats glyph_stats ;
+#endif
+
+// For accessing the font library
+#define pgm_read_byte(addr) (*(const unsigned char *)(addr))
+
+// For drawing characters
+unsigned short cursor_y, cursor_x, textsize ;
+char textcolor, textbgcolor, wrap;
+
+// Screen width/height (set by initVGAMode)
+static short _width = 640 ;
+static short _height = 480 ;
+
+// PIO0 irq flag 2 is raised by the vsync machine once per frame
+static void vga_vblank_irq() {
+    pio_interrupt_clear(pio0, 2) ;
+    vga_vblank_time = timer_hw->timerawl ;
+    vga_frames++ ;
+    if (vblank_callback) vblank_callback() ;
+    // Wake up anything sleeping in vga_wait_vblank, on either core
+    __sev() ;
+}
+
+// In 320x240, DMA channel 0 sends one line at a time and channel 1 reloads
+// its address from address_pointer. When a line finishes, the reload for the
+// following line has already happened, so queue the address of the one after
+// that. Each buffer row is sent twice, and a pending flip takes effect where
+// the first line of a frame is queued, so no frame mixes two pages.
+#ifndef VGA_SCANLINE
+static void vga_line_irq() {
+    dma_hw->ints0 = 1u << rgb_chan_0 ;
+    if (++next_line == 480) {
+        next_line = 0 ;
+        if (flip_buffer) {
+            front_buffer = flip_buffer ;
+            flip_buffer = 0 ;
+        }
+    }
+    address_pointer = (char *)&front_buffer[row_units*(next_line>>1)] ;
+}
+#else
+static void dlReset(struct display_list *dl) {
+    memset(dl->head, 0xff, sizeof(dl->head)) ;
+    dl->count = 0 ;
+}
+
+// File a new entry at the end of row y in the list being built, or
+// return 0 if the list is full. Entries paint in the order they were
+// added, so later drawing still covers earlier drawing like it does in
+// the framebuffer.
+static struct dl_span *dlAdd(short y) {
+    struct display_list *dl = build_list ;
+    if (dl->count >= DL_SPANS) {
+        scanline_stats.dropped_spans++ ;
+        return 0 ;
+    }
+    unsigned short i = dl->count++ ;
+    dl->spans[i].next = DL_END ;
+    if (dl->head[y] == DL_END) dl->head[y] = i ;
+    else dl->spans[dl->tail[y]].next = i ;
+    dl->tail[y] = i ;
+    return &dl->spans[i] ;
+}
+
+// Span [x0, x1) of row y. The caller clips.
+static void dlSpan(short y, int x0, int x1, char color) {
+    struct dl_span *s = dlAdd(y) ;
+    if (!s) return ;
+    s->x0 = x0 ;
+    s->x1 = x1 ;
+    s->color = color ;
+    s->kind = DL_SPAN ;
+}
+
+// One row of a character at x, size pixels per font pixel. bits has the
+// ink columns; bg == color leaves the rest alone. The caller clips y,
+// x is clipped when the row is painted.
+static void dlGlyph(short y, short x, unsigned char size, char color, char bg, unsigned char bits) {
+    struct dl_span *s = dlAdd(y) ;
+    if (!s) return ;
+    s->x0 = x ;
+    s->x1 = x + 6 * size ;
+    s->color = (color & 0x7) | ((bg & 0x7) << 3) ;
+    s->kind = DL_GLYPH | bits ;
+}
+
+// One row of a sprite at x: count runs from sprite_pool[first] on. The
+// caller clips y, x is clipped when the row is painted.
+static void dlSprite(short y, short x, int first, int count, char color) {
+    struct dl_span *s = dlAdd(y) ;
+    if (!s) return ;
+    s->x0 = x ;
+    s->x1 = first ;
+    s->color = (char)((color & 0x7) | (count << 3)) ;
+    s->kind = DL_SPRITE ;
+}
+
+static inline void fillSpan(vga_unit *row, int x0, int x1, vga_unit fill) ;
+static inline void fillUnits(vga_unit *p, vga_unit fill, int n) ;
+
+// Paint one row of a character: size pixels of ink or background per
+// column, clipped to the line
+static void renderGlyph(vga_unit *line, const struct dl_span *s) {
+    int size = (s->x1 - s->x0) / 6 ;
+    char color = s->color & 0x7, bg = (s->color >> 3) & 0x7 ;
+    for (int i=0; i<6; i++) {
+        char ink = (s->kind >> i) & 1 ;
+        if (!ink && (bg == color)) continue ;
+        int a = s->x0 + i * size, b = a + size ;
+        if (a < 0) a = 0 ;
+        if (b > 640) b = 640 ;
+        if (a < b) fillSpan(line, a, b, FILL(ink ? color : bg)) ;
+    }
+}
+
+// Paint one row of a sprite, clipped to the line
+static void renderSprite(vga_unit *line, const struct dl_span *s) {
+    const struct sprite_run *r = &sprite_pool[s->x1] ;
+    int count = (unsigned char)s->color >> 3 ;
+    vga_unit fill = FILL(s->color) ;
+    for (; count > 0; count--, r++) {
+        int a = s->x0 + r->x, b = a + r->len ;
+        if (a < 0) a = 0 ;
+        if (b > 640) b = 640 ;
+        if (a < b) fillSpan(line, a, b, fill) ;
+    }
+}
+
+// Paint row y of a display list into a line buffer. Returns the number
+// of entries painted
+static int renderLine(vga_unit *line, const struct display_list *dl, int y) {
+    int n = 0 ;
+    fillUnits(line, 0, UNITS_PER_ROW) ;
+    for (unsigned short i = dl->head[y]; i != DL_END; i = dl->spans[i].next, n++) {
+        const struct dl_span *s = &dl->spans[i] ;
+        if (s->kind == DL_SPAN) fillSpan(line, s->x0, s->x1, FILL(s->color)) ;
+        else if (s->kind == DL_SPRITE) renderSprite(line, s) ;
+        else renderGlyph(line, s) ;
+    }
+    return n ;
+}
+
+// Every line, DMA channel 0 sends one line buffer and channel 1 reloads it
+// from address_pointer. When line L finishes, line L+1 is already going out:
+// queue line L+2, and reuse L's buffer for line L+LINE_RING. A pending
+// display list takes over when the first line of a frame is painted.
+static void vga_line_irq() {
+    dma_hw->ints0 = 1u << rgb_chan_0 ;
+    unsigned int start = timer_hw->timerawl ;
+
+    if (++next_line == 480) next_line = 0 ;
+    address_pointer = (char *)line_ring[next_line % LINE_RING] ;
+
+    int y = next_line + LINE_RING - 2 ;
+    if (y >= 480) y -= 480 ;
+    if ((y == 0) && flip_list) {
+        dlReset(show_list) ;
+        show_list = flip_list ;
+        flip_list = 0 ;
+        if (show_list->count > scanline_stats.max_spans) scanline_stats.max_spans = show_list->count ;
+    }
+    unsigned int spans = renderLine(line_ring[y % LINE_RING], show_list, y) ;
+    if (spans > scanline_stats.max_line_spans) scanline_stats.max_line_spans = spans ;
+
+    unsigned int usec = timer_hw->timerawl - start ;
+    scanline_stats.last_usec = usec ;
+    if (usec > scanline_stats.max_usec) scanline_stats.max_usec = usec ;
+    if (usec > LINE_BUDGET_USEC) scanline_stats.late_lines++ ;
+}
+#endif
+
+void initVGA() {
+    initVGAMode(VGA_640x480) ;
+}
+
+void initVGAMode(char mode) {
+/* Start the VGA driver
+ * Parameters:
+ *      mode: VGA_640x480 (single buffer, drawn while on screen), or
+ *            VGA_320x240 (each pixel doubled in x and y, two pages;
+ *            draw off-screen, then vga_flip())
+ */
+#ifndef VGA_SCANLINE
+    vga_mode = mode ;
+    if (mode == VGA_320x240) {
+        _width = 320 ;
+        _height = 240 ;
+        row_units = 320/PIXELS_PER_UNIT ;
+        front_buffer = vga_data_array ;
+        draw_buffer = &vga_data_array[row_units*240] ;
+        address_pointer = (char *)front_buffer ;
+        next_line = 1 ;
+    }
+    char line_dma = (mode == VGA_320x240) ;
+    vga_unit *first_line = front_buffer ;
+#else
+    // The scanline backend only does 640x480. Start with both lists empty
+    // and the first lines of the ring painted (black).
+    mode = VGA_640x480 ;
+    dlReset(&display_lists[0]) ;
+    dlReset(&display_lists[1]) ;
+    for (int y=0; y<LINE_RING; y++) renderLine(line_ring[y], show_list, y) ;
+    next_line = 1 ;
+    char line_dma = 1 ;
+    vga_unit *first_line = line_ring[0] ;
+#endif
+        // Choose which PIO instance to use (there are two instances, each with 4 state machines)
+    PIO pio = pio0;
+
+    // Our assembled program needs to be loaded into this PIO's instruction
+    // memory. This SDK function will find a location (offset) in the
+    // instruction memory where there is enough space for our program. We need
+    // to remember these locations!
+    //
+    // We only have 32 instructions to spend! If the PIO programs contain more than
+    // 32 instructions, then an error message will get thrown at these lines of code.
+    //
+    // The program name comes from the .program part of the pio file
+    // and is of the form <program name_program>
+    uint hsync_offset = pio_add_program(pio, &hsync_program);
+    uint vsync_offset = pio_add_program(pio, &vsync_program);
+#ifdef VGA_PACKED
+    uint rgb_offset = pio_add_program(pio, &rgb_packed_program);
+#else
+    uint rgb_offset = pio_add_program(pio, &rgb_program);
+#endif
+
+    // Manually select a few state machines from pio instance pio0.
+    uint hsync_sm = 0;
+    uint vsync_sm = 1;
+    uint rgb_sm = 2;
+
+    // Call the initialization functions that are defined within each PIO file.
+    // Why not create these programs here? By putting the initialization function in
+    // the pio file, then all information about how to use/setup that state machine
+    // is consolidated in one place. Here in the C, we then just import and use it.
+    hsync_program_init(pio, hsync_sm, hsync_offset, HSYNC);
+    vsync_program_init(pio, vsync_sm, vsync_offset, VSYNC);
+#ifdef VGA_PACKED
+    rgb_packed_program_init(pio, rgb_sm, rgb_offset, RED_PIN);
+#else
+    rgb_program_init(pio, rgb_sm, rgb_offset, RED_PIN);
+#endif
+
+    // In 320x240 the RGB machine runs at half speed, so every pixel
+    // is held for two pixel clocks.
+    if (mode == VGA_320x240) {
+        pio_sm_set_clkdiv(pio, rgb_sm, 2) ;
+    }
+
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////////
+    // ============================== PIO DMA Channels =================================================
+    /////////////////////////////////////////////////////////////////////////////////////////////////////
+
+    // Channel Zero (sends color data to PIO VGA machine)
+    dma_channel_config c0 = dma_channel_get_default_config(rgb_chan_0);  // default configs
+    channel_config_set_transfer_data_size(&c0, DMA_SIZE_32);             // 32-bit txfers (4 bytes, 8 pixels)
+    channel_config_set_read_increment(&c0, true);                        // yes read incrementing
+    channel_config_set_write_increment(&c0, false);                      // no write incrementing
+    channel_config_set_dreq(&c0, DREQ_PIO0_TX2) ;                        // DREQ_PIO0_TX2 pacing (FIFO)
+    channel_config_set_chain_to(&c0, rgb_chan_1);                        // chain to other channel
+
+    // Whole frame per transfer block in 640x480, one line in 320x240
+    // (and in the scanline backend)
+    int dma_count = line_dma ? ROWWORDS(row_units) : TXWORDS ;
+
+    dma_channel_configure(
+        rgb_chan_0,                 // Channel to be configured
+        &c0,                        // The configuration we just created
+        &pio->txf[rgb_sm],          // write address (RGB PIO TX FIFO)
+        first_line,                 // The initial read address (pixel color array)
+        dma_count,                  // Number of transfers; in this case each is 4 bytes.
+        false                       // Don't start immediately.
+    );
+
+    // Channel One (reconfigures the first channel)
+    dma_channel_config c1 = dma_channel_get_default_config(rgb_chan_1);   // default configs
+    channel_config_set_transfer_data_size(&c1, DMA_SIZE_32);              // 32-bit txfers
+    channel_config_set_read_increment(&c1, false);                        // no read incrementing
+    channel_config_set_write_increment(&c1, false);                       // no write incrementing
+    channel_config_set_chain_to(&c1, rgb_chan_0);                         // chain to other channel
+
+    dma_channel_configure(
+        rgb_chan_1,                         // Channel to be configured
+        &c1,                                // The configuration we just created
+        &dma_hw->ch[rgb_chan_0].read_addr,  // Write address (channel 0 read address)
+        &address_pointer,                   // Read address (POINTER TO AN ADDRESS)
+        1,                                  // Number of transfers, in this case each is 4 byte
+        false                               // Don't start immediately.
+    );
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////////
+    /////////////////////////////////////////////////////////////////////////////////////////////////////
+
+    // Refill address_pointer after every line
+    if (line_dma) {
+        dma_channel_set_irq0_enabled(rgb_chan_0, true) ;
+        irq_set_exclusive_handler(DMA_IRQ_0, vga_line_irq) ;
+        irq_set_enabled(DMA_IRQ_0, true) ;
+    }
+
+    // The vsync machine sets irq flag 2 at the start of vertical blanking.
+    // Route it to PIO0_IRQ_0 on this core to keep the frame counter.
+    pio_set_irq0_source_enabled(pio, pis_interrupt2, true) ;
+    irq_set_exclusive_handler(PIO0_IRQ_0, vga_vblank_irq) ;
+    irq_set_enabled(PIO0_IRQ_0, true) ;
+
+    // Initialize PIO state machine counters. This passes the information to the state machines
+    // that they retrieve in the first 'pull' instructions, before the .wrap_target directive
+    // in the assembly. Each uses these values to initialize some counting registers.
+    pio_sm_put_blocking(pio, hsync_sm, H_ACTIVE);
+    pio_sm_put_blocking(pio, vsync_sm, V_ACTIVE);
+    pio_sm_put_blocking(pio, rgb_sm, RGB_ACTIVE(_width));
+
+
+    // Start the two pio machine IN SYNC
+    // Note that the RGB state machine is running at full speed,
+    // so synchronization doesn't matter for that one. But, we'll
+    // start them all simultaneously anyway.
+    pio_enable_sm_mask_in_sync(pio, ((1u << hsync_sm) | (1u << vsync_sm) | (1u << rgb_sm)));
+
+    // Start DMA channel 0. Once started, the contents of the pixel color array
+    // will be continously DMA's to the PIO machines that are driving the screen.
+    // To change the contents of the screen, we need only change the contents
+    // of that array.
+    dma_start_channel_mask((1u << rgb_chan_0)) ;
+}
+
+
+// Number of frames sent to the screen so far. A thread can pace itself
+// with PT_YIELD_UNTIL(pt, vga_frame_count() != last_frame).
+unsigned int vga_frame_count() {
+    return vga_frames ;
+}
+
+// Run callback at each vertical blank, from the interrupt (on the core that
+// called initVGA). Keep it short. NULL turns it off
+void vga_set_vblank_callback(void (*callback)(void)) {
+    vblank_callback = callback ;
+}
+
+// Show the page that was just drawn (320x240 only). The page swap happens at
+// the next frame boundary; until vga_flip_pending() goes false, the page the
+// primitives now draw into is still on screen, so wait before drawing.
+#ifndef VGA_SCANLINE
+void vga_flip() {
+    if (vga_mode != VGA_320x240) return ;
+    vga_unit *back = draw_buffer ;
+    draw_buffer = (back == vga_data_array) ? &vga_data_array[row_units*240] : vga_data_array ;
+    flip_buffer = back ;
+}
+
+char vga_flip_pending() {
+    return flip_buffer != 0 ;
+}
+#else
+// Scanline backend: show the display list built so far. The list that is
+// on screen now is emptied and becomes the one to build into, once the
+// flip lands (vga_flip_pending() goes false).
+void vga_flip() {
+    struct display_list *back = build_list ;
+    build_list = show_list ;
+    flip_list = back ;
+}
+
+char vga_flip_pending() {
+    return flip_list != 0 ;
+}
+
+const struct scanline_stats *getScanlineStats() {
+    return &scanline_stats ;
+}
+#endif
+
+// Number of primitive calls so far (pixels, lines, rects, chars, sprites).
+// Shapes built from other primitives count each piece.
+unsigned int vga_draw_calls() {
+    return draw_calls ;
+}
+
+// Wait until the blanking window is open. Returns at once if it is; just
+// after the vblank interrupt it spins out the last active line, otherwise
+// it sleeps until the next vertical blank.
+void vga_wait_vblank() {
+    unsigned int frame = vga_frames ;
+    if (timer_hw->timerawl - vga_vblank_time >= LINE_USEC + VBLANK_USEC) {
+        while (vga_frames == frame) {
+            __wfe() ;
+        }
+    }
+    while (timer_hw->timerawl - vga_vblank_time < LINE_USEC) {
+        tight_loop_contents() ;
+    }
+}
+
+// Microseconds left in the current blanking window (0 while the screen
+// is being drawn, including the last active line after the interrupt).
+// Anything drawn while this is non-zero won't tear.
+int vga_vblank_usec_left() {
+    unsigned int elapsed = timer_hw->timerawl - vga_vblank_time ;
+    if (elapsed < LINE_USEC) return 0 ;
+    elapsed -= LINE_USEC ;
+    return (elapsed < VBLANK_USEC) ? (VBLANK_USEC - elapsed) : 0 ;
+}
+
+// A function for drawing a pixel with a specified color.
+// Note that because information is passed to the PIO state machines through
+// a DMA channel, we only need to modify the contents of the array and the
+// pixels will be automatically updated on the screen.
+void drawPixel(short x, short y, char color) {
+    draw_calls++ ;
+    // Range checks. Off-screen pixels are dropped
+    // rather than clamped, so they don't smear onto the border.
+    if ((x < 0) || (x >= _width) || (y < 0) || (y >= _height)) return ;
+
+#ifdef VGA_SCANLINE
+    dlSpan(y, x, x + 1, color) ;
+#else
+    // Which unit holds this pixel? Mask out its old field, then or in the color.
+    vga_unit *p = &draw_buffer[row_units*y + UNIT_INDEX(x)] ;
+    *p = (*p & ~PIXEL_BITS(x, 0x7)) | PIXEL_BITS(x, color) ;
+#endif
+}
+
+// Store n copies of a replicated color unit
+static inline void fillUnits(vga_unit *p, vga_unit fill, int n) {
+#ifdef VGA_PACKED
+  while (n-- > 0) *p++ = fill ;
+#else
+  if (n > 0) memset(p, fill, n) ;
+#endif
+}
+
+// Fill pixels [x0, x1) of one row with a replicated color unit.
+// The partial units at either end are masked in, and the whole units
+// between them are written in one go.
+static inline void fillSpan(vga_unit *row, int x0, int x1, vga_unit fill) {
+  int u0 = UNIT_INDEX(x0), u1 = UNIT_INDEX(x1) ;
+  int s0 = PIXEL_SHIFT(x0), s1 = PIXEL_SHIFT(x1) ;
+  vga_unit head = (vga_unit)(~0u << s0) ;         // fields x0 and up
+  vga_unit tail = (vga_unit)((1u << s1) - 1) ;    // fields below x1
+  if (u0 == u1) {
+    row[u0] = (row[u0] & ~(head & tail)) | (fill & head & tail) ;
+    return ;
+  }
+  if (s0) {
+    row[u0] = (row[u0] & ~head) | (fill & head) ;
+    u0++ ;
+  }
+  if (s1) {
+    row[u1] = (row[u1] & ~tail) | (fill & tail) ;
+  }
+  fillUnits(&row[u0], fill, u1 - u0) ;
+}
+
+// Walk one column of pixels [y0, y1) at x, one row of units per step.
+// The column's field never changes, so the mask is picked once.
+static inline void fillColumn(short x, int y0, int y1, char color) {
+#ifdef VGA_SCANLINE
+  for (int j=y0; j<y1; j++) dlSpan(j, x, x + 1, color) ;
+#else
+  vga_unit *p = &draw_buffer[row_units*y0 + UNIT_INDEX(x)] ;
+  vga_unit mask = ~PIXEL_BITS(x, 0x7) ;
+  vga_unit bits = PIXEL_BITS(x, color) ;
+  for (int j=y0; j<y1; j++, p += row_units) {
+    *p = (*p & mask) | bits ;
+  }
+#endif
+}
+
+// Fill pixels [x0, x1) of row y, in the draw buffer or the display list
+static inline void fillRow(short y, int x0, int x1, char color) {
+#ifdef VGA_SCANLINE
+  dlSpan(y, x0, x1, color) ;
+#else
+  fillSpan(&draw_buffer[row_units*y], x0, x1, FILL(color)) ;
+#endif
+}
+
+// Vertical and horizontal lines are clipped once up front, then write
+// the array directly.
+void drawVLine(short x, short y, short h, char color) {
+  draw_calls++ ;
+  int y0 = y, y1 = y + h ;
+  if ((x < 0) || (x >= _width)) return ;
+  if (y0 < 0) y0 = 0 ;
+  if (y1 > _height) y1 = _height ;
+  if (y0 >= y1) return ;
+  fillColumn(x, y0, y1, color) ;
+}
+
+void drawHLine(short x, short y, short w, char color) {
+  draw_calls++ ;
+  int x0 = x, x1 = x + w ;
+  if ((y < 0) || (y >= _height)) return ;
+  if (x0 < 0) x0 = 0 ;
+  if (x1 > _width) x1 = _width ;
+  if (x0 >= x1) return ;
+  fillRow(y, x0, x1, color) ;
+}
+
+// Unchecked versions. The caller guarantees the whole line is on-screen.
+void drawVLine_fast(short x, short y, short h, char color) {
+  draw_calls++ ;
+  fillColumn(x, y, y + h, color) ;
+}
+
+void drawHLine_fast(short x, short y, short w, char color) {
+  draw_calls++ ;
+  fillRow(y, x, x + w, color) ;
+}
+
+// Cohen-Sutherland outcodes for the 640x480 viewport
+#define CLIP_LEFT   1
+#define CLIP_RIGHT  2
+#define CLIP_TOP    4
+#define CLIP_BOTTOM 8
+
+static inline char outCode(int x, int y) {
+  char code = 0 ;
+  if (x < 0) code |= CLIP_LEFT ;
+  else if (x >= _width) code |= CLIP_RIGHT ;
+  if (y < 0) code |= CLIP_TOP ;
+  else if (y >= _height) code |= CLIP_BOTTOM ;
+  return code ;
+}
+
+// Clip a Bresenham walk to the screen without moving any of its pixels.
+// The walk steps u (the major axis) from u0 to u1 and moves v (the
+// minor axis) by vstep each time err, which starts at du/2 and loses dv
+// a step, drops below zero. After k steps v has moved
+//     n(k) = ceil((k*dv - du/2) / du)
+// times, so the first and last steps with the pixel on screen (u in
+// [0, umax], v in [0, vmax]) come straight out of that. Skip to the
+// first, setting v and err to what the walk would have there, and pull
+// u1 back to the last. Returns 0 if no pixel is on screen.
+static char clipWalk(short *u0, short *v0, short *u1, int *err,
+                     int du, int dv, int vstep, int umax, int vmax) {
+  long long h = du / 2 ;
+  int first = 0, last = du ;
+  int nlo, nhi, n ;
+
+  // along u
+  if (*u0 < 0) first = -*u0 ;
+  if (*u1 > umax) last = umax - *u0 ;
+
+  // along v: the range of n(k) that keeps v on screen
+  nlo = (vstep > 0) ? -*v0 : *v0 - vmax ;
+  nhi = (vstep > 0) ? vmax - *v0 : *v0 ;
+  if (nhi < 0) return 0 ;
+  if (nlo > 0) {
+    if (dv == 0) return 0 ;
+    // first k with n(k) >= nlo
+    n = (int)(((nlo - 1) * (long long)du + h) / dv) + 1 ;
+    if (n > first) first = n ;
+  }
+  if (dv > 0) {
+    // last k with n(k) <= nhi
+    long long k = (nhi * (long long)du + h) / dv ;
+    if (k < last) last = (int)k ;
+  }
+  if (first > last) return 0 ;
+
+  n = ((long long)first * dv <= h) ? 0 : (int)(((long long)first * dv - h + du - 1) / du) ;
+  *err = (int)(h - (long long)first * dv + (long long)n * du) ;
+  *v0 += vstep * n ;
+  *u1 = *u0 + last ;
+  *u0 += first ;
+  return 1 ;
+}
+
+// Bresenham's algorithm - thx wikipedia and thx Bruce!
+void drawLine(short x0, short y0, short x1, short y1, char color) {
+/* Draw a straight line from (x0,y0) to (x1,y1) with given color
+ * Parameters:
+ *      x0: x-coordinate of starting point of line. The x-coordinate of
+ *          the top-left of the screen is 0. It increases to the right.
+ *      y0: y-coordinate of starting point of line. The y-coordinate of
+ *          the top-left of the screen is 0. It increases to the bottom.
+ *      x1: x-coordinate of ending point of line. The x-coordinate of
+ *          the top-left of the screen is 0. It increases to the right.
+ *      y1: y-coordinate of ending point of line. The y-coordinate of
+ *          the top-left of the screen is 0. It increases to the bottom.
+ *      color: 3-bit color value for line
+ *
+ * The walk is clipped to the screen once, keeping exactly the pixels the
+ * unclipped line has on screen. After that we walk a unit pointer into
+ * the draw buffer plus the bit offset of the pixel within the unit, so
+ * there are no per-pixel multiplies or range checks.
+ */
+      draw_calls++ ;
+      // Both ends off the same side: nothing to draw
+      char ca = outCode(x0, y0), cb = outCode(x1, y1) ;
+      if (ca & cb) return ;
+
+      short steep = abs(y1 - y0) > abs(x1 - x0);
+      if (steep) {
+        swap(x0, y0);
+        swap(x1, y1);
+      }
+
+      if (x0 > x1) {
+        swap(x0, x1);
+        swap(y0, y1);
+      }
+
+      int dx, dy;
+      dx = x1 - x0;
+      dy = abs(y1 - y0);
+
+      int err = dx / 2;
+      short ystep;
+
+      if (y0 < y1) {
+        ystep = 1;
+      } else {
+        ystep = -1;
+      }
+
+      if ((ca | cb) && !clipWalk(&x0, &y0, &x1, &err, dx, dy, ystep,
+                                 (steep ? _height : _width) - 1,
+                                 (steep ? _width : _height) - 1)) return ;
+
+#ifdef VGA_SCANLINE
+      // One span per run of pixels on a row
+      if (steep) {
+        for (; x0 <= x1; x0++) {
+          dlSpan(x0, y0, y0 + 1, color) ;
+          err -= dy;
+          if (err < 0) {
+            err += dx;
+            y0 += ystep;
+          }
+        }
+      } else {
+        short start = x0 ;
+        for (; x0 <= x1; x0++) {
+          err -= dy;
+          if ((err < 0) || (x0 == x1)) {
+            dlSpan(y0, start, x0 + 1, color) ;
+            start = x0 + 1 ;
+            err += dx;
+            y0 += ystep;
+          }
+        }
+      }
+#else
+      vga_unit c = color & 0x7 ;
+      vga_unit *p ;
+      int shift ;
+      short count = x1 - x0 + 1 ;
+
+      if (steep) {
+        // Major axis is screen y (one row of units),
+        // minor axis is screen x (move the field within the unit).
+        p = &draw_buffer[row_units*x0 + UNIT_INDEX(y0)] ;
+        shift = PIXEL_SHIFT(y0) ;
+        while (count--) {
+          *p = (*p & ~((vga_unit)0x7 << shift)) | (c << shift) ;
+          p += row_units ;
+          err -= dy;
+          if (err < 0) {
+            err += dx;
+            if (ystep > 0) {
+              shift += 3 ;
+              if (shift == UNIT_SHIFTS) { shift = 0 ; p++ ; }
+            } else {
+              if (shift == 0) { shift = UNIT_SHIFTS ; p-- ; }
+              shift -= 3 ;
+            }
+          }
+        }
+      } else {
+        // Major axis is screen x, minor axis is screen y
+        short rowstep = ystep * row_units ;
+        p = &draw_buffer[row_units*y0 + UNIT_INDEX(x0)] ;
+        shift = PIXEL_SHIFT(x0) ;
+        while (count--) {
+          *p = (*p & ~((vga_unit)0x7 << shift)) | (c << shift) ;
+          shift += 3 ;
+          if (shift == UNIT_SHIFTS) { shift = 0 ; p++ ; }
+          err -= dy;
+          if (err < 0) {
+            err += dx;
+            p += rowstep ;
+          }
+        }
+      }
+#endif
+}
+
+// Draw a rectangle
+void drawRect(short x, short y, short w, short h, char color) {
+/* Draw a rectangle outline with top left vertex (x,y), width w
+ * and height h at given color
+ * Parameters:
+ *      x:  x-coordinate of top-left vertex. The x-coordinate of
+ *          the top-left of the screen is 0. It increases to the right.
+ *      y:  y-coordinate of top-left vertex. The y-coordinate of
+ *          the top-left of the screen is 0. It increases to the bottom.
+ *      w:  width of the rectangle
+ *      h:  height of the rectangle
+ *      color:  16-bit color of the rectangle outline
+ * Returns: Nothing
+ */
+  drawHLine(x, y, w, color);
+  drawHLine(x, y+h-1, w, color);
+  drawVLine(x, y, h, color);
+  drawVLine(x+w-1, y, h, color);
+}
+
+void drawCircle(short x0, short y0, short r, char color) {
+/* Draw a circle outline with center (x0,y0) and radius r, with given color
+ * Parameters:
+ *      x0: x-coordinate of center of circle. The top-left of the screen
+ *          has x-coordinate 0 and increases to the right
+ *      y0: y-coordinate of center of circle. The top-left of the screen
+ *          has y-coordinate 0 and increases to the bottom
+ *      r:  radius of circle
+ *      color: 16-bit color value for the circle. Note that the circle
+ *          isn't filled. So, this is the color of the outline of the circle
+ * Returns: Nothing
+ */
+  short f = 1 - r;
+  short ddF_x = 1;
+  short ddF_y = -2 * r;
+  short x = 0;
+  short y = r;
+
+  drawPixel(x0  , y0+r, color);
+  drawPixel(x0  , y0-r, color);
+  drawPixel(x0+r, y0  , color);
+  drawPixel(x0-r, y0  , color);
+
+  while (x<y) {
+    if (f >= 0) {
+      y--;
+      ddF_y += 2;
+      f += ddF_y;
+    }
+    x++;
+    ddF_x += 2;
+    f += ddF_x;
+
+    drawPixel(x0 + x, y0 + y, color);
+    drawPixel(x0 - x, y0 + y, color);
+    drawPixel(x0 + x, y0 - y, color);
+    drawPixel(x0 - x, y0 - y, color);
+    drawPixel(x0 + y, y0 + x, color);
+    drawPixel(x0 - y, y0 + x, color);
+    drawPixel(x0 + y, y0 - x, color);
+    drawPixel(x0 - y, y0 - x, color);
+  }
+}
+
+void drawCircleHelper( short x0, short y0, short r, unsigned char cornername, char color) {
+// Helper function for drawing circles and circular objects
+  short f     = 1 - r;
+  short ddF_x = 1;
+  short ddF_y = -2 * r;
+  short x     = 0;
+  short y     = r;
+
+  while (x<y) {
+    if (f >= 0) {
+      y--;
+      ddF_y += 2;
+      f     += ddF_y;
+    }
+    x++;
+    ddF_x += 2;
+    f     += ddF_x;
+    if (cornername & 0x4) {
+      drawPixel(x0 + x, y0 + y, color);
+      drawPixel(x0 + y, y0 + x, color);
+    }
+    if (cornername & 0x2) {
+      drawPixel(x0 + x, y0 - y, color);
+      drawPixel(x0 + y, y0 - x, color);
+    }
+    if (cornername & 0x8) {
+      drawPixel(x0 - y, y0 + x, color);
+      drawPixel(x0 - x, y0 + y, color);
+    }
+    if (cornername & 0x1) {
+      drawPixel(x0 - y, y0 - x, color);
+      drawPixel(x0 - x, y0 - y, color);
+    }
+  }
+}
+
+void fillCircle(short x0, short y0, short r, char color) {
+/* Draw a filled circle with center (x0,y0) and radius r, with given color
+ * Parameters:
+ *      x0: x-coordinate of center of circle. The top-left of the screen
+ *          has x-coordinate 0 and increases to the right
+ *      y0: y-coordinate of center of circle. The top-left of the screen
+ *          has y-coordinate 0 and increases to the bottom
+ *      r:  radius of circle
+ *      color: 16-bit color value for the circle
+ * Returns: Nothing
+ */
+  drawVLine(x0, y0-r, 2*r+1, color);
+  fillCircleHelper(x0, y0, r, 3, 0, color);
+}
+
+void fillCircleHelper(short x0, short y0, short r, unsigned char cornername, short delta, char color) {
+// Helper function for drawing filled circles
+  short f     = 1 - r;
+  short ddF_x = 1;
+  short ddF_y = -2 * r;
+  short x     = 0;
+  short y     = r;
+
+  while (x<y) {
+    if (f >= 0) {
+      y--;
+      ddF_y += 2;
+      f     += ddF_y;
+    }
+    x++;
+    ddF_x += 2;
+    f     += ddF_x;
+
+    if (cornername & 0x1) {
+      drawVLine(x0+x, y0-y, 2*y+1+delta, color);
+      drawVLine(x0+y, y0-x, 2*x+1+delta, color);
+    }
+    if (cornername & 0x2) {
+      drawVLine(x0-x, y0-y, 2*y+1+delta, color);
+      drawVLine(x0-y, y0-x, 2*x+1+delta, color);
+    }
+  }
+}
+
+// Draw a rounded rectangle
+void drawRoundRect(short x, short y, short w, short h, short r, char color) {
+/* Draw a rounded rectangle outline with top left vertex (x,y), width w,
+ * height h and radius of curvature r at given color
+ * Parameters:
+ *      x:  x-coordinate of top-left vertex. The x-coordinate of
+ *          the top-left of the screen is 0. It increases to the right.
+ *      y:  y-coordinate of top-left vertex. The y-coordinate of
+ *          the top-left of the screen is 0. It increases to the bottom.
+ *      w:  width of the rectangle
+ *      h:  height of the rectangle
+ *      color:  16-bit color of the rectangle outline
+ * Returns: Nothing
+ */
+  // smarter version
+  drawHLine(x+r  , y    , w-2*r, color); // Top
+  drawHLine(x+r  , y+h-1, w-2*r, color); // Bottom
+  drawVLine(x    , y+r  , h-2*r, color); // Left
+  drawVLine(x+w-1, y+r  , h-2*r, color); // Right
+  // draw four corners
+  drawCircleHelper(x+r    , y+r    , r, 1, color);
+  drawCircleHelper(x+w-r-1, y+r    , r, 2, color);
+  drawCircleHelper(x+w-r-1, y+h-r-1, r, 4, color);
+  drawCircleHelper(x+r    , y+h-r-1, r, 8, color);
+}
+
+// Fill a rounded rectangle
+void fillRoundRect(short x, short y, short w, short h, short r, char color) {
+  // smarter version
+  fillRect(x+r, y, w-2*r, h, color);
+
+  // draw four corners
+  fillCircleHelper(x+w-r-1, y+r, r, 1, h-2*r-1, color);
+  fillCircleHelper(x+r    , y+r, r, 2, h-2*r-1, color);
+}
+
+
+// fill a rectangle
+void fillRect(short x, short y, short w, short h, char color) {
+/* Draw a filled rectangle with starting top-left vertex (x,y),
+ *  width w and height h with given color
+ * Parameters:
+ *      x:  x-coordinate of top-left vertex; top left of screen is x=0
+ *              and x increases to the right
+ *      y:  y-coordinate of top-left vertex; top left of screen is y=0
+ *              and y increases to the bottom
+ *      w:  width of rectangle
+ *      h:  height of rectangle
+ *      color:  3-bit color value
+ * Returns:     Nothing
+ */
+
+  draw_calls++ ;
+
+  // Clip once against the screen. x1/y1 are exclusive.
+  int x0 = x, y0 = y, x1 = x + w, y1 = y + h ;
+  if (x0 < 0) x0 = 0 ;
+  if (y0 < 0) y0 = 0 ;
+  if (x1 > _width) x1 = _width ;
+  if (y1 > _height) y1 = _height ;
+  if ((x0 >= x1) || (y0 >= y1)) return ;
+
+#ifdef VGA_SCANLINE
+  // A fill across whole rows hides everything filed on them so far: start
+  // those rows over, and leave them empty (black) for a black fill.
+  // Clearing the whole screen empties the list.
+  if ((x0 == 0) && (x1 == _width)) {
+    if ((y0 == 0) && (y1 == _height)) dlReset(build_list) ;
+    for (int j=y0; j<y1; j++) {
+      build_list->head[j] = DL_END ;
+      if ((color & 0x7) != BLACK) dlSpan(j, x0, x1, color) ;
+    }
+    return ;
+  }
+  for (int j=y0; j<y1; j++) {
+    dlSpan(j, x0, x1, color) ;
+  }
+#else
+  // Color replicated into every pixel of a unit
+  vga_unit fill = FILL(color) ;
+
+  // Full-width rectangles are one contiguous block of the array
+  if ((x0 == 0) && (x1 == _width)) {
+    fillUnits(&draw_buffer[row_units*y0], fill, row_units*(y1 - y0)) ;
+    return ;
+  }
+
+  vga_unit *row = &draw_buffer[row_units*y0] ;
+  for (int j=y0; j<y1; j++, row += row_units) {
+    fillSpan(row, x0, x1, fill) ;
+  }
+#endif
+}
+
+// Draw a character
+#ifndef VGA_SCANLINE
+// Copy pixels [x0, x1) of a row from src, whose first unit lines up with
+// the unit holding x0. The partial units at either end are masked in.
+static inline void copySpan(vga_unit *row, const vga_unit *src, int x0, int x1) {
+  int u0 = UNIT_INDEX(x0), u1 = UNIT_INDEX(x1) ;
+  int s0 = PIXEL_SHIFT(x0), s1 = PIXEL_SHIFT(x1) ;
+  vga_unit head = (vga_unit)(~0u << s0) ;
+  vga_unit tail = (vga_unit)((1u << s1) - 1) ;
+  if (u0 == u1) {
+    row[u0] = (row[u0] & ~(head & tail)) | (src[0] & head & tail) ;
+    return ;
+  }
+  row[u0] = (row[u0] & ~head) | (src[0] & head) ;
+  if (s1) {
+    row[u1] = (row[u1] & ~tail) | (src[u1 - u0] & tail) ;
+  }
+  if (u1 - u0 > 1) memcpy(&row[u0 + 1], &src[1], (u1 - u0 - 1)*sizeof(vga_unit)) ;
+}
+
+// Find (or build) the cached rows of a character. Returns 0 if it
+// can't be cached.
+static const struct glyph_entry *glyphLookup(unsigned char c, char color, char bg, unsigned char size, int phase) {
+  unsigned int key = c | (size << 8) | ((color & 0x7) << 16) | ((bg & 0x7) << 19) | (phase << 22) ;
+  for (int k=0; k<glyph_count; k++) {
+    if (glyph_table[k].key == key) {
+      glyph_stats.hits++ ;
+      return &glyph_table[k] ;
+    }
+  }
+  glyph_stats.misses++ ;
+
+  int w = 6 * size ;
+  int units = UNIT_INDEX(phase + w - 1) + 1 ;
+  if (8 * units > GLYPH_POOL_UNITS) return 0 ;
+  if ((glyph_count == GLYPH_CACHE_ENTRIES) || (glyph_pool_used + 8 * units > GLYPH_POOL_UNITS)) {
+    glyph_count = 0 ;
+    glyph_pool_used = 0 ;
+    glyph_stats.flushes++ ;
+  }
+
+  struct glyph_entry *g = &glyph_table[glyph_count++] ;
+  g->key = key ;
+  g->offset = glyph_pool_used ;
+  g->units = units ;
+  glyph_pool_used += 8 * units ;
+
+  // Expand each font row: bit j of column i is pixel row j
+  vga_unit *row = &glyph_pool[g->offset] ;
+  for (int j=0; j<8; j++, row += units) {
+    fillUnits(row, FILL(bg), units) ;
+    for (int i=0; i<5; i++) {
+      if ((pgm_read_byte(font+(c*5)+i) >> j) & 0x1) {
+        fillSpan(row, phase + i*size, phase + (i+1)*size, FILL(color)) ;
+      }
+    }
+  }
+  return g ;
+}
+
+const struct glyph_stats *getGlyphStats() {
+  return &glyph_stats ;
+}
+#endif
+
+void drawChar(short x, short y, unsigned char c, char color, char bg, unsigned char size) {
+    char i, j;
+    draw_calls++ ;
+  if((x >= _width)            || // Clip right
+     (y >= _height)           || // Clip bottom
+     ((x + 6 * size - 1) < 0) || // Clip left
+     ((y + 8 * size - 1) < 0))   // Clip top
+    return;
+
+#ifdef VGA_SCANLINE
+  // One display list entry per screen row
+  for (j=0; j<8; j++) {
+    unsigned char bits = 0 ;
+    for (i=0; i<5; i++) bits |= ((pgm_read_byte(font+(c*5)+i) >> j) & 1) << i ;
+    for (int k=0; k<size; k++) {
+      short row = y + j*size + k ;
+      if ((row >= 0) && (row < _height)) dlGlyph(row, x, size, color, bg, bits) ;
+    }
+  }
+  return ;
+#else
+  // Opaque, fully on-screen characters come from the glyph cache
+  if ((bg != color) && (x >= 0) && (y >= 0) && (x + 6 * size <= _width) && (y + 8 * size <= _height)) {
+    int phase = x % PIXELS_PER_UNIT ;
+    const struct glyph_entry *g = glyphLookup(c, color, bg, size, phase) ;
+    if (g) {
+      const vga_unit *src = &glyph_pool[g->offset] ;
+      vga_unit *dst = &draw_buffer[row_units*y] ;
+      for (j=0; j<8; j++, src += g->units) {
+        for (int k=0; k<size; k++, dst += row_units) {
+          copySpan(dst, src, x, x + 6 * size) ;
+        }
+      }
+      return ;
+    }
+  }
+#endif
+
+  for (i=0; i<6; i++ ) {
+    unsigned char line;
+    if (i == 5)
+      line = 0x0;
+    else
+      line = pgm_read_byte(font+(c*5)+i);
+    for ( j = 0; j<8; j++) {
+      if (line & 0x1) {
+        if (size == 1) // default size
+          drawPixel(x+i, y+j, color);
+        else {  // big size
+          fillRect(x+(i*size), y+(j*size), size, size, color);
+        }
+      } else if (bg != color) {
+        if (size == 1) // default size
+          drawPixel(x+i, y+j, bg);
+        else {  // big size
+          fillRect(x+i*size, y+j*size, size, size, bg);
+        }
+      }
+      line >>= 1;
+    }
+  }
+}
+
+
+inline void setCursor(short x, short y) {
+/* Set cursor for text to be printed
+ * Parameters:
+ *      x = x-coordinate of top-left of text starting
+ *      y = y-coordinate of top-left of text starting
+ * Returns: Nothing
+ */
+  cursor_x = x;
+  cursor_y = y;
+}
+
+inline void setTextSize(unsigned char s) {
+/*Set size of text to be displayed
+ * Parameters:
+ *      s = text size (1 being smallest)
+ * Returns: nothing
+ */
+  textsize = (s > 0) ? s : 1;
+}
+
+inline void setTextColor(char c) {
+  // For 'transparent' background, we'll set the bg
+  // to the same as fg instead of using a flag
+  textcolor = textbgcolor = c;
+}
+
+inline void setTextColor2(char c, char b) {
+/* Set color of text to be displayed
+ * Parameters:
+ *      c = 16-bit color of text
+ *      b = 16-bit color of text background
+ */
+  textcolor   = c;
+  textbgcolor = b;
+}
+
+inline void setTextWrap(char w) {
+  wrap = w;
+}
+
+
+void tft_write(unsigned char c){
+  if (c == '\n') {
+    cursor_y += textsize*8;
+    cursor_x  = 0;
+  } else if (c == '\r') {
+    // skip em
+  } else if (c == '\t'){
+      int new_x = cursor_x + tabspace;
+      if (new_x < _width){
+          cursor_x = new_x;
+      }
+  } else {
+    drawChar(cursor_x, cursor_y, c, textcolor, textbgcolor, textsize);
+    cursor_x += textsize*6;
+    if (wrap && (cursor_x > (_width - textsize*6))) {
+      cursor_y += textsize*8;
+      cursor_x = 0;
+    }
+  }
+}
+
+inline void writeString(char* str){
+/* Print text onto screen
+ * Call tft_setCursor(), tft_setTextColor(), tft_setTextSize()
+ *  as necessary before printing
+ */
+    while (*str){
+        tft_write(*str++);
+    }
+}
+
+
+// Color of one on-screen pixel
+static inline char readPixel(short x, short y) {
+#ifdef VGA_SCANLINE
+  // The last entry on the row that covers x wins
+  char color = BLACK ;
+  for (unsigned short i = build_list->head[y]; i != DL_END; i = build_list->spans[i].next) {
+    const struct dl_span *s = &build_list->spans[i] ;
+    if (s->kind == DL_SPRITE) {
+      const struct sprite_run *r = &sprite_pool[s->x1] ;
+      for (int n = (unsigned char)s->color >> 3; n > 0; n--, r++) {
+        if ((x >= s->x0 + r->x) && (x < s->x0 + r->x + r->len)) color = s->color & 0x7 ;
+      }
+      continue ;
+    }
+    if ((x < s->x0) || (x >= s->x1)) continue ;
+    if (s->kind == DL_SPAN) {
+      color = s->color ;
+    } else if ((s->kind >> ((x - s->x0) / ((s->x1 - s->x0) / 6))) & 1) {
+      color = s->color & 0x7 ;
+    } else if (((s->color >> 3) & 0x7) != (s->color & 0x7)) {
+      color = (s->color >> 3) & 0x7 ;
+    }
+  }
+  return color ;
+#else
+  return (draw_buffer[row_units*y + UNIT_INDEX(x)] >> PIXEL_SHIFT(x)) & 0x7 ;
+#endif
+}
+
+char captureSprite(sprite *s, short x, short y, short w, short h) {
+/* Capture the non-black pixels of an on-screen box as a sprite
+ * Parameters:
+ *      s:  sprite to fill in
+ *      x:  x-coordinate of top-left of the box
+ *      y:  y-coordinate of top-left of the box
+ *      w:  width of the box (at most 255)
+ *      h:  height of the box (at most 255)
+ * Returns: 1 on success, 0 if the box is off-screen or too big, or the
+ *          sprite pool is full
+ */
+  if ((x < 0) || (y < 0) || (x + w > _width) || (y + h > _height)) return 0 ;
+  if ((w > 255) || (h > 255)) return 0 ;
+
+  struct sprite_run *runs = &sprite_pool[sprite_pool_used] ;
+  int count = 0 ;
+  short x0 = w, y0 = h, x1 = 0, y1 = 0 ;
+  for (short j=0; j<h; j++) {
+    short i = 0 ;
+    while (i < w) {
+      if (readPixel(x+i, y+j) == BLACK) {
+        i++ ;
+        continue ;
+      }
+      short start = i ;
+      while ((i < w) && (readPixel(x+i, y+j) != BLACK)) i++ ;
+      if (sprite_pool_used + count >= SPRITE_POOL_RUNS) return 0 ;
+      runs[count].x = start ;
+      runs[count].y = j ;
+      runs[count].len = i - start ;
+      count++ ;
+      if (start < x0) x0 = start ;
+      if (i > x1) x1 = i ;
+      if (j < y0) y0 = j ;
+      y1 = j + 1 ;
+    }
+  }
+
+  sprite_pool_used += count ;
+  s->w = w ;
+  s->h = h ;
+  s->count = count ;
+  s->runs = runs ;
+  s->bx = count ? x0 : 0 ;
+  s->by = count ? y0 : 0 ;
+  s->bw = count ? (x1 - x0) : 0 ;
+  s->bh = count ? (y1 - y0) : 0 ;
+  return 1 ;
+}
+
+void blitSprite(const sprite *s, short x, short y, char color) {
+/* Draw a captured sprite with its top-left at (x,y) in the given color.
+ * Transparent pixels are left alone. Sprites that are fully on-screen
+ * skip clipping and go straight to the span filler.
+ */
+  const struct sprite_run *r = s->runs ;
+  const struct sprite_run *end = r + s->count ;
+  draw_calls++ ;
+
+#ifdef VGA_SCANLINE
+  // Sprites from the pool go in a row of runs at a time
+  if ((r >= sprite_pool) && (end <= sprite_pool + SPRITE_POOL_RUNS)) {
+    if ((x >= _width) || (x + s->w <= 0)) return ;
+    while (r < end) {
+      const struct sprite_run *row = r ;
+      while ((r < end) && (r->y == row->y) && (r - row < DL_SPRITE_RUNS)) r++ ;
+      short yy = y + row->y ;
+      if ((yy >= 0) && (yy < _height)) dlSprite(yy, x, row - sprite_pool, r - row, color) ;
+    }
+    return ;
+  }
+#endif
+
+  if ((x >= 0) && (y >= 0) && (x + s->w <= _width) && (y + s->h <= _height)) {
+    for (; r < end; r++) {
+      fillRow(y + r->y, x + r->x, x + r->x + r->len, color) ;
+    }
+  } else {
+    for (; r < end; r++) {
+      drawHLine(x + r->x, y + r->y, r->len, color) ;
+    }
+  }
+}
+
+
+// Dirty-rectangle compositor. Moving objects mark the area they used to
+// cover, clearDirty() merges the marks and blanks them in one pass, and
+// then anything that overlaps a cleared area (isDirty) gets redrawn.
+
+static inline char rectsOverlap(const struct vga_rect *a, const struct vga_rect *b) {
+  return (a->x < b->x + b->w) && (b->x < a->x + a->w) &&
+         (a->y < b->y + b->h) && (b->y < a->y + a->h) ;
+}
+
+static inline void rectUnion(struct vga_rect *a, const struct vga_rect *b) {
+  short x1 = (a->x + a->w > b->x + b->w) ? a->x + a->w : b->x + b->w ;
+  short y1 = (a->y + a->h > b->y + b->h) ? a->y + a->h : b->y + b->h ;
+  if (b->x < a->x) a->x = b->x ;
+  if (b->y < a->y) a->y = b->y ;
+  a->w = x1 - a->x ;
+  a->h = y1 - a->y ;
+}
+
+void markDirty(short x, short y, short w, short h) {
+/* Queue a screen area for the next clearDirty()
+ * Parameters:
+ *      x, y:  top-left of the area
+ *      w, h:  size of the area
+ * Returns: Nothing
+ */
+  if (dirty_cleared) {
+    dirty_count = 0 ;
+    dirty_cleared = 0 ;
+  }
+
+  // Clip to the screen
+  struct vga_rect r ;
+  short x1 = x + w, y1 = y + h ;
+  if (x < 0) x = 0 ;
+  if (y < 0) y = 0 ;
+  if (x1 > _width) x1 = _width ;
+  if (y1 > _height) y1 = _height ;
+  if ((x >= x1) || (y >= y1)) return ;
+  r.x = x ; r.y = y ; r.w = x1 - x ; r.h = y1 - y ;
+
+  // Out of slots, so grow the last one instead
+  if (dirty_count == MAX_DIRTY) {
+    rectUnion(&dirty_list[MAX_DIRTY-1], &r) ;
+    return ;
+  }
+  dirty_list[dirty_count++] = r ;
+}
+
+int clearDirty(char color) {
+/* Merge overlapping dirty areas and fill them with the given color
+ * Returns: number of pixels cleared
+ */
+  // Replace any two overlapping rectangles by their union until none overlap
+  int i = 0 ;
+  while (i < dirty_count) {
+    int merged = 0 ;
+    for (int j=i+1; j<dirty_count; j++) {
+      if (rectsOverlap(&dirty_list[i], &dirty_list[j])) {
+        rectUnion(&dirty_list[i], &dirty_list[j]) ;
+        dirty_list[j] = dirty_list[--dirty_count] ;
+        merged = 1 ;
+        break ;
+      }
+    }
+    if (!merged) i++ ;
+    else i = 0 ;
+  }
+
+  unsigned int pixels = 0 ;
+  for (i=0; i<dirty_count; i++) {
+    fillRect(dirty_list[i].x, dirty_list[i].y, dirty_list[i].w, dirty_list[i].h, color) ;
+    pixels += dirty_list[i].w * dirty_list[i].h ;
+  }
+  dirty_cleared = 1 ;
+
+  dirty_stats.last_pixels = pixels ;
+  dirty_stats.last_rects = dirty_count ;
+  if (pixels > dirty_stats.max_pixels) dirty_stats.max_pixels = pixels ;
+  dirty_stats.frames++ ;
+  dirty_stats.total_pixels += pixels ;
+  return pixels ;
+}
+
+char isDirty(short x, short y, short w, short h) {
+/* Does this area overlap anything the last clearDirty() blanked? */
+  struct vga_rect r = {x, y, w, h} ;
+  if (!dirty_cleared) return 0 ;
+  for (int i=0; i<dirty_count; i++) {
+    if (rectsOverlap(&r, &dirty_list[i])) return 1 ;
+  }
+  return 0 ;
+}
+
+int getDirtyRects(const struct vga_rect **rects) {
+/* The rectangles blanked by the last clearDirty(), for callers that want
+ * to repaint background only inside them
+ */
+  *rects = dirty_list ;
+  return dirty_cleared ? dirty_count : 0 ;
+}
+
+const struct dirty_stats *getDirtyStats(void) {
+  return &dirty_stats ;
+}
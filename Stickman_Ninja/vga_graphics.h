@@ -1,52 +1,137 @@
-/**
- * Hunter Adams (vha3@cornell.edu)
- * 
- *
- * HARDWARE CONNECTIONS
- *  - GPIO 16 ---> VGA Hsync
- *  - GPIO 17 ---> VGA Vsync
- *  - GPIO 18 ---> 330 ohm resistor ---> VGA Red
- *  - GPIO 19 ---> 330 ohm resistor ---> VGA Green
- *  - GPIO 20 ---> 330 ohm resistor ---> VGA Blue
- *  - RP2040 GND ---> VGA GND
- *
- * RESOURCES USED
- *  - PIO state machines 0, 1, and 2 on PIO instance 0
- *  - DMA channels 0, 1, 2, and 3
- *  - 153.6 kBytes of RAM (for pixel color data)
- *
- * NOTE
- *  - This is a translation of the display primitives
- *    for the PIC32 written by Bruce Land and students
- *
- */
-
-
-// Give the I/O pins that we're using some names that make sense - usable in main()
-enum vga_pins {HSYNC=16, VSYNC, RED_PIN, GREEN_PIN, BLUE_PIN} ;
-
-// We can only produce 8 (3-bit) colors, so let's give them readable names - usable in main()
-enum colors {BLACK, RED, GREEN, YELLOW, BLUE, MAGENTA, CYAN, WHITE} ;
-
-// VGA primitives - usable in main
-void initVGA(void) ;
-void drawPixel(short x, short y, char color) ;
-void drawVLine(short x, short y, short h, char color) ;
-void drawHLine(short x, short y, short w, char color) ;
-void drawLine(short x0, short y0, short x1, short y1, char color) ;
-void drawRect(short x, short y, short w, short h, char color);
-void drawCircle(short x0, short y0, short r, char color) ;
-void drawCircleHelper( short x0, short y0, short r, unsigned char cornername, char color) ;
-void fillCircle(short x0, short y0, short r, char color) ;
-void fillCircleHelper(short x0, short y0, short r, unsigned char cornername, short delta, char color) ;
-void drawRoundRect(short x, short y, short w, short h, short r, char color) ;
-void fillRoundRect(short x, short y, short w, short h, short r, char color) ;
-void fillRect(short x, short y, short w, short h, char color) ;
-void drawChar(short x, short y, unsigned char c, char color, char bg, unsigned char size) ;
-void setCursor(short x, short y);
-void setTextColor(char c);
-void setTextColor2(char c, char bg);
-void setTextSize(unsigned char s);
-void setTextWrap(char w);
-void tft_write(unsigned char c) ;
-void writeString(char* str) ;
\ No newline at end of file
+/**
+ * Hunter Adams (vha3@cornell.edu)
+ * 
+ *
+ * HARDWARE CONNECTIONS
+ *  - GPIO 16 ---> VGA Hsync
+ *  - GPIO 17 ---> VGA Vsync
+ *  - GPIO 18 ---> 330 ohm resistor ---> VGA Red
+ *  - GPIO 19 ---> 330 ohm resistor ---> VGA Green
+ *  - GPIO 20 ---> 330 ohm resistor ---> VGA Blue
+ *  - RP2040 GND ---> VGA GND
+ *
+ * RESOURCES USED
+ *  - PIO state machines 0, 1, and 2 on PIO instance 0
+ *  - DMA channels 0, 1, 2, and 3
+ *  - PIO0_IRQ_0 (vertical blank, from irq flag 2 of the vsync machine)
+ *  - DMA_IRQ_0 (320x240 mode and VGA_SCANLINE only, once per line)
+ *  - 153.6 kBytes of RAM (for pixel color data), or 122.88 kBytes
+ *    with VGA_PACKED, or ~38 kBytes of display lists with VGA_SCANLINE
+ *
+ * NOTE
+ *  - This is a translation of the display primitives
+ *    for the PIC32 written by Bruce Land and students
+ *
+ */
+
+
+// Framebuffer format. By default each byte of the framebuffer holds 2 pixels.
+// Define VGA_PACKED (here, or with target_compile_definitions in CMake) to
+// pack 10 pixels into each 32-bit word instead, which frees 30 kBytes.
+// #define VGA_PACKED
+
+// Display backend. By default the primitives draw into a framebuffer. Define
+// VGA_SCANLINE to keep a display list of spans instead, painted one line at
+// a time just ahead of the beam. Draw a whole frame, then vga_flip() it.
+// Only 640x480; sprites and dirty rectangles work, sprite capture reads back
+// from the display list being built.
+// #define VGA_SCANLINE
+
+// Display modes for initVGAMode. 320x240 doubles every pixel and keeps two
+// pages in the same memory, so a frame can be drawn off-screen and flipped in.
+enum vga_modes {VGA_640x480, VGA_320x240} ;
+
+// Give the I/O pins that we're using some names that make sense - usable in main()
+enum vga_pins {HSYNC=16, VSYNC, RED_PIN, GREEN_PIN, BLUE_PIN} ;
+
+// We can only produce 8 (3-bit) colors, so let's give them readable names - usable in main()
+enum colors {BLACK, RED, GREEN, YELLOW, BLUE, MAGENTA, CYAN, WHITE} ;
+
+// A sprite is stored as the list of its opaque horizontal runs, relative
+// to the top-left of the box it was captured from. Blitting it is a few
+// span fills, in whatever color the caller asks for.
+struct sprite_run {
+    unsigned char x, y, len ;
+} ;
+typedef struct {
+    short w, h ;                    // size of the captured box (max 255x255)
+    short bx, by, bw, bh ;          // bounds of the opaque pixels inside the box
+    unsigned short count ;          // number of runs
+    const struct sprite_run *runs ; // runs, in row order
+} sprite ;
+
+// Screen rectangle, used by the dirty-rectangle compositor
+struct vga_rect {
+    short x, y, w, h ;
+} ;
+
+// Dirty-rectangle bookkeeping, readable to see what clearing costs
+struct dirty_stats {
+    unsigned int last_pixels ;      // pixels cleared by the last clearDirty()
+    unsigned int last_rects ;       // rectangles left after merging, last clearDirty()
+    unsigned int max_pixels ;       // worst frame so far
+    unsigned int frames ;           // number of clearDirty() calls
+    unsigned long long total_pixels ;
+} ;
+
+// Glyph cache counters (framebuffer backends)
+struct glyph_stats {
+    unsigned int hits ;             // characters drawn from the cache
+    unsigned int misses ;           // characters expanded into the cache
+    unsigned int flushes ;          // times the cache filled up and was dropped
+} ;
+
+// Scanline backend timing, readable to check the renderer keeps up
+struct scanline_stats {
+    unsigned int last_usec ;        // time to paint the last line
+    unsigned int max_usec ;         // worst line so far
+    unsigned int late_lines ;       // lines that took more than one line time
+    unsigned int max_spans ;        // biggest display list shown
+    unsigned int max_line_spans ;   // most entries painted into one line
+    unsigned int dropped_spans ;    // spans lost to a full display list
+} ;
+
+// VGA primitives - usable in main
+void initVGA(void) ;
+void initVGAMode(char mode) ;
+void vga_flip(void) ;
+char vga_flip_pending(void) ;
+unsigned int vga_frame_count(void) ;
+void vga_set_vblank_callback(void (*callback)(void)) ;
+unsigned int vga_draw_calls(void) ;
+void vga_wait_vblank(void) ;
+int vga_vblank_usec_left(void) ;
+void drawPixel(short x, short y, char color) ;
+void drawVLine(short x, short y, short h, char color) ;
+void drawHLine(short x, short y, short w, char color) ;
+void drawVLine_fast(short x, short y, short h, char color) ;
+void drawHLine_fast(short x, short y, short w, char color) ;
+void drawLine(short x0, short y0, short x1, short y1, char color) ;
+void drawRect(short x, short y, short w, short h, char color);
+void drawCircle(short x0, short y0, short r, char color) ;
+void drawCircleHelper( short x0, short y0, short r, unsigned char cornername, char color) ;
+void fillCircle(short x0, short y0, short r, char color) ;
+void fillCircleHelper(short x0, short y0, short r, unsigned char cornername, short delta, char color) ;
+void drawRoundRect(short x, short y, short w, short h, short r, char color) ;
+void fillRoundRect(short x, short y, short w, short h, short r, char color) ;
+void fillRect(short x, short y, short w, short h, char color) ;
+void drawChar(short x, short y, unsigned char c, char color, char bg, unsigned char size) ;
+void setCursor(short x, short y);
+void setTextColor(char c);
+void setTextColor2(char c, char bg);
+void setTextSize(unsigned char s);
+void setTextWrap(char w);
+void tft_write(unsigned char c) ;
+void writeString(char* str) ;
+char captureSprite(sprite *s, short x, short y, short w, short h) ;
+void blitSprite(const sprite *s, short x, short y, char color) ;
+void markDirty(short x, short y, short w, short h) ;
+int clearDirty(char color) ;
+char isDirty(short x, short y, short w, short h) ;
+int getDirtyRects(const struct vga_rect **rects) ;
+const struct dirty_stats *getDirtyStats(void) ;
+#ifdef VGA_SCANLINE
+const struct scanline_stats *getScanlineStats(void) ;
+#else
+const struct glyph_stats *getGlyphStats(void) ;
+#endif
\ No newline at end of file